@@ -16,6 +16,8 @@ NPX.h
     extras such as static converters 
 NPFold.h
     managing and persisting collections of arrays 
+NPWriter.h
+    streaming items into a growing .npy file 
 
 
 Primary source is https://github.com/simoncblyth/np/
@@ -36,6 +38,10 @@ but the headers are also copied into opticks/sysrap.
 #include <map>
 #include <functional>
 #include <locale>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "NPU.hh"
 
@@ -72,6 +78,17 @@ struct NP
     template<typename T> void fill(T value); 
     template<typename T> void _fillIndexFlat(T offset=0); 
 
+    // NUMA placement of large payloads, see NP::MakeNUMA 
+    static constexpr const int NUMA_FIRST_TOUCH = 0 ; 
+    static constexpr const int NUMA_INTERLEAVE = 1 ; 
+    template<typename T> static NP* MakeNUMA(int policy, const std::vector<int>& shape, int num_threads=0 ); 
+    template<typename F> void for_each_item_range(F fn, int num_threads=0) const ; 
+    template<typename T> void fill_parallel(T value, int num_threads=0); 
+    template<typename T> void _fillIndexFlat_parallel(T offset=0, int num_threads=0); 
+    template<typename T> void read_parallel(const T* src, int num_threads=0); 
+    int interleave(); 
+    static uint64_t NUMANodeMask(); 
+
     // BLOCK OF TEMPLATE SPECIALIZATIONS cvalues, values, _fillIndexFlat : IN IMPL BELOW AT THIS POINT
 
 
@@ -89,6 +106,7 @@ struct NP
     template<typename T> static NP* MakeDiv( const NP* src, unsigned mul  ); 
 
     template<typename T> static NP* Make( int ni_=-1, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1 );
+    template<typename T> static NP* MakeUninitialized( int ni_=-1, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1 );
     template<typename T, typename ... Args> static NP*  Make_( Args ... shape ) ;  // Make_shape
     template<typename T> static NP* MakeFlat(int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ); 
 
@@ -100,10 +118,10 @@ struct NP
 
     unsigned hdr_bytes() const ;  
     unsigned num_items() const ;       // shape[0] 
-    unsigned num_values() const ;      // all values, product of shape[0]*shape[1]*...
-    unsigned num_itemvalues() const ;  // values after first dimension 
-    unsigned arr_bytes() const ;       // formerly num_bytes
-    unsigned item_bytes() const ;      // *item* comprises all dimensions beyond the first 
+    size_t   num_values() const ;      // all values, product of shape[0]*shape[1]*...
+    size_t   num_itemvalues() const ;  // values after first dimension 
+    size_t   arr_bytes() const ;       // formerly num_bytes
+    size_t   item_bytes() const ;      // *item* comprises all dimensions beyond the first 
     unsigned meta_bytes() const ;
 
     template<typename T> bool is_itemtype() const ;  // size of item matches size of type
@@ -124,10 +142,15 @@ struct NP
     // CTOR
     NP(const char* dtype_, const std::vector<int>& shape_ ); 
     NP(const char* dtype_="<f4", int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ); 
+    NP(const NP& other);              // mapped payloads are copied into data, see NP::load_mapped
+    NP& operator=(const NP& other); 
+    NP(NP&& other); 
+    NP& operator=(NP&& other); 
 
-    void init(); 
+    void init(bool zero=true); 
+    void set_align(size_t align); 
     void set_shape( int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1);  
-    void set_shape( const std::vector<int>& src_shape ); 
+    void set_shape( const std::vector<int>& src_shape, bool zero=true ); 
     // CAUTION: DO NOT USE *set_shape* TO CHANGE SHAPE (as it calls *init*) INSTEAD USE *change_shape* 
     bool has_shape(int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) const ;  
     void change_shape(int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) ;   // one dimension entry left at -1 can be auto-set
@@ -140,19 +163,19 @@ struct NP
     void set_dtype(const char* dtype_); // *set_dtype* may change shape and size of array while retaining the same underlying bytes 
 
 
-    unsigned  index(  int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
-    unsigned  index0( int i,  int j=-1,  int k=-1,  int l=-1, int m=-1, int o=-1) const ; 
+    size_t  index(  int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
+    size_t  index0( int i,  int j=-1,  int k=-1,  int l=-1, int m=-1, int o=-1) const ; 
 
-    unsigned dimprod(unsigned q) const ;    // product of dimensions starting from dimension q
+    size_t dimprod(unsigned q) const ;    // product of dimensions starting from dimension q
 
     template<typename... Args> 
-    unsigned index_(Args ... idxx ) const ; 
+    size_t index_(Args ... idxx ) const ; 
 
     template<typename... Args> 
-    unsigned stride_(Args ... idxx ) const ; 
+    size_t stride_(Args ... idxx ) const ; 
 
     template<typename... Args> 
-    unsigned offset_(Args ... idxx ) const ; 
+    size_t offset_(Args ... idxx ) const ; 
 
 
     template<typename T>
@@ -182,18 +205,22 @@ struct NP
 
     int pickdim__(    const std::vector<int>& idxx) const ; 
 
-    unsigned index__( const std::vector<int>& idxx) const ; 
-    unsigned stride__(const std::vector<int>& idxx) const ; 
-    unsigned offset__(const std::vector<int>& idxx) const ; 
+    size_t index__( const std::vector<int>& idxx) const ; 
+    size_t stride__(const std::vector<int>& idxx) const ; 
+    size_t offset__(const std::vector<int>& idxx) const ; 
 
 
 
-    unsigned  itemsize_(int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1) const ; 
-    void      itembytes_(const char** start,  unsigned& num_bytes, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 ) const  ; 
+    size_t    itemsize_(int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1) const ; 
+    void      itembytes_(const char** start,  size_t& num_bytes, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 ) const  ; 
 
     template<typename T> T           get( int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0) const ; 
     template<typename T> void        set( T val, int i,  int j=0,  int k=0,  int l=0, int m=0, int o=0 ) ; 
 
+    template<typename T, int N> bool               is_array() const ;   // dtype and rank check for array/carray
+    template<typename T, int N> NPArray<T,N>       array() ; 
+    template<typename T, int N> NPArray<const T,N> carray() const ; 
+
     template<typename T> bool is_allzero() const ; 
     bool is_empty() const ; 
 
@@ -217,7 +244,7 @@ struct NP
        ) const ; 
 
     static NP* MakeLike(  const NP* src);  
-    static void CopyMeta( NP* b, const NP* a ); 
+    static void CopyMeta( NP* b, const NP* a, bool zero=true ); 
 
     static constexpr const char* Preserve_Last_Column_Integer_Annotation = "Preserve_Last_Column_Integer_Annotation" ; 
     void set_preserve_last_column_integer_annotation(); 
@@ -226,8 +253,8 @@ struct NP
 
     // STATIC CONVERSION METHODS 
 
-    static NP* MakeNarrow(const NP* src); 
-    static NP* MakeWide(  const NP* src); 
+    static NP* MakeNarrow(const NP* src, int num_threads=0); 
+    static NP* MakeWide(  const NP* src, int num_threads=0); 
     static NP* MakeCopy(  const NP* src); 
     static NP* MakeCopy3D(const NP* src); 
     static NP* ChangeShape3D(NP* src); 
@@ -253,16 +280,23 @@ struct NP
     NP*   spawn_item(  int i, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1  ) const ; 
 
     template<typename T> static NP* MakeCDF(  const NP* src );
-    template<typename T> static NP* MakeICDF(  const NP* src, unsigned nu, unsigned hd_factor, bool dump );
+    template<typename T> static NP* MakeICDF(  const NP* src, unsigned nu, unsigned hd_factor, bool dump=false, int num_threads=0 );
+    template<typename T, typename F> static bool PDomainAscending(const T* vv, unsigned ni, unsigned nj, unsigned nq, F yq, T* xq, unsigned xq_stride ); 
     template<typename T> static NP* MakeProperty(const NP* a, unsigned hd_factor ); 
-    template<typename T> static NP* MakeLookupSample(const NP* icdf_prop, unsigned ni, unsigned seed=0u, unsigned hd_factor=0u );  
-    template<typename T> static NP* MakeUniform( unsigned ni, unsigned seed=0u );  
+    template<typename T> static NP* MakeLookupSample(const NP* icdf_prop, unsigned ni, unsigned seed=0u, unsigned hd_factor=0u, int num_threads=0 );  
+    template<typename T> static NP* MakeUniform( unsigned ni, unsigned seed=0u, int num_threads=0 );  
  
     NP* copy() const ; 
 
     template<typename S>                               int         count_if( std::function<bool(const S*)>) const ; 
     template<typename T>                               NP*   simple_copy_if( std::function<bool(const T*)>) const ;  // atomic types only
     template<typename T, typename S>                   NP*          copy_if( std::function<bool(const S*)>) const ; 
+
+    template<typename S, typename P>                   int64_t     count_if( P predicate, int num_threads=1 ) const ; 
+    template<typename T, typename P>                   NP*   simple_copy_if( P predicate, int num_threads=1, std::vector<int64_t>* indices=nullptr ) const ; 
+    template<typename T, typename S, typename P>       NP*          copy_if( P predicate, int num_threads=1, std::vector<int64_t>* indices=nullptr ) const ; 
+    template<typename S, typename P>                   int64_t select_blocks( std::vector<std::vector<int64_t>>& sel, std::vector<int64_t>& offset, P& predicate, int num_threads ) const ; 
+    template<typename S>                               void    copy_selected( S* bb, const std::vector<std::vector<int64_t>>& sel, const std::vector<int64_t>& offset, std::vector<int64_t>* indices ) const ; 
     template<typename T, typename S, typename... Args> NP* flexible_copy_if( std::function<bool(const S*)>, Args ... itemshape ) const ; 
 
 
@@ -273,6 +307,14 @@ struct NP
     static NP* Load(const char* dir, const char* name); 
     static NP* Load(const char* dir, const char* reldir, const char* name); 
 
+    static NP* LoadMapped(const char* path); 
+    static NP* LoadMapped(const char* dir, const char* name); 
+
+    static NP* LoadFortran(const char* path);   // opt-in to column-major payloads for NPView access 
+
+    static NP* LoadSlice(const char* path, int i0, int i1); 
+    static NP* LoadSlice(const char* dir, const char* name, int i0, int i1); 
+
     // load float OR double array and if float(4 bytes per element) widens it to double(8 bytes per element)  
     static NP* LoadWide(const char* dir, const char* reldir, const char* name); 
     static NP* LoadWide(const char* dir, const char* name); 
@@ -316,6 +358,10 @@ struct NP
     template<typename T> void psplit(std::vector<T>& domain, std::vector<T>& values) const ; 
     template<typename T> T    pdomain(const T value, int item=-1, bool dump=false  ) const ; 
     template<typename T> T    interp(T x, int item=-1) const ;                  // requires pshaped 
+    template<typename T> void interp_many( const T* x, T* y, int64_t n, int item=-1, int num_threads=0 ) const ; 
+    template<typename T> void interp_multi(const T* x, T* y, int64_t n, const std::vector<int>& jvals, int item=-1, int num_threads=0 ) const ; 
+    template<typename T> void interp_multi(T x, T* y, const std::vector<int>& jvals, int item=-1 ) const ; 
+    template<typename T> static void InterpBins(const T* vv, int ni, int nj, const T* x, int n, int* lo, T* fx ) ; 
     template<typename T> T    interp2D(T x, T y, int item=-1) const ;   
 
 
@@ -326,6 +372,14 @@ struct NP
     template<typename T> T    combined_interp_5(int i, int j, int k, T x) const ;  // requires NP::Combine of pshapes arrays 
 
     template<typename T> T    _combined_interp(const T* vv, int niv, T x) const  ; 
+    template<typename T> void combined_interp_many(const int* idx, const T* x, T* y, int64_t n, int num_threads=0 ) const ;  // requires NP::Combine array
+    template<typename T> NP*  combined_interp_many(const int* idx, const T* x, int64_t n, int num_threads=0 ) const ; 
+
+    template<typename T> static NP* MakeCompiledProperty(const NP* src, T tolerance, int max_cells=1<<14, bool annotated=true ); 
+    template<typename T> static void InterpSource(const T* vv, int ni, const T* x, T* y, int n ); 
+    template<typename T> static T   CompiledInterp(const T* hh, const T* cc, T x ); 
+    template<typename T> T    compiled_interp(int iprop, T x) const ;    // requires NP::MakeCompiledProperty array
+    template<typename T> void compiled_interp_many(int iprop, const T* x, T* y, int64_t n, int num_threads=0 ) const ; 
 
     template<typename T> static T FractionalRange( T x, T x0, T x1 ); 
 
@@ -375,6 +429,8 @@ struct NP
 
     template<typename T> static T    get_meta_(const char* metadata, const char* key, T fallback=0) ;  // for T=std::string must set fallback to ""
     template<typename T> T    get_meta(const char* key, T fallback=0) const ;  // for T=std::string must set fallback to ""
+    std::string get_meta_string(const char* key) const ;  // empty when not found
+    bool has_meta_key(const char* key) const ; 
 
     template<typename T> static void SetMeta(       std::string& mt, const char* key, T value ); 
     template<typename T> void set_meta(const char* key, T value ) ;  
@@ -434,12 +490,37 @@ struct NP
 
     int load(const char* dir, const char* name);   
     int load(const char* path);   
+    int load_mapped(const char* path);   
+    int load_slice(const char* path, int i0, int i1);   
+    bool is_mapped() const ; 
+    bool is_mapped_file(const char* path) const ; 
+    void unmap(); 
+    int  load_data(); 
+    void release_data(); 
+
+    // payloads in foreign byte order, eg '>f8' on x86_64, are swapped into native order 
+    // on loading unless envvar NP_KEEP_FOREIGN is defined, then use NP::to_native when needed  
+    static constexpr const char* NP_KEEP_FOREIGN = "NP_KEEP_FOREIGN" ; 
+    static bool KeepForeign(); 
+    bool is_native() const ; 
+    int  to_native(int num_threads=0); 
+    void _byteswap(int num_threads=0); 
 
     int load_string_(  const char* path, const char* ext, std::string& str ); 
     int load_strings_( const char* path, const char* ext, std::vector<std::string>* vstr ); 
     int load_meta(  const char* path ); 
     int load_names( const char* path ); 
     int load_labels( const char* path ); 
+    void load_sidecars( const char* path ); 
+
+    // opt-in single file layout with meta, names and labels in a block following the payload, see NP::make_embedded 
+    static constexpr const char* NP_EMBED = "NP_EMBED" ; 
+    static constexpr const char* EMBED_MAGIC = "NPEMBED1" ; 
+    static constexpr const unsigned EMBED_TRAILER = 32 ;   // magic and three uint64 block sizes 
+    static bool EmbedDefault(); 
+    std::string make_embedded() const ; 
+    int load_embedded( std::istream& fp, size_t payload_end ); 
+    int load_embedded_( const char* tail, size_t tail_bytes ); 
 
     void save_string_( const char* path, const char* ext, const std::string& str ) const ; 
     void save_strings_(const char* path, const char* ext, const std::vector<std::string>& vstr ) const ; 
@@ -450,6 +531,8 @@ struct NP
     void save_header(const char* path);   
     void old_save(const char* path) ;  // formerly the *save* methods could not be const because of update_headers
     void save(const char* path) const ;  // *save* methods now can be const due to dynamic creation of header
+    int  save_(const char* path, bool embed=EmbedDefault()) const ; // path must be resolved and directory exist, returns non-zero on failure 
+    void save_embedded(const char* path) const ;  // single file with meta, names and labels following the payload 
 
     void save(const char* dir, const char* name) const ;   
     void save(const char* dir, const char* reldir, const char* name) const ;   
@@ -538,7 +621,9 @@ struct NP
     // END OF TAIL STATICS
   
     // primary data members 
-    std::vector<char> data = {} ; 
+    // NB data is not std::vector<char> : code holding references to it should use NP::Data 
+    typedef std::vector<char, NPAlloc<char>> Data ;  
+    Data              data = {} ;   // 64-byte aligned, see NPAlloc 
     std::vector<int>  shape ; 
     std::string       meta ; 
     std::vector<std::string>  names ;  
@@ -556,11 +641,23 @@ struct NP
     const char* dtype ; 
     char        uifc ;    // element type code 
     int         ebyte ;   // element bytes  
-    int         size ;    // number of elements from shape
+    int64_t     size ;    // number of elements from shape
 
     // nodata:true used for lightweight access to metadata from many arrays
     bool        nodata ; 
 
+    // payload in column-major order, as loaded by NP::LoadFortran from .npy with fortran_order True, 
+    // kept as is : index with NPView or NPView::materialize to C order 
+    bool        fortran_order = false ; 
+    bool        allow_fortran_order = false ;   // opt-in checked by decode_header, see NP::LoadFortran 
+
+    // parsed key -> value index of meta, rebuilt when meta is changed other than by set_meta  
+    mutable NPMeta meta_idx ; 
+
+    // payload within a private file mapping, set by NP::LoadMapped, not shared by copies of the NP  
+    std::shared_ptr<char> _map = {} ; 
+    char*       _mapped = nullptr ; 
+
 
 };
 
@@ -568,19 +665,107 @@ struct NP
 //  SPECIALIZED MEMBER FUNCTIONS 
 
 
-template<typename T> inline const T*  NP::cvalues() const { return (T*)data.data() ;  } 
-template<typename T> inline T*        NP::values() { return (T*)data.data() ;  } 
+template<typename T> inline const T*  NP::cvalues() const { return (const T*)bytes() ;  } 
+template<typename T> inline T*        NP::values() { return (T*)bytes() ;  } 
 
 template<typename T> inline void NP::fill(T value)
 {
     T* vv = values<T>(); 
-    for(int i=0 ; i < size ; i++) *(vv+i) = value ; 
+    for(int64_t i=0 ; i < size ; i++) *(vv+i) = value ; 
 }
 
 template<typename T> inline void NP::_fillIndexFlat(T offset)
 {
     T* vv = values<T>(); 
-    for(int i=0 ; i < size ; i++) *(vv+i) = T(i) + offset ; 
+    for(int64_t i=0 ; i < size ; i++) *(vv+i) = T(i) + offset ; 
+}
+
+/**
+NP::MakeNUMA
+--------------
+
+On multi-socket nodes the pages of a payload are placed on the NUMA node 
+of the thread that first touches them. NP::Make zeros from a single thread 
+placing all pages on one node, so threads on other sockets pay remote 
+memory latency when processing it. 
+
+NUMA_FIRST_TOUCH
+    the payload is zeroed with NP::fill_parallel such that each item range 
+    is placed on the node of the thread that will process it, provided 
+    that processing uses the same partitioning and pinning, ie NP::for_each_item_range 
+    or UPool::ParallelForPinned(num_items, fn, num_threads, 1) with the same num_threads
+
+NUMA_INTERLEAVE
+    pages are interleaved across all nodes with mbind, giving 
+    uniform average latency for any access pattern 
+
+Where NUMA placement is not available (single node, no mbind) 
+the result is the same as NP::Make. 
+
+**/
+
+template<typename T> inline NP* NP::MakeNUMA(int policy, const std::vector<int>& shape_, int num_threads ) // static
+{
+    std::string dtype = descr_<T>::dtype() ; 
+    NP* a = new NP(dtype.c_str()) ;    
+    bool zero = false ;         // leave pages untouched 
+    a->set_shape(shape_, zero) ; 
+    if(policy == NUMA_INTERLEAVE) a->interleave() ; 
+    a->fill_parallel<T>(T(0), num_threads) ;  // first touch 
+    return a ; 
+}
+
+/**
+NP::for_each_item_range
+-------------------------
+
+Calls fn(i0, i1) for contiguous ranges of first dimension items 
+with UPool::ParallelForPinned, the partitioning used by NP::fill_parallel 
+NP::_fillIndexFlat_parallel NP::read_parallel and NP::MakeNUMA. 
+As the thread of each range is pinned to the same CPU on every call 
+with the same num_threads, ranges first touched by NP::MakeNUMA are 
+processed on the node holding their pages. 
+
+**/
+
+template<typename F> inline void NP::for_each_item_range(F fn, int num_threads) const 
+{
+    int64_t ni = shape.size() > 0 ? shape[0] : 1 ; 
+    UPool::ParallelForPinned( ni, fn, num_threads, 1 ); 
+}
+
+template<typename T> inline void NP::fill_parallel(T value, int num_threads)
+{
+    T* vv = values<T>(); 
+    int64_t ni = shape.size() > 0 ? shape[0] : 1 ; 
+    int64_t nv = ni > 0 ? size/ni : 0 ;   // values per item 
+    for_each_item_range( [vv, nv, value](int64_t i0, int64_t i1){ std::fill( vv + i0*nv, vv + i1*nv, value ) ; }, num_threads ); 
+}
+
+template<typename T> inline void NP::_fillIndexFlat_parallel(T offset, int num_threads)
+{
+    T* vv = values<T>(); 
+    int64_t ni = shape.size() > 0 ? shape[0] : 1 ; 
+    int64_t nv = ni > 0 ? size/ni : 0 ; 
+    for_each_item_range( [vv, nv, offset](int64_t i0, int64_t i1){ for(int64_t i=i0*nv ; i < i1*nv ; i++) *(vv+i) = T(i) + offset ; }, num_threads ); 
+}
+
+/**
+NP::read_parallel
+-------------------
+
+Parallel equivalent of NP::read2, copying the payload from *src* 
+with each thread copying the item range it will later process. 
+
+**/
+
+template<typename T> inline void NP::read_parallel(const T* src, int num_threads)
+{
+    assert( sizeof(T) == ebyte ); 
+    T* vv = values<T>(); 
+    int64_t ni = shape.size() > 0 ? shape[0] : 1 ; 
+    int64_t nv = ni > 0 ? size/ni : 0 ; 
+    for_each_item_range( [vv, src, nv](int64_t i0, int64_t i1){ memcpy( vv + i0*nv, src + i0*nv, (i1-i0)*nv*sizeof(T) ) ; }, num_threads ); 
 }
 
 
@@ -606,8 +791,8 @@ EOT
 
 specialize-(){
     cat << EOC | perl -pe "s,T,$1,g" - 
-template<> inline const T* NP::values<T>() const { return (T*)data.data() ; }
-template<> inline       T* NP::values<T>()      {  return (T*)data.data() ; }
+template<> inline const T* NP::values<T>() const { return (T*)bytes() ; }
+template<> inline       T* NP::values<T>()      {  return (T*)bytes() ; }
 template   void NP::_fillIndexFlat<T>(T) ;
 
 EOC
@@ -619,52 +804,52 @@ specialize
 
 // template specializations generated by above bash function
 
-template<>  inline const float* NP::cvalues<float>() const { return (float*)data.data() ; }
-template<>  inline       float* NP::values<float>()      {  return (float*)data.data() ; }
+template<>  inline const float* NP::cvalues<float>() const { return (float*)bytes() ; }
+template<>  inline       float* NP::values<float>()      {  return (float*)bytes() ; }
 template    void NP::_fillIndexFlat<float>(float) ;
 
-template<> inline const double* NP::cvalues<double>() const { return (double*)data.data() ; }
-template<> inline       double* NP::values<double>()      {  return (double*)data.data() ; }
+template<> inline const double* NP::cvalues<double>() const { return (double*)bytes() ; }
+template<> inline       double* NP::values<double>()      {  return (double*)bytes() ; }
 template   void NP::_fillIndexFlat<double>(double) ;
 
-template<> inline const char* NP::cvalues<char>() const { return (char*)data.data() ; }
-template<> inline       char* NP::values<char>()      {  return (char*)data.data() ; }
+template<> inline const char* NP::cvalues<char>() const { return (char*)bytes() ; }
+template<> inline       char* NP::values<char>()      {  return (char*)bytes() ; }
 template   void NP::_fillIndexFlat<char>(char) ;
 
-template<> inline const short* NP::cvalues<short>() const { return (short*)data.data() ; }
-template<> inline       short* NP::values<short>()      {  return (short*)data.data() ; }
+template<> inline const short* NP::cvalues<short>() const { return (short*)bytes() ; }
+template<> inline       short* NP::values<short>()      {  return (short*)bytes() ; }
 template   void NP::_fillIndexFlat<short>(short) ;
 
-template<> inline const int* NP::cvalues<int>() const { return (int*)data.data() ; }
-template<> inline       int* NP::values<int>()      {  return (int*)data.data() ; }
+template<> inline const int* NP::cvalues<int>() const { return (int*)bytes() ; }
+template<> inline       int* NP::values<int>()      {  return (int*)bytes() ; }
 template   void NP::_fillIndexFlat<int>(int) ;
 
-template<> inline const long* NP::cvalues<long>() const { return (long*)data.data() ; }
-template<> inline       long* NP::values<long>()      {  return (long*)data.data() ; }
+template<> inline const long* NP::cvalues<long>() const { return (long*)bytes() ; }
+template<> inline       long* NP::values<long>()      {  return (long*)bytes() ; }
 template   void NP::_fillIndexFlat<long>(long) ;
 
-template<> inline const long long* NP::cvalues<long long>() const { return (long long*)data.data() ; }
-template<> inline       long long* NP::values<long long>()      {  return (long long*)data.data() ; }
+template<> inline const long long* NP::cvalues<long long>() const { return (long long*)bytes() ; }
+template<> inline       long long* NP::values<long long>()      {  return (long long*)bytes() ; }
 template   void NP::_fillIndexFlat<long long>(long long) ;
 
-template<> inline const unsigned char* NP::cvalues<unsigned char>() const { return (unsigned char*)data.data() ; }
-template<> inline       unsigned char* NP::values<unsigned char>()      {  return (unsigned char*)data.data() ; }
+template<> inline const unsigned char* NP::cvalues<unsigned char>() const { return (unsigned char*)bytes() ; }
+template<> inline       unsigned char* NP::values<unsigned char>()      {  return (unsigned char*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned char>(unsigned char) ;
 
-template<> inline const unsigned short* NP::cvalues<unsigned short>() const { return (unsigned short*)data.data() ; }
-template<> inline       unsigned short* NP::values<unsigned short>()      {  return (unsigned short*)data.data() ; }
+template<> inline const unsigned short* NP::cvalues<unsigned short>() const { return (unsigned short*)bytes() ; }
+template<> inline       unsigned short* NP::values<unsigned short>()      {  return (unsigned short*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned short>(unsigned short) ;
 
-template<> inline const unsigned int* NP::cvalues<unsigned int>() const { return (unsigned int*)data.data() ; }
-template<> inline       unsigned int* NP::values<unsigned int>()      {  return (unsigned int*)data.data() ; }
+template<> inline const unsigned int* NP::cvalues<unsigned int>() const { return (unsigned int*)bytes() ; }
+template<> inline       unsigned int* NP::values<unsigned int>()      {  return (unsigned int*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned int>(unsigned int) ;
 
-template<> inline const unsigned long* NP::cvalues<unsigned long>() const { return (unsigned long*)data.data() ; }
-template<> inline       unsigned long* NP::values<unsigned long>()      {  return (unsigned long*)data.data() ; }
+template<> inline const unsigned long* NP::cvalues<unsigned long>() const { return (unsigned long*)bytes() ; }
+template<> inline       unsigned long* NP::values<unsigned long>()      {  return (unsigned long*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned long>(unsigned long) ;
 
-template<> inline const unsigned long long* NP::cvalues<unsigned long long>() const { return (unsigned long long*)data.data() ; }
-template<> inline       unsigned long long* NP::values<unsigned long long>()      {  return (unsigned long long*)data.data() ; }
+template<> inline const unsigned long long* NP::cvalues<unsigned long long>() const { return (unsigned long long*)bytes() ; }
+template<> inline       unsigned long long* NP::values<unsigned long long>()      {  return (unsigned long long*)bytes() ; }
 template   void NP::_fillIndexFlat<unsigned long long>(unsigned long long) ;
 
 
@@ -972,6 +1157,26 @@ template <typename T> NP* NP::Make( int ni_, int nj_, int nk_, int nl_, int nm_,
     return a ; 
 }
 
+/**
+NP::MakeUninitialized
+-----------------------
+
+As NP::Make but the payload is not zeroed, for use when every 
+value is about to be written. The content is undefined until then.  
+
+**/
+
+template <typename T> NP* NP::MakeUninitialized( int ni_, int nj_, int nk_, int nl_, int nm_, int no_ ) // static
+{
+    std::string dtype = descr_<T>::dtype() ; 
+    NP* a = new NP(dtype.c_str()) ;    
+    std::vector<int> shape ; 
+    NPS::set_shape(shape, ni_,nj_,nk_,nl_,nm_, no_) ; 
+    bool zero = false ; 
+    a->set_shape(shape, zero) ; 
+    return a ; 
+}
+
 template<typename T, typename ... Args> NP*  NP::Make_( Args ... shape_ )   // Make_shape static 
 {
     std::string dtype = descr_<T>::dtype() ; 
@@ -993,15 +1198,15 @@ template<typename T> NP* NP::MakeFlat(int ni, int nj, int nk, int nl, int nm, in
 //  MEMBER FUNCTIONS 
 
 
-inline char*        NP::bytes() { return (char*)data.data() ;  } 
-inline const char*  NP::bytes() const { return (char*)data.data() ;  } 
+inline char*        NP::bytes() { return _mapped ? _mapped : (char*)data.data() ;  } 
+inline const char*  NP::bytes() const { return _mapped ? _mapped : (char*)data.data() ;  } 
 
 inline unsigned NP::hdr_bytes() const { return _hdr.length() ; }
 inline unsigned NP::num_items() const { return shape[0] ;  }
-inline unsigned NP::num_values() const { return NPS::size(shape) ;  }
-inline unsigned NP::num_itemvalues() const { return NPS::itemsize(shape) ;  }
-inline unsigned NP::arr_bytes()  const { return NPS::size(shape)*ebyte ; }
-inline unsigned NP::item_bytes() const { return NPS::itemsize(shape)*ebyte ; }
+inline size_t   NP::num_values() const { return NPS::size(shape) ;  }
+inline size_t   NP::num_itemvalues() const { return NPS::itemsize(shape) ;  }
+inline size_t   NP::arr_bytes()  const { return NPS::size(shape)*ebyte ; }
+inline size_t   NP::item_bytes() const { return NPS::itemsize(shape)*ebyte ; }
 inline unsigned NP::meta_bytes() const { return meta.length() ; }
 
 
@@ -1024,6 +1229,7 @@ and even that is non-binding.
 
 inline void NP::clear()
 {
+    unmap(); 
     data.clear(); 
     data.shrink_to_fit(); 
     shape[0] = 0 ; 
@@ -1054,11 +1260,15 @@ inline void NP::update_headers()
 
 inline std::string NP::make_header() const 
 {
-    std::string hdr =  NPU::_make_header( shape, dtype ) ;
+    std::string hdr =  NPU::_make_header( shape, dtype, fortran_order ) ;
     return hdr ; 
 }
 inline std::string NP::make_prefix() const 
 {
+    bool fits = arr_bytes() <= 0xffffffffu ;   // net_hdr sizes are 32 bit  
+    if(!fits) std::cerr << "NP::make_prefix arr_bytes " << arr_bytes() << " TOO LARGE FOR 32 BIT NETWORK HEADER " << std::endl ; 
+    assert( fits ); 
+
     std::vector<unsigned> parts ;
     parts.push_back(hdr_bytes());
     parts.push_back(arr_bytes());
@@ -1094,16 +1304,27 @@ data, so together with the size of the type
 know how many bytes can read from the remainder of the stream
 following the header.
 
+Headers with fortran_order True and more than one dimension are only
+accepted with allow_fortran_order set by NP::LoadFortran, as NP::index,
+get, set, slicing and most other methods assume C order payloads. 
+Returns false for rejected headers. 
+
 **/
 
 inline bool NP::decode_header()  
 {
     shape.clear(); 
     std::string descr ; 
-    NPU::parse_header( shape, descr, uifc, ebyte, _hdr ) ; 
+    NPU::parse_header( shape, descr, uifc, ebyte, fortran_order, _hdr ) ; 
     dtype = strdup(descr.c_str());  
     size = NPS::size(shape);    // product of shape dimensions 
-    if(!nodata) data.resize(size*ebyte) ;   // data is now just char 
+
+    bool order_expect = !fortran_order || shape.size() < 2 || allow_fortran_order ; 
+    if(!order_expect) std::cerr << "NP::decode_header fortran_order payload requires NP::LoadFortran and NPView access " << lpath << " " << sstr() << std::endl ; 
+    assert( order_expect ); 
+    if(!order_expect) return false ; 
+
+    if(!nodata && !_mapped) data.resize(size*ebyte) ;   // data is now just char 
     return true  ; 
 }
 
@@ -1142,6 +1363,7 @@ inline bool NP::decode_prefix()
     bool valid = hdr_bytes_nh > 0 ; 
     if(valid)
     {
+        unmap(); 
         _hdr.resize(hdr_bytes_nh);
         data.resize(arr_bytes_nh);   // data now vector of chars 
         meta.resize(meta_bytes_nh);
@@ -1180,7 +1402,107 @@ inline NP::NP(const char* dtype_, int ni, int nj, int nk, int nl, int nm, int no
     init(); 
 }
 
-inline void NP::init()
+/**
+NP copy
+---------
+
+Memberwise except that the payload of a mapped array is copied into *data*,
+so the copy is not mapped. Sharing the MAP_PRIVATE mapping would make writes 
+through one copy visible in the others. 
+
+**/
+
+inline NP::NP(const NP& other)
+    :
+    data(other.data),
+    shape(other.shape),
+    meta(other.meta),
+    names(other.names),
+    labels(other.labels),
+    lpath(other.lpath),
+    lfold(other.lfold),
+    _hdr(other._hdr),
+    _prefix(other._prefix),
+    dtype(other.dtype),
+    uifc(other.uifc),
+    ebyte(other.ebyte),
+    size(other.size),
+    nodata(other.nodata),
+    fortran_order(other.fortran_order),
+    allow_fortran_order(other.allow_fortran_order),
+    meta_idx(other.meta_idx)
+{
+    if(other._mapped) data.assign( other._mapped, other._mapped + other.arr_bytes() ); 
+}
+
+inline NP& NP::operator=(const NP& other)
+{
+    if(this != &other) *this = NP(other) ; 
+    return *this ; 
+}
+
+inline NP::NP(NP&& other)
+    :
+    data(std::move(other.data)),
+    shape(std::move(other.shape)),
+    meta(std::move(other.meta)),
+    names(std::move(other.names)),
+    labels(other.labels),
+    lpath(std::move(other.lpath)),
+    lfold(std::move(other.lfold)),
+    _hdr(std::move(other._hdr)),
+    _prefix(std::move(other._prefix)),
+    dtype(other.dtype),
+    uifc(other.uifc),
+    ebyte(other.ebyte),
+    size(other.size),
+    nodata(other.nodata),
+    fortran_order(other.fortran_order),
+    allow_fortran_order(other.allow_fortran_order),
+    meta_idx(std::move(other.meta_idx)),
+    _map(std::move(other._map)),
+    _mapped(other._mapped)
+{
+    other._mapped = nullptr ; 
+}
+
+inline NP& NP::operator=(NP&& other)
+{
+    if(this == &other) return *this ; 
+    data = std::move(other.data) ; 
+    shape = std::move(other.shape) ; 
+    meta = std::move(other.meta) ; 
+    names = std::move(other.names) ; 
+    labels = other.labels ; 
+    lpath = std::move(other.lpath) ; 
+    lfold = std::move(other.lfold) ; 
+    _hdr = std::move(other._hdr) ; 
+    _prefix = std::move(other._prefix) ; 
+    dtype = other.dtype ; 
+    uifc = other.uifc ; 
+    ebyte = other.ebyte ; 
+    size = other.size ; 
+    nodata = other.nodata ; 
+    fortran_order = other.fortran_order ; 
+    allow_fortran_order = other.allow_fortran_order ; 
+    meta_idx = std::move(other.meta_idx) ; 
+    _map = std::move(other._map) ; 
+    _mapped = other._mapped ; 
+    other._mapped = nullptr ; 
+    return *this ; 
+}
+
+/**
+NP::init
+----------
+
+Sizes the payload for the shape and dtype. With zero:false the payload 
+is not zeroed, as NPAlloc does not initialize, for use when all bytes 
+are overwritten by the caller. 
+
+**/
+
+inline void NP::init(bool zero)
 {
     unsigned long long size_ = size ; 
     unsigned long long ebyte_ = ebyte ; 
@@ -1194,8 +1516,9 @@ inline void NP::init()
         << std::endl 
         ;
 
+    unmap(); 
     data.resize( num_char ) ;  // vector of char  
-    std::fill( data.begin(), data.end(), 0 );     
+    if(zero) std::fill( data.begin(), data.end(), 0 );     
     _prefix.assign(net_hdr::LENGTH, '\0' ); 
     _hdr = make_header(); 
 }
@@ -1208,10 +1531,31 @@ inline void NP::set_shape(int ni, int nj, int nk, int nl, int nm, int no)
     size = NPS::copy_shape(shape, ni, nj, nk, nl, nm, no); 
     init(); 
 }
-inline void NP::set_shape(const std::vector<int>& src_shape)
+inline void NP::set_shape(const std::vector<int>& src_shape, bool zero)
 {
     size = NPS::copy_shape(shape, src_shape); 
-    init(); 
+    init(zero); 
+}
+
+/**
+NP::set_align
+---------------
+
+Sets the alignment of payload allocations for this array, eg NPAlloc<char>::HUGE_ALIGN, 
+in place of the default from NPAlloc which depends on the NP_HUGEPAGES envvar.
+Any current payload is moved to an allocation with the new alignment. 
+Use before set_shape to avoid the copy:: 
+
+    NP* a = new NP("<f4") ; 
+    a->set_align(NPAlloc<char>::HUGE_ALIGN) ; 
+    a->set_shape(1024, 1024) ; 
+
+**/
+
+inline void NP::set_align(size_t align)
+{
+    Data aligned(data.begin(), data.end(), NPAlloc<char>(align)) ; 
+    data.swap(aligned) ; 
 }
 
 inline bool NP::has_shape(int ni, int nj, int nk, int nl, int nm, int no) const 
@@ -1347,9 +1691,9 @@ inline void NP::set_dtype(const char* dtype_)
         for(unsigned i=0 ; i < shape.size() ; i++ ) shape[i] /= shrink  ; 
     }
 
-    int num_bytes  = size*ebyte ;      // old 
-    int size_ = NPS::size(shape) ;     // new
-    int num_bytes_ = size_*ebyte_ ;    // new 
+    int64_t num_bytes  = size*ebyte ;      // old 
+    int64_t size_ = NPS::size(shape) ;     // new
+    int64_t num_bytes_ = size_*ebyte_ ;    // new 
 
     bool allowed_change = num_bytes_ == num_bytes ; 
     if(!allowed_change)
@@ -1380,22 +1724,22 @@ in a dimension.
 
 **/
 
-inline unsigned NP::index( int i,  int j,  int k,  int l, int m, int o ) const 
+inline size_t NP::index( int i,  int j,  int k,  int l, int m, int o ) const 
 {
     unsigned nd = shape.size() ; 
-    unsigned ni = nd > 0 ? shape[0] : 1 ; 
-    unsigned nj = nd > 1 ? shape[1] : 1 ; 
-    unsigned nk = nd > 2 ? shape[2] : 1 ; 
-    unsigned nl = nd > 3 ? shape[3] : 1 ; 
-    unsigned nm = nd > 4 ? shape[4] : 1 ; 
-    unsigned no = nd > 5 ? shape[5] : 1 ; 
-
-    unsigned ii = i < 0 ? ni + i : i ; 
-    unsigned jj = j < 0 ? nj + j : j ; 
-    unsigned kk = k < 0 ? nk + k : k ; 
-    unsigned ll = l < 0 ? nl + l : l ; 
-    unsigned mm = m < 0 ? nm + m : m ; 
-    unsigned oo = o < 0 ? no + o : o ; 
+    size_t ni = nd > 0 ? shape[0] : 1 ; 
+    size_t nj = nd > 1 ? shape[1] : 1 ; 
+    size_t nk = nd > 2 ? shape[2] : 1 ; 
+    size_t nl = nd > 3 ? shape[3] : 1 ; 
+    size_t nm = nd > 4 ? shape[4] : 1 ; 
+    size_t no = nd > 5 ? shape[5] : 1 ; 
+
+    size_t ii = i < 0 ? ni + i : i ; 
+    size_t jj = j < 0 ? nj + j : j ; 
+    size_t kk = k < 0 ? nk + k : k ; 
+    size_t ll = l < 0 ? nl + l : l ; 
+    size_t mm = m < 0 ? nm + m : m ; 
+    size_t oo = o < 0 ? no + o : o ; 
 
     return  ii*nj*nk*nl*nm*no + jj*nk*nl*nm*no + kk*nl*nm*no + ll*nm*no + mm*no + oo ;
 }
@@ -1408,23 +1752,23 @@ Same as NP::index but -ve "missing" indices are treated as if they were zero.
 
 **/
 
-inline unsigned NP::index0( int i,  int j,  int k,  int l, int m, int o) const 
+inline size_t NP::index0( int i,  int j,  int k,  int l, int m, int o) const 
 {
     unsigned nd = shape.size() ; 
 
-    unsigned ni = nd > 0 ? shape[0] : 1 ; 
-    unsigned nj = nd > 1 ? shape[1] : 1 ; 
-    unsigned nk = nd > 2 ? shape[2] : 1 ; 
-    unsigned nl = nd > 3 ? shape[3] : 1 ; 
-    unsigned nm = nd > 4 ? shape[4] : 1 ; 
-    unsigned no = nd > 5 ? shape[5] : 1 ; 
+    size_t ni = nd > 0 ? shape[0] : 1 ; 
+    size_t nj = nd > 1 ? shape[1] : 1 ; 
+    size_t nk = nd > 2 ? shape[2] : 1 ; 
+    size_t nl = nd > 3 ? shape[3] : 1 ; 
+    size_t nm = nd > 4 ? shape[4] : 1 ; 
+    size_t no = nd > 5 ? shape[5] : 1 ; 
 
-    unsigned ii = i < 0 ? 0 : i ; 
-    unsigned jj = j < 0 ? 0 : j ; 
-    unsigned kk = k < 0 ? 0 : k ; 
-    unsigned ll = l < 0 ? 0 : l ; 
-    unsigned mm = m < 0 ? 0 : m ; 
-    unsigned oo = o < 0 ? 0 : o ; 
+    size_t ii = i < 0 ? 0 : i ; 
+    size_t jj = j < 0 ? 0 : j ; 
+    size_t kk = k < 0 ? 0 : k ; 
+    size_t ll = l < 0 ? 0 : l ; 
+    size_t mm = m < 0 ? 0 : m ; 
+    size_t oo = o < 0 ? 0 : o ; 
 
     if(!(ii <  ni)) std::cerr << "NP::index0 ii/ni " << ii << "/" << ni  << std::endl ; 
 
@@ -1448,30 +1792,30 @@ inline unsigned NP::index0( int i,  int j,  int k,  int l, int m, int o) const
     //      i                   j                k             l          m       o 
 }
 
-inline unsigned NP::dimprod(unsigned q) const   // product of dimensions starting from dimension q
+inline size_t NP::dimprod(unsigned q) const   // product of dimensions starting from dimension q
 {
-    unsigned dim = 1 ; 
+    size_t dim = 1 ; 
     for(unsigned d=q ; d < shape.size() ; d++) dim *= shape[d] ; 
     return dim ;   
 } 
 
 
 template<typename... Args>
-inline unsigned NP::index_(Args ... idxx_) const 
+inline size_t NP::index_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return index__(idxx); 
 }
 
 template<typename... Args>
-inline unsigned NP::stride_(Args ... idxx_) const 
+inline size_t NP::stride_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return stride__(idxx); 
 }
 
 template<typename... Args>
-inline unsigned NP::offset_(Args ... idxx_) const 
+inline size_t NP::offset_(Args ... idxx_) const 
 {
     std::vector<int> idxx = {idxx_...};
     return offset__(idxx); 
@@ -1543,9 +1887,9 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
     int slicedim = pickdim__(idxx); 
     assert( slicedim > -1 ); 
 
-    unsigned start = index__(idxx) ; 
-    unsigned stride = stride__(idxx) ; 
-    unsigned offset = offset__(idxx) ; 
+    size_t start = index__(idxx) ; 
+    size_t stride = stride__(idxx) ; 
+    size_t offset = offset__(idxx) ; 
     unsigned numval = shape[slicedim] ; 
 
     if(NP::VERBOSE) 
@@ -1644,9 +1988,9 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
 
     **/
 
-    inline unsigned NP::index__(const std::vector<int>& idxx) const 
+    inline size_t NP::index__(const std::vector<int>& idxx) const 
     {
-        unsigned idx = 0 ; 
+        size_t idx = 0 ; 
         for(unsigned d=0 ; d < shape.size() ; d++)  
         {
             int dd = (d < idxx.size() ? idxx[d] : 1) ; 
@@ -1657,20 +2001,20 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
     }
 
 
-    inline unsigned NP::stride__(const std::vector<int>& idxx) const 
+    inline size_t NP::stride__(const std::vector<int>& idxx) const 
     {
         int pd = pickdim__(idxx);  
         assert( pd > -1 ); 
-        unsigned stride = dimprod(pd+1) ; 
+        size_t stride = dimprod(pd+1) ; 
         return stride ; 
     }
 
-    inline unsigned NP::offset__(const std::vector<int>& idxx) const 
+    inline size_t NP::offset__(const std::vector<int>& idxx) const 
     {
         int pd = pickdim__(idxx);  
         assert( pd > -1 ); 
 
-        unsigned offset = 0 ; 
+        size_t offset = 0 ; 
         for(unsigned d=pd+1 ; d < shape.size() ; d++)  
         {
             int dd = (d < idxx.size() ? idxx[d] : 1) ; 
@@ -1684,17 +2028,17 @@ template<typename T> inline void NP::slice_(std::vector<T>& out, const std::vect
 
 
 
-inline unsigned NP::itemsize_(int i, int j, int k, int l, int m, int o) const
+inline size_t NP::itemsize_(int i, int j, int k, int l, int m, int o) const
 {
     return NPS::itemsize_(shape, i, j, k, l, m, o) ; 
 }
 
-inline void NP::itembytes_(const char** start,  unsigned& num_bytes,  int i,  int j,  int k,  int l, int m, int o ) const 
+inline void NP::itembytes_(const char** start,  size_t& num_bytes,  int i,  int j,  int k,  int l, int m, int o ) const 
 {
-    unsigned idx0 = index0(i,j,k,l,m,o) ; 
+    size_t idx0 = index0(i,j,k,l,m,o) ; 
     *start = bytes() + idx0*ebyte ;  
 
-    unsigned sz = itemsize_(i, j, k, l, m, o) ; 
+    size_t sz = itemsize_(i, j, k, l, m, o) ; 
     num_bytes = sz*ebyte ; 
 }
 
@@ -1703,26 +2047,59 @@ inline void NP::itembytes_(const char** start,  unsigned& num_bytes,  int i,  in
 
 template<typename T> inline T NP::get( int i,  int j,  int k,  int l, int m, int o) const 
 {
-    unsigned idx = index(i, j, k, l, m, o); 
+    size_t idx = index(i, j, k, l, m, o); 
     const T* vv = cvalues<T>() ;  
     return vv[idx] ; 
 }
 
 template<typename T> inline void NP::set( T val, int i,  int j,  int k,  int l, int m, int o) 
 {
-    unsigned idx = index(i, j, k, l, m, o); 
+    size_t idx = index(i, j, k, l, m, o); 
     T* vv = values<T>() ;  
     vv[idx] = val ; 
 }
 
+/**
+NP::is_array NP::array NP::carray
+-----------------------------------
+
+Typed fixed rank accessors for hot loops in place of NP::get NP::set,
+see NPArray in NPU.hh. The dtype, element size and rank must match
+the template parameters and the payload must be present and in C order,
+otherwise an invalid NPArray is returned after asserting.
+
+**/
+
+template<typename T, int N> inline bool NP::is_array() const 
+{
+    bool ok = uifc == ::desc<T>::code && ebyte == int(sizeof(T)) && int(shape.size()) == N && !nodata && !( fortran_order && N > 1 ) ; 
+    return ok ; 
+}
+
+template<typename T, int N> inline NPArray<T,N> NP::array() 
+{
+    bool ok = is_array<T,N>() ; 
+    if(!ok) std::cerr << "NP::array dtype/rank mismatch " << descr_<T>::dtype() << " " << N << " for " << sstr() << " " << dtype << ( fortran_order ? " fortran_order" : "" ) << std::endl ; 
+    assert( ok ); 
+    return ok ? NPArray<T,N>( values<T>(), shape ) : NPArray<T,N>() ; 
+}
+
+template<typename T, int N> inline NPArray<const T,N> NP::carray() const 
+{
+    bool ok = is_array<T,N>() ; 
+    if(!ok) std::cerr << "NP::carray dtype/rank mismatch " << descr_<T>::dtype() << " " << N << " for " << sstr() << " " << dtype << ( fortran_order ? " fortran_order" : "" ) << std::endl ; 
+    assert( ok ); 
+    return ok ? NPArray<const T,N>( cvalues<T>(), shape ) : NPArray<const T,N>() ; 
+}
+
 
 
 template<typename T> inline bool NP::is_allzero() const 
 {
     T zero = T(0) ; 
     const T* vv = cvalues<T>(); 
-    int num = 0 ; 
-    for(int i=0 ; i < size ; i++) if(vv[i] == zero) num += 1 ; 
+    int64_t num = 0 ; 
+    for(int64_t i=0 ; i < size ; i++) if(vv[i] == zero) num += 1 ; 
     bool allzero = num == size ; 
     return allzero ; 
 }
@@ -1962,12 +2339,14 @@ inline NP* NP::MakeLike(const NP* src) // static
     return dst ; 
 }
 
-inline void NP::CopyMeta( NP* b, const NP* a ) // static
+inline void NP::CopyMeta( NP* b, const NP* a, bool zero ) // static
 {
-    b->set_shape( a->shape ); 
+    b->set_shape( a->shape, zero ); 
     b->meta = a->meta ;    // pass along the metadata 
     b->names = a->names ; 
     b->nodata = a->nodata ; 
+    b->fortran_order = a->fortran_order ;  // elementwise copies keep the layout 
+    b->allow_fortran_order = a->allow_fortran_order ; 
     if(a->labels) b->labels = new std::vector<std::string>( a->labels->begin(), a->labels->end() ) ; 
 }
 
@@ -1992,13 +2371,28 @@ inline float NP::PreserveNarrowedDoubleInteger( double f )
      return uif32.f ;  
 }
 
-inline NP* NP::MakeNarrow(const NP* a) // static 
+/**
+NP::MakeNarrow NP::MakeWide
+-----------------------------
+
+Float payloads are converted by the NPU::_narrow NPU::_widen vector kernels, 
+large payloads split between UPool threads. Other payloads are not converted, 
+the result has the changed dtype and zeroed values. 
+
+With the Preserve_Last_Column_Integer_Annotation metadata the last value 
+of each item is narrowed with NP::PreserveNarrowedDoubleInteger keeping 
+the low 32 bits of the double rather than converting it. 
+
+**/
+
+inline NP* NP::MakeNarrow(const NP* a, int num_threads) // static 
 {
     assert( a->ebyte == 8 ); 
     std::string b_dtype = NPU::_make_narrow(a->dtype); 
 
     NP* b = new NP(b_dtype.c_str()); 
-    CopyMeta(b, a ); 
+    bool overwrite = a->uifc == 'f' && b->uifc == 'f' ;   // only float payloads are converted
+    CopyMeta(b, a, !overwrite ); 
 
     bool plcia = b->is_preserve_last_column_integer_annotation() ; 
     if(VERBOSE && plcia) std::cout 
@@ -2013,19 +2407,21 @@ inline NP* NP::MakeNarrow(const NP* a) // static
 
 
     assert( a->num_values() == b->num_values() ); 
-    unsigned nv = a->num_values(); 
-    unsigned iv = a->num_itemvalues(); 
+    size_t nv = a->num_values(); 
+    size_t iv = a->num_itemvalues(); 
 
     if( a->uifc == 'f' && b->uifc == 'f')
     {
         const double* aa = a->cvalues<double>() ;  
         float*        bb = b->values<float>() ;  
-        for(unsigned i=0 ; i < nv ; i++) 
+        auto fn = [aa, bb, plcia, iv](int64_t i0, int64_t i1)
         {
-            bb[i] = float(aa[i]); 
-            bool preserve_last_column_integer = plcia && ((i % iv) == iv - 1 ) ; // only works for 3D not higher D
-            if(preserve_last_column_integer) bb[i] = PreserveNarrowedDoubleInteger(aa[i]) ; 
-        }
+            NPU::_narrow( bb + i0, aa + i0, i1 - i0 ); 
+            if(!plcia) return ; 
+            int64_t i = i0 + ( iv - 1 - i0 % iv ) ;  // first last column index at or after i0, only works for 3D not higher D
+            for( ; i < i1 ; i += iv ) bb[i] = PreserveNarrowedDoubleInteger(aa[i]) ; 
+        };
+        UPool::ParallelFor( nv, fn, num_threads, 1 << 18 ); 
     }
 
     if(VERBOSE) std::cout 
@@ -2037,25 +2433,24 @@ inline NP* NP::MakeNarrow(const NP* a) // static
     return b ; 
 }
 
-inline NP* NP::MakeWide(const NP* a) // static 
+inline NP* NP::MakeWide(const NP* a, int num_threads) // static 
 {
     assert( a->ebyte == 4 ); 
     std::string b_dtype = NPU::_make_wide(a->dtype); 
 
     NP* b = new NP(b_dtype.c_str()); 
-    CopyMeta(b, a ); 
+    bool overwrite = a->uifc == 'f' && b->uifc == 'f' ;   // only float payloads are converted
+    CopyMeta(b, a, !overwrite ); 
 
     assert( a->num_values() == b->num_values() ); 
-    unsigned nv = a->num_values(); 
+    size_t nv = a->num_values(); 
 
     if( a->uifc == 'f' && b->uifc == 'f')
     {
         const float* aa = a->cvalues<float>() ;  
         double* bb = b->values<double>() ;  
-        for(unsigned i=0 ; i < nv ; i++)
-        {
-            bb[i] = double(aa[i]); 
-        }
+        auto fn = [aa, bb](int64_t i0, int64_t i1){ NPU::_widen( bb + i0, aa + i0, i1 - i0 ) ; } ; 
+        UPool::ParallelFor( nv, fn, num_threads, 1 << 18 ); 
     }
 
     if(VERBOSE) std::cout 
@@ -2071,7 +2466,7 @@ inline NP* NP::MakeWide(const NP* a) // static
 inline NP* NP::MakeCopy(const NP* a) // static 
 {
     NP* b = new NP(a->dtype); 
-    CopyMeta(b, a ); 
+    CopyMeta(b, a, a->nodata ); // payload copied unless nodata 
 
     assert( a->arr_bytes() == b->arr_bytes() ); 
 
@@ -2079,7 +2474,7 @@ inline NP* NP::MakeCopy(const NP* a) // static
     {
         memcpy( b->bytes(), a->bytes(), a->arr_bytes() );    
     }
-    unsigned nv = a->num_values(); 
+    size_t nv = a->num_values(); 
 
     if(VERBOSE) std::cout 
         << "NP::MakeCopy"
@@ -2212,7 +2607,7 @@ inline NP* NP::MakeSelectCopy_(  const NP* src, const int* items, int num_items
     dst_shape[0] = num_items ; 
     NP* dst = new NP(src->dtype, dst_shape); 
     assert( src->item_bytes() == dst->item_bytes() );  
-    unsigned size = src->item_bytes(); 
+    size_t size = src->item_bytes(); 
     for(int i=0 ; i < num_items ; i++) 
     {
         memcpy( dst->bytes() + i*size, src->bytes() + items[i]*size , size ); 
@@ -2241,7 +2636,7 @@ inline NP* NP::MakeItemCopy(  const NP* src, int i, int j, int k, int l, int m,
 {
     std::vector<int> sub_shape ; 
     src->item_shape(sub_shape, i, j, k, l, m, o );   // shape of the item specified by (i,j,k,l,m,n)
-    unsigned idx = src->index0(i, j, k, l, m, o ); 
+    size_t idx = src->index0(i, j, k, l, m, o ); 
 
     if(NP::VERBOSE) std::cout 
         << "NP::MakeItemCopy"
@@ -2370,12 +2765,17 @@ to facilitate direct conversion of the ICDF array into GPU textures.
 The *hd_factor* convention regarding domain ranges is used.
 
 Use NP::MakeProperty to add domain infomation using this convention.
- 
+
+As the "all", "lhs" and "rhs" lookup values each ascend with j the lookups 
+of each item are done by NP::PDomainAscending with one merge walk 
+over the CDF per zoom, giving the same values as NP::pdomain in linear time. 
+Items are inverted in parallel over UPool threads, one thread when dumping. 
+Items with values that are not non-decreasing use NP::pdomain for each lookup.  
 
 **/
 
 template<typename T>
-inline NP* NP::MakeICDF(const NP* cdf, unsigned nu, unsigned hd_factor, bool dump)  // static 
+inline NP* NP::MakeICDF(const NP* cdf, unsigned nu, unsigned hd_factor, bool dump, int num_threads)  // static 
 {
     unsigned ndim = cdf->shape.size(); 
     assert( ndim == 2 || ndim == 3 ); 
@@ -2403,44 +2803,115 @@ inline NP* NP::MakeICDF(const NP* cdf, unsigned nu, unsigned hd_factor, bool dum
         << std::endl 
         ;
 
-    for(unsigned i=0 ; i < ni ; i++)
-    {
-        int item = i ;  
-        if(dump) std::cout << "NP::MakeICDF" << " item " << item << std::endl ; 
+    unsigned cdf_ni = cdf->shape[ndim-2] ; 
+    unsigned cdf_nj = cdf->shape[ndim-1] ; 
 
-        for(unsigned j=0 ; j < nj ; j++)
-        {
-            T y_all = T(j)/T(nj) ; //        // 0 -> (nj-1)/nj = 1-1/nj 
-            T x_all = cdf->pdomain<T>( y_all, item );    
+    auto y_all = [nj](unsigned j){ return T(j)/T(nj) ; } ;     // 0 -> (nj-1)/nj = 1-1/nj 
+    auto y_lhs = [nj,hd_factor](unsigned j){ return T(j)/T(hd_factor*nj) ; } ; 
+    auto y_rhs = [nj,hd_factor,edge](unsigned j){ return T(1.) - edge + T(j)/T(hd_factor*nj) ; } ; 
 
-#ifdef DEBUG
-            std::cout 
-                <<  " y_all " << std::setw(10) << std::setprecision(4) << std::fixed << y_all 
-                <<  " x_all " << std::setw(10) << std::setprecision(4) << std::fixed << x_all 
-                << std::endl
-                ;
-#endif
-            unsigned offset = i*nj*nk+j*nk ;  
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            int item = i ;  
+            if(dump) std::cout << "NP::MakeICDF" << " item " << item << std::endl ; 
 
-            vv[offset+0] = x_all ;
+            const T* cc = cdf->cvalues<T>() + int64_t(cdf_ni)*cdf_nj*item ; 
+            T* ii = vv + int64_t(i)*nj*nk ; 
 
-            if( hd_factor > 0 )
+            bool ascending = PDomainAscending<T>( cc, cdf_ni, cdf_nj, nj, y_all, ii + 0, nk ) ;
+            if( ascending && hd_factor > 0 )
             {
-                T y_lhs = T(j)/T(hd_factor*nj) ;
-                T y_rhs = T(1.) - edge + T(j)/T(hd_factor*nj) ; 
+                PDomainAscending<T>( cc, cdf_ni, cdf_nj, nj, y_lhs, ii + 1, nk ) ;
+                PDomainAscending<T>( cc, cdf_ni, cdf_nj, nj, y_rhs, ii + 2, nk ) ;
+                for(unsigned j=0 ; j < nj ; j++) ii[j*nk+3] = 0. ; 
+            }
 
-                T x_lhs = cdf->pdomain<T>( y_lhs, item );    
-                T x_rhs = cdf->pdomain<T>( y_rhs, item );    
+            if( ascending ) continue ; 
 
-                vv[offset+1] = x_lhs ;
-                vv[offset+2] = x_rhs ;
-                vv[offset+3] = 0. ;
+            for(unsigned j=0 ; j < nj ; j++)
+            {
+                unsigned offset = j*nk ;  
+                ii[offset+0] = cdf->pdomain<T>( y_all(j), item );    
+                if( hd_factor > 0 )
+                {
+                    ii[offset+1] = cdf->pdomain<T>( y_lhs(j), item );    
+                    ii[offset+2] = cdf->pdomain<T>( y_rhs(j), item );    
+                    ii[offset+3] = 0. ;
+                }
             }
         }
-    }
+    };
+    UPool::ParallelFor( ni, fn, dump ? 1 : num_threads, 1 ); 
     return icdf ; 
 } 
 
+/**
+NP::PDomainAscending
+----------------------
+
+Sets xq[q*xq_stride] to the domain value that NP::pdomain gives for value yq(q) 
+of the (ni, nj) property vv for nq values expected to ascend yq(0) <= yq(1) <= ... 
+Domain is in payload slot 0 and value in the last slot nj-1. 
+
+NP::pdomain scans for the first bin with y0 <= yv < y1, which for non-decreasing 
+values is the bin before the first value exceeding yv, so the bin only moves 
+forwards as yv ascends and all lookups take one walk over the property. 
+The interpolation matches NP::pdomain bitwise. 
+
+Returns false without setting xq when the property domain or values 
+are not non-decreasing, leaving the caller to use NP::pdomain. 
+
+**/
+
+template<typename T, typename F>
+inline bool NP::PDomainAscending(const T* vv, unsigned ni, unsigned nj, unsigned nq, F yq, T* xq, unsigned xq_stride ) // static
+{
+    const T zero = 0. ; 
+    unsigned jdom = 0 ; 
+    unsigned jval = nj - 1 ; 
+
+    for(unsigned i=1 ; i < ni ; i++) if(!( vv[nj*i+jval] >= vv[nj*(i-1)+jval] )) return false ; 
+    const T lhs_dom = vv[nj*(0)+jdom]; 
+    const T rhs_dom = vv[nj*(ni-1)+jdom];
+    if(!( rhs_dom >= lhs_dom )) return false ; 
+
+    const T lhs_val = vv[nj*(0)+jval]; 
+    const T rhs_val = vv[nj*(ni-1)+jval];
+
+    unsigned i = 0 ; 
+    T yprev = lhs_val ; 
+    for(unsigned q=0 ; q < nq ; q++)
+    {
+        const T yv = yq(q) ; 
+        if( yv < yprev ) i = 0 ;    // restart the walk for out of order values 
+        yprev = yv ; 
+        T xv ; 
+        if( yv <= lhs_val )
+        {
+            xv = lhs_dom ; 
+        }
+        else if( yv >= rhs_val )
+        {
+            xv = rhs_dom ; 
+        }
+        else
+        {
+            while( vv[nj*(i+1)+jval] <= yv ) i++ ;   // stops before ni-1 as yv < rhs_val
+            const T x0 = vv[nj*(i+0)+jdom] ; 
+            const T y0 = vv[nj*(i+0)+jval] ; 
+            const T x1 = vv[nj*(i+1)+jdom] ; 
+            const T y1 = vv[nj*(i+1)+jval] ;
+            const T dy = y1 - y0 ;  
+            xv = x0 ; 
+            if( dy > zero ) xv += (yv-y0)*(x1-x0)/dy ; 
+        }
+        xq[q*xq_stride] = xv ; 
+    }
+    return true ; 
+}
+
 /**
 NP::MakeProperty
 -----------------
@@ -2569,10 +3040,15 @@ issue usually occurs without paying the cost of higher resolution across the ent
 
 TODO: compare what this provides directly on the ICDF (using NP::interp) 
       with what the CDF directly can provide (using NP::pdomain)
+
+The uniform for sample i is the first NPPhilox::Uniform of subsequence i 
+keyed by the seed, as curand_uniform following curand_init(seed, i, 0, &state), 
+so the items are filled in parallel over UPool threads and the sample is 
+bitwise identical for any num_threads. 
      
 **/
 
-template <typename T> NP* NP::MakeLookupSample(const NP* icdf_prop, unsigned ni, unsigned seed, unsigned hd_factor ) // static 
+template <typename T> NP* NP::MakeLookupSample(const NP* icdf_prop, unsigned ni, unsigned seed, unsigned hd_factor, int num_threads ) // static 
 {
     unsigned ndim = icdf_prop->shape.size() ; 
     unsigned npay = icdf_prop->shape[ndim-1] ; 
@@ -2588,18 +3064,18 @@ template <typename T> NP* NP::MakeLookupSample(const NP* icdf_prop, unsigned ni,
         assert( icdf_prop->shape[1] == 4 ); 
     }
 
-    std::mt19937_64 rng;
-    rng.seed(seed); 
-    std::uniform_real_distribution<T> unif(0, 1);
-
     NP* sample = NP::Make<T>(ni); 
     T* sample_v = sample->values<T>(); 
-    for(unsigned i=0 ; i < ni ; i++) 
+    auto fn = [&](int64_t i0, int64_t i1)
     {
-        T u = unif(rng) ;  
-        T y = hd_factor > 0 ? icdf_prop->interpHD<T>(u, hd_factor ) : icdf_prop->interp<T>(u) ; 
-        sample_v[i] = y ; 
-    }
+        for(int64_t i=i0 ; i < i1 ; i++) 
+        {
+            T u = NPPhilox::Uniform<T>(seed, i) ;  
+            T y = hd_factor > 0 ? icdf_prop->interpHD<T>(u, hd_factor ) : icdf_prop->interp<T>(u) ; 
+            sample_v[i] = y ; 
+        }
+    };
+    UPool::ParallelFor( ni, fn, num_threads, 1 << 14 ); 
     return sample ; 
 }
 
@@ -2607,19 +3083,22 @@ template <typename T> NP* NP::MakeLookupSample(const NP* icdf_prop, unsigned ni,
 NP::MakeUniform
 ----------------
 
-Create array of uniform random numbers between 0 and 1 using std::mt19937_64
+Create array of uniform random numbers in (0,1] with value i the first 
+NPPhilox::Uniform of subsequence i keyed by the seed. The values do not 
+depend on num_threads and match curand_uniform (float) or curand_uniform_double 
+of GPU threads initialized with curand_init(seed, i, 0, &state). 
 
 **/
 
-template <typename T> NP* NP::MakeUniform(unsigned ni, unsigned seed) // static 
+template <typename T> NP* NP::MakeUniform(unsigned ni, unsigned seed, int num_threads) // static 
 {
-    std::mt19937_64 rng;
-    rng.seed(seed); 
-    std::uniform_real_distribution<T> unif(0, 1);
-
     NP* uu = NP::Make<T>(ni); 
     T* vv = uu->values<T>(); 
-    for(unsigned i=0 ; i < ni ; i++) vv[i] = unif(rng) ; 
+    auto fn = [vv, seed](int64_t i0, int64_t i1)
+    {
+        for(int64_t i=i0 ; i < i1 ; i++) vv[i] = NPPhilox::Uniform<T>(seed, i) ; 
+    };
+    UPool::ParallelFor( ni, fn, num_threads, 1 << 16 ); 
     return uu ; 
 }
 
@@ -2634,41 +3113,153 @@ inline NP* NP::copy() const
 
 
 
+/**
+NP::count_if NP::simple_copy_if NP::copy_if with std::function predicate
+--------------------------------------------------------------------------
+
+These use the template predicate overloads below on one thread, 
+so the predicate is called once per item. 
+
+**/
+
 template<typename S>
 inline int NP::count_if(std::function<bool(const S*)> predicate) const 
 {
-    assert( is_itemtype<S>() );  // size of type same as item_bytes
-    const S* vv = cvalues<S>();  
-    int ni = num_items(); 
-    int count = 0 ; 
-    for(int i=0 ; i < ni ; i++) if(predicate(vv+i)) count += 1 ;  
-    return count ; 
+    return count_if<S, std::function<bool(const S*)>>(predicate, 1) ; 
 }
 
 template<typename T> 
 inline NP* NP::simple_copy_if(std::function<bool(const T*)> predicate ) const 
 {
-    assert( is_itemtype<T>() );  // size of type same as item_bytes
+    return simple_copy_if<T, std::function<bool(const T*)>>(predicate, 1) ; 
+}
+
+template<typename T, typename S> 
+inline NP* NP::copy_if(std::function<bool(const S*)> predicate ) const 
+{
+    return copy_if<T, S, std::function<bool(const S*)>>(predicate, 1) ; 
+}
+
+/**
+NP::select_blocks
+-------------------
 
-    int ni = num_items(); 
-    int si = count_if<T>(predicate) ; 
-    assert( si <= ni ); 
+Stream compaction first pass : the items are split into contiguous blocks, 
+one per thread, and the indices of items in block b for which the predicate 
+is true are collected in ascending order into the per-thread buffer sel[b]. 
+The exclusive prefix sum of the block counts is returned in offset 
+such that selected items of block b go to [offset[b], offset[b+1]) of the 
+compacted output, preserving the input order. Returns the total count. 
 
-    const T* aa = cvalues<T>();  
+With num_threads other than 1 the predicate is called concurrently 
+from several threads. 
 
-    NP* b = NP::Make<T>(si) ; 
-    T* bb = b->values<T>(); 
+**/
 
-    int _si = 0 ; 
-    for(int i=0 ; i < ni ; i++) 
+template<typename S, typename P>
+inline int64_t NP::select_blocks(std::vector<std::vector<int64_t>>& sel, std::vector<int64_t>& offset, P& predicate, int num_threads) const 
+{
+    assert( is_itemtype<S>() );  // size of type same as item_bytes
+    const S* aa = cvalues<S>();  
+    int64_t ni = num_items(); 
+
+    const int64_t min_block = 1 << 16 ; 
+    int64_t nb = std::min( int64_t(UPool::NumThreads(num_threads)), ni/min_block ) ; 
+    if( nb < 1 ) nb = 1 ; 
+    int64_t chunk = (ni + nb - 1)/nb ; 
+
+    sel.assign(nb, std::vector<int64_t>()) ; 
+    auto fn = [&](int64_t b0, int64_t b1)
     {
-        if(predicate(aa+i)) 
+        for(int64_t b=b0 ; b < b1 ; b++)
         {
-            memcpy( bb + _si,  aa+i , sizeof(T) ); 
-            _si += 1 ; 
+            std::vector<int64_t>& s = sel[b] ; 
+            int64_t i1 = std::min( ni, (b+1)*chunk ) ; 
+            for(int64_t i=b*chunk ; i < i1 ; i++) if(predicate(aa+i)) s.push_back(i) ;  
         }
-    }
-    assert( si == _si ); 
+    };
+    UPool::ParallelFor( nb, fn, nb, 1 ); 
+
+    offset.assign(nb+1, 0) ; 
+    for(int64_t b=0 ; b < nb ; b++) offset[b+1] = offset[b] + sel[b].size() ; 
+    return offset[nb] ; 
+}
+
+/**
+NP::copy_selected
+-------------------
+
+Stream compaction second pass : each block copies its selected items 
+to bb + offset[b], touching only the selected items. When indices is 
+non-null it is set to the ascending indices of the selected items. 
+
+**/
+
+template<typename S>
+inline void NP::copy_selected(S* bb, const std::vector<std::vector<int64_t>>& sel, const std::vector<int64_t>& offset, std::vector<int64_t>* indices ) const 
+{
+    const S* aa = cvalues<S>();  
+    int64_t nb = sel.size() ; 
+    if(indices) indices->resize(offset[nb]) ; 
+    int64_t* ii = indices ? indices->data() : nullptr ; 
+
+    auto fn = [&](int64_t b0, int64_t b1)
+    {
+        for(int64_t b=b0 ; b < b1 ; b++)
+        {
+            const std::vector<int64_t>& s = sel[b] ; 
+            S* dst = bb + offset[b] ; 
+            for(size_t k=0 ; k < s.size() ; k++) memcpy( dst + k, aa + s[k], sizeof(S) ); 
+            if(ii) std::copy( s.begin(), s.end(), ii + offset[b] ); 
+        }
+    };
+    UPool::ParallelFor( nb, fn, nb, 1 ); 
+}
+
+/**
+NP::count_if NP::simple_copy_if NP::copy_if with template predicate
+---------------------------------------------------------------------
+
+P: any callable taking const S* and returning bool, eg a lambda 
+or functor such that the predicate call can be inlined::
+
+    NP* hit = photon->copy_if<float,sphoton>( [](const sphoton* p){ return p->flagmask & SD ; } ) ; 
+
+    std::vector<int64_t> idx ; 
+    NP* hit = photon->copy_if<float,sphoton>( sel, 0, &idx ) ;   // all threads and indices of hits
+
+The predicate is evaluated once per item, see NP::select_blocks. 
+num_threads 1 (default) runs on the calling thread, 0 uses UPool::NumThreads. 
+Output is in input order and is the same for any num_threads.  
+
+**/
+
+template<typename S, typename P>
+inline int64_t NP::count_if(P predicate, int num_threads) const 
+{
+    assert( is_itemtype<S>() );  // size of type same as item_bytes
+    const S* aa = cvalues<S>();  
+    int64_t ni = num_items(); 
+    std::atomic<int64_t> count(0) ; 
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        int64_t c = 0 ; 
+        for(int64_t i=i0 ; i < i1 ; i++) if(predicate(aa+i)) c += 1 ;  
+        count += c ; 
+    };
+    UPool::ParallelFor( ni, fn, num_threads, 1 << 16 ); 
+    return count ; 
+}
+
+template<typename T, typename P> 
+inline NP* NP::simple_copy_if(P predicate, int num_threads, std::vector<int64_t>* indices ) const 
+{
+    std::vector<std::vector<int64_t>> sel ; 
+    std::vector<int64_t> offset ; 
+    int64_t si = select_blocks<T,P>(sel, offset, predicate, num_threads) ; 
+
+    NP* b = NP::MakeUninitialized<T>(si) ; 
+    copy_selected<T>( b->values<T>(), sel, offset, indices ); 
     return b ; 
 }
 
@@ -2685,23 +3276,15 @@ T: atomic base type use for array, eg int, float, double
 
 **/
 
-
-template<typename T, typename S> 
-inline NP* NP::copy_if(std::function<bool(const S*)> predicate ) const 
+template<typename T, typename S, typename P> 
+inline NP* NP::copy_if(P predicate, int num_threads, std::vector<int64_t>* indices ) const 
 {
     assert( sizeof(S) >= sizeof(T) );  
-    int ni = num_items(); 
-
-    int si = count_if<S>(predicate) ; 
     int sj = sizeof(S) / sizeof(T) ; 
 
-
-    assert( si <= ni ); 
     std::vector<int> sh(shape) ; 
     int nd = sh.size(); 
-
     assert( nd > 0 ); 
-    sh[0] = si ; 
 
     int itemcheck = 1 ; 
     for(int i=1 ; i < nd ; i++) itemcheck *= sh[i] ; 
@@ -2710,21 +3293,16 @@ inline NP* NP::copy_if(std::function<bool(const S*)> predicate ) const
     if(!sj_expect) std::raise(SIGINT) ; 
     assert( sj_expect ); 
 
-    const S* aa = cvalues<S>();  
-
-    NP* b = NP::Make_<T>(sh) ; 
-    S* bb = b->values<S>(); 
+    std::vector<std::vector<int64_t>> sel ; 
+    std::vector<int64_t> offset ; 
+    int64_t si = select_blocks<S,P>(sel, offset, predicate, num_threads) ; 
+    sh[0] = si ; 
 
-    int _si = 0 ; 
-    for(int i=0 ; i < ni ; i++) 
-    {
-        if(predicate(aa+i)) 
-        {
-            memcpy( bb + _si,  aa+i , sizeof(S) ); 
-            _si += 1 ; 
-        }
-    }
-    assert( si == _si ); 
+    std::string b_dtype = descr_<T>::dtype() ; 
+    NP* b = new NP(b_dtype.c_str()) ; 
+    bool zero = false ; 
+    b->set_shape(sh, zero) ; 
+    copy_selected<S>( b->values<S>(), sel, offset, indices ); 
     return b ; 
 }
 
@@ -2751,12 +3329,11 @@ template<typename T, typename S, typename... Args>
 inline NP* NP::flexible_copy_if(std::function<bool(const S*)> predicate, Args ... itemshape ) const 
 {
     assert( sizeof(S) >= sizeof(T) );  
-    int ni = num_items(); 
-
-    int si = count_if<S>(predicate) ; 
     int sj = sizeof(S) / sizeof(T) ; 
 
-    assert( si <= ni ); 
+    std::vector<std::vector<int64_t>> sel ; 
+    std::vector<int64_t> offset ; 
+    int64_t si = select_blocks<S>(sel, offset, predicate, 1) ; 
 
     std::vector<int> itemshape_ = {itemshape...};
     std::vector<int> sh ; 
@@ -2776,23 +3353,11 @@ inline NP* NP::flexible_copy_if(std::function<bool(const S*)> predicate, Args ..
         }
         assert( itemcheck == sj ); 
     }
-    const S* aa = cvalues<S>();  
 
     NP* b = NP::Make_<T>(sh) ; 
-    S* bb = b->values<S>(); 
-
-    int _si = 0 ; 
-    for(int i=0 ; i < ni ; i++) 
-    {
-        if(predicate(aa+i)) 
-        {
-            memcpy( bb + _si,  aa+i , sizeof(S) ); 
-            _si += 1 ; 
-        }
-    }
-    assert( si == _si ); 
-    return b ; 
-}
+    copy_selected<S>( b->values<S>(), sel, offset, nullptr ); 
+    return b ; 
+}
 
 
 
@@ -2869,11 +3434,92 @@ inline NP* NP::Load(const char* dir, const char* reldir, const char* name)
     return Load(path.c_str());
 }
 
+/**
+NP::LoadFortran
+-----------------
+
+As NP::Load but also accepting .npy with fortran_order True, as np.save
+writes for Fortran contiguous arrays. The column-major payload is kept
+as is with NP::fortran_order set : access it with NPView, which has
+column-major strides for such arrays, or NPView::materialize to a C
+order NP. Apart from elementwise copies and NP::save, which keeps the
+layout, NP methods assume C order and give wrong values for such arrays. 
+
+**/
+
+inline NP* NP::LoadFortran(const char* path_)
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    NP* a = new NP() ; 
+    a->allow_fortran_order = true ; 
+    int rc = a->load(path) ; 
+    if(rc == 0) return a ; 
+    delete a ; 
+    return nullptr ; 
+}
+
+/**
+NP::LoadMapped
+----------------
+
+Memory maps the .npy file rather than reading the payload into *data*, 
+see NP::load_mapped. Paths with the NODATA_PREFIX are loaded with NP::Load. 
+
+**/
+
+inline NP* NP::LoadMapped(const char* path_)
+{
+    if(IsNoData(path_)) return Load(path_) ; 
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    NP* a = new NP() ; 
+    int rc = a->load_mapped(path) ; 
+    if(rc != 0) delete a ; 
+    return rc == 0 ? a  : nullptr ; 
+}
+
+inline NP* NP::LoadMapped(const char* dir, const char* name)
+{
+    if(!dir) return nullptr ; 
+    std::string path = U::form_path(dir, name); 
+    return LoadMapped(path.c_str());
+}
+
+/**
+NP::LoadSlice
+---------------
+
+Loads only items [i0,i1) of the first dimension, see NP::load_slice. 
+Negative i0 or i1 count from the end as in python, eg (-10,-1) 
+would be the last ten items excluding the very last. 
+
+**/
+
+inline NP* NP::LoadSlice(const char* path_, int i0, int i1)
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    NP* a = new NP() ; 
+    int rc = a->load_slice(path, i0, i1) ; 
+    if(rc != 0) delete a ; 
+    return rc == 0 ? a  : nullptr ; 
+}
+
+inline NP* NP::LoadSlice(const char* dir, const char* name, int i0, int i1)
+{
+    if(!dir) return nullptr ; 
+    std::string path = U::form_path(dir, name); 
+    return LoadSlice(path.c_str(), i0, i1);
+}
+
 /**
 NP::LoadWide
 --------------
 
 Loads array and widens it to 8 bytes per element if not already wide.
+The file is memory mapped with NP::LoadMapped so the payload is 
+converted (or copied) straight from the page cache into the new array. 
 
 **/
 
@@ -2894,7 +3540,7 @@ inline NP* NP::LoadWide(const char* dir, const char* name)
 inline NP* NP::LoadWide(const char* path)
 {
     if(!path) return nullptr ; 
-    NP* a = NP::Load(path);  
+    NP* a = NP::LoadMapped(path);  
 
     assert( a->uifc == 'f' && ( a->ebyte == 8 || a->ebyte == 4 ));  
     // cannot think of application for doing this with  ints, so restrict to float OR double 
@@ -2911,6 +3557,7 @@ NP::LoadNarrow
 ---------------
 
 Loads array and narrows to 4 bytes per element if not already narrow.
+As NP::LoadWide the conversion reads directly from the file mapping. 
 
 **/
 
@@ -2929,7 +3576,7 @@ inline NP* NP::LoadNarrow(const char* dir, const char* name)
 inline NP* NP::LoadNarrow(const char* path)
 {
     if(!path) return nullptr ; 
-    NP* a = NP::Load(path);  
+    NP* a = NP::LoadMapped(path);  
 
     assert( a->uifc == 'f' && ( a->ebyte == 8 || a->ebyte == 4 ));  
     // cannot think of application for doing this with  ints, so restrict to float OR double 
@@ -3875,6 +4522,151 @@ template<typename T> inline T NP::interp(T x, int item) const
     return y ; 
 }
 
+
+/**
+NP::interp_many
+-----------------
+
+Batched NP::interp giving y[i] = interp<T>(x[i], item) for n values of x,
+with the same results including at and beyond the domain edges.
+See NP::interp_multi for the bin finding and threading.
+
+**/
+
+template<typename T> inline void NP::interp_many(const T* x, T* y, int64_t n, int item, int num_threads) const
+{
+    std::vector<int> jvals = { -1 } ;
+    interp_multi<T>(x, y, n, jvals, item, num_threads );
+}
+
+/**
+NP::interp_multi
+------------------
+
+Following the suggestion in NP::interp the bin of each x is found once
+and reused for all the value columns jvals of the pshaped array, which
+share the domain in the first column. Negative jvals count from the
+last column, so jvals {-1} gives NP::interp. The output y has shape (n, jvals.size()).
+
+The x are processed in blocks of 256 with NP::InterpBins, the blocks
+are spread over UPool threads for large n, NP_THREADS controls the default.
+
+**/
+
+template<typename T> inline void NP::interp_multi(const T* x, T* y, int64_t n, const std::vector<int>& jvals, int item, int num_threads) const
+{
+    int ndim = shape.size() ;
+    assert( ndim == 2 || ndim == 3 );
+    int num_items = ndim == 3 ? shape[0] : 1 ;
+    assert( item < num_items );
+
+    int ni = shape[ndim-2];
+    int nj = shape[ndim-1];
+    assert( ni > 1 );
+    int64_t item_offset = item == -1 ? 0 : int64_t(ni)*nj*item ;
+    const T* vv = cvalues<T>() + item_offset ;
+
+    int nv = jvals.size() ;
+    std::vector<int> jv(nv) ;
+    for(int v=0 ; v < nv ; v++)
+    {
+        jv[v] = jvals[v] < 0 ? nj + jvals[v] : jvals[v] ;
+        assert( jv[v] > 0 && jv[v] < nj );    // 1st column is the domain
+    }
+
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        const int B = 256 ;
+        int lo[B] ;
+        T   fx[B] ;
+        for(int64_t b0=i0 ; b0 < i1 ; b0 += B)
+        {
+            int nb = std::min( int64_t(B), i1 - b0 );
+            InterpBins<T>( vv, ni, nj, x + b0, nb, lo, fx );
+            for(int b=0 ; b < nb ; b++)
+            {
+                int l = lo[b] ;
+                T* yy = y + (b0 + b)*nv ;
+                if( l < 0 )   // beyond domain edge ~l
+                {
+                    for(int v=0 ; v < nv ; v++) yy[v] = vv[nj*(~l)+jv[v]] ;
+                }
+                else
+                {
+                    for(int v=0 ; v < nv ; v++)
+                    {
+                        const T* v0 = vv + nj*l + jv[v] ;
+                        T dy = v0[nj] - v0[0] ;
+                        yy[v] = v0[0] + dy*fx[b] ;
+                    }
+                }
+            }
+        }
+    };
+    UPool::ParallelFor( n, fn, num_threads, 1 << 16 );
+}
+
+template<typename T> inline void NP::interp_multi(T x, T* y, const std::vector<int>& jvals, int item) const
+{
+    interp_multi<T>( &x, y, 1, jvals, item, 1 );
+}
+
+/**
+NP::InterpBins
+----------------
+
+For n values of x finds the domain bin lo[i] with vv[nj*lo] <= x < vv[nj*(lo+1)]
+and, when fx is not nullptr, the fraction fx[i] across it, as NP::interp does. For x at or beyond
+the domain edges lo[i] is ~edge (negative) with edge the index of the
+first or last domain value, which NP::interp returns values of.
+
+Ascending x, as often when evaluating on grids or sorted energies,
+are merge-walked along the domain. Otherwise the search is branchless
+with the same number of steps for all x, done across the block
+one step at a time, which the compiler can vectorize with gathers.
+
+**/
+
+template<typename T> inline void NP::InterpBins(const T* vv, int ni, int nj, const T* x, int n, int* lo, T* fx ) // static
+{
+    bool sorted = true ;
+    for(int i=1 ; i < n ; i++) sorted &= x[i-1] <= x[i] ;
+
+    if(sorted)
+    {
+        int l = 0 ;
+        for(int i=0 ; i < n ; i++)
+        {
+            while( l < ni - 2 && vv[nj*(l+1)] <= x[i] ) l++ ;
+            lo[i] = l ;
+        }
+    }
+    else
+    {
+        for(int i=0 ; i < n ; i++) lo[i] = 0 ;
+        for(int m=ni-1 ; m > 1 ; m -= m/2)
+        {
+            int h = m/2 ;
+            for(int i=0 ; i < n ; i++) lo[i] = vv[nj*(lo[i]+h)] <= x[i] ? lo[i] + h : lo[i] ;
+        }
+    }
+
+    const T d0 = vv[0] ;
+    const T d1 = vv[nj*(ni-1)] ;
+    if(fx) for(int i=0 ; i < n ; i++)
+    {
+        int l = lo[i] ;
+        fx[i] = (x[i] - vv[nj*l])/(vv[nj*(l+1)] - vv[nj*l]) ;
+    }
+    for(int i=0 ; i < n ; i++)
+    {
+        bool below = x[i] <= d0 ;
+        bool above = x[i] >= d1 ;
+        int edge = below ? ~0 : ~(ni-1) ;
+        lo[i] = below || above ? edge : lo[i] ;
+    }
+}
+
 /**
 NP::interpHD
 --------------
@@ -4116,6 +4908,324 @@ template<typename T> inline T NP::_combined_interp(const T* vv, int niv, T x) co
     return y ; 
 }
 
+
+/**
+NP::combined_interp_many
+--------------------------
+
+Batched NP::combined_interp_3 and NP::combined_interp_5 for n queries
+giving y[q] the same as one call per query. The item indices of query q are
+idx[q*nidx+0..nidx-1] with nidx = ndim - 2, so (i) for 3D and (i,j,k) for 5D
+NP::Combine arrays, and the domain value is x[q].
+
+Blocks of 1024 queries are grouped by item with a counting sort that keeps
+query order within each item, so each property has its item count decoded
+once per group and the bins of the group are found together by
+NP::InterpBins, which walks ascending runs of x. Blocks stay in cache
+and are spread over UPool threads for large n.
+
+**/
+
+template<typename T> inline void NP::combined_interp_many(const int* idx, const T* x, T* y, int64_t n, int num_threads) const
+{
+    int ndim = shape.size() ;
+    assert( ndim >= 3 && shape[ndim-1] >= 2 && shape[ndim-2] > 1 );
+    int nidx = ndim - 2 ;
+    int nj = shape[ndim-1] ;
+    int jval = nj - 1 ;
+    int stride = shape[ndim-2]*nj ;
+    int num_prop = size/stride ;
+    const T* aa = cvalues<T>() ;
+    const int* sh = shape.data() ;
+
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        const int B = 1024 ;
+        std::vector<int> count(num_prop, 0) ;   // only touched entries are reset after each block
+        int ip[B], ord[B], lo[B], touched[B] ;
+        T   xb[B] ;
+        for(int64_t b0=i0 ; b0 < i1 ; b0 += B)
+        {
+            int nb = std::min( int64_t(B), i1 - b0 ) ;
+            int nt = 0 ;
+            for(int b=0 ; b < nb ; b++)
+            {
+                const int* qi = idx + (b0 + b)*nidx ;
+                int p = 0 ;
+                bool ok = true ;
+                for(int d=0 ; d < nidx ; d++)
+                {
+                    ok &= unsigned(qi[d]) < unsigned(sh[d]) ;
+                    p = p*sh[d] + qi[d] ;
+                }
+                if(!ok) std::cerr << "NP::combined_interp_many query " << b0 + b << " item index out of range for " << sstr() << std::endl ;
+                assert( ok );
+                ip[b] = p ;
+                if( count[p]++ == 0 ) touched[nt++] = p ;
+            }
+
+            int start = 0 ;
+            for(int t=0 ; t < nt ; t++)
+            {
+                int c = count[touched[t]] ;
+                count[touched[t]] = start ;
+                start += c ;
+            }
+            for(int b=0 ; b < nb ; b++) ord[count[ip[b]]++] = b ;    // grouped by property, query order within
+
+            int s = 0 ;
+            for(int t=0 ; t < nt ; t++)
+            {
+                int p = touched[t] ;
+                int e = count[p] ;
+                count[p] = 0 ;
+                const T* vv = aa + int64_t(p)*stride ;
+                int ni = nview::int_from<T>( vv[stride-1] ) ;
+                for(int k=s ; k < e ; k++) xb[k] = x[b0 + ord[k]] ;
+                if( ni < 2 )   // single value property : always the edge value, as NP::_combined_interp
+                {
+                    for(int k=s ; k < e ; k++) y[b0 + ord[k]] = vv[jval] ;
+                    s = e ;
+                    continue ;
+                }
+                InterpBins<T>( vv, ni, nj, xb + s, e - s, lo + s, nullptr );
+                for(int k=s ; k < e ; k++)   // edge selection without branches as x beyond domains are common
+                {
+                    int l = lo[k] ;
+                    int le = l < 0 ? ~l : l ;
+                    int li = std::min( le, ni - 2 ) ;
+                    T dy = vv[nj*(li+1)+jval] - vv[nj*li+jval] ;
+                    T dx = vv[nj*(li+1)] - vv[nj*li] ;
+                    T yi = vv[nj*li+jval] + dy*(xb[k]-vv[nj*li])/dx ;
+                    T ye = vv[nj*le+jval] ;
+                    y[b0 + ord[k]] = l < 0 ? ye : yi ;
+                }
+                s = e ;
+            }
+        }
+    };
+    UPool::ParallelFor( n, fn, num_threads, 1 << 16 );
+}
+
+template<typename T> inline NP* NP::combined_interp_many(const int* idx, const T* x, int64_t n, int num_threads) const
+{
+    NP* y = new NP(dtype, n) ;
+    combined_interp_many<T>( idx, x, y->values<T>(), n, num_threads );
+    return y ;
+}
+
+
+/**
+NP::MakeCompiledProperty
+--------------------------
+
+NP::interp, NP::_combined_interp and NP::pdomain binary search the irregular
+domain of each property on every call. This resamples properties onto
+uniform domain grids, fine enough for the linear interpolation on the grid
+to be within *tolerance* of linear interpolation of the source, with the
+line of each grid cell precomputed so that a lookup with NP::compiled_interp
+is a cell index from (x-x0)*inv_dx and one multiply-add.
+
+src
+    pshaped (ni,2) property, or properties with shape (...,ni,2) such as
+    from NP::Combine. With annotated:true (the NP::Combine default) the number
+    of domain values of each property is read from the last column, as
+    NP::_combined_interp does, otherwise all ni are used.
+
+tolerance
+    maximum absolute difference between compiled and source interpolation,
+    the number of cells of each property is doubled from 16 until met or max_cells
+
+Returned array has the item dimensions of src and (2+max_cells_used, 2) per property:
+
++-------+----------------+-----------------+
+| row 0 | x0             | x1              |
+| row 1 | inv_dx         | number of cells |
+| row 2+| intercept      | slope           |
++-------+----------------+-----------------+
+
+Rows beyond the number of cells repeat the last cell. As the difference
+of two piecewise linear functions is largest at their knots, the error
+is evaluated exactly at the source domain values using the actual lookup.
+The largest error over the properties is in metadata "compiled_max_err"
+and the array can be saved into an NPFold next to the source.
+
+**/
+
+template<typename T> inline NP* NP::MakeCompiledProperty(const NP* src, T tolerance, int max_cells, bool annotated ) // static
+{
+    int ndim = src->shape.size() ;
+    assert( ndim >= 2 && src->shape[ndim-1] == 2 && src->shape[ndim-2] > 1 );
+    assert( src->ebyte == sizeof(T) );
+    assert( max_cells >= 16 );
+    if( ndim == 2 ) annotated = false ;
+
+    int nl = src->shape[ndim-2] ;
+    int stride = nl*2 ;
+    int num_prop = src->size/stride ;
+
+    std::vector<std::vector<T>> cells(num_prop) ;
+    std::vector<T> head(num_prop*4) ;
+    T max_err = 0 ;
+    int num_fail = 0 ;
+
+    for(int p=0 ; p < num_prop ; p++)
+    {
+        const T* vv = src->cvalues<T>() + p*stride ;
+        int ni = annotated ? nview::int_from<T>( vv[stride-1] ) : nl ;
+        assert( ni > 1 && ni <= nl );
+        T x0 = vv[0] ;
+        T x1 = vv[2*(ni-1)] ;
+        assert( x1 > x0 );
+
+        std::vector<T> xk(ni) ;          // knots of the source, where errors are largest
+        std::vector<T> yk(ni) ;
+        for(int i=0 ; i < ni ; i++) xk[i] = vv[2*i] ;
+        InterpSource<T>( vv, ni, xk.data(), yk.data(), ni );
+
+        T err = 0 ;
+        for(int n=16 ; n <= max_cells ; n = std::min(2*n, max_cells) )
+        {
+            std::vector<T> xg(n+1), yg(n+1) ;
+            double dx = (double(x1) - double(x0))/n ;
+            for(int i=0 ; i <= n ; i++) xg[i] = i == n ? x1 : T(double(x0) + i*dx) ;
+            InterpSource<T>( vv, ni, xg.data(), yg.data(), n+1 );
+
+            std::vector<T>& cc = cells[p] ;
+            cc.resize(2*n) ;
+            for(int i=0 ; i < n ; i++)
+            {
+                double slope = (double(yg[i+1]) - double(yg[i]))/(double(xg[i+1]) - double(xg[i])) ;
+                cc[2*i+0] = T(double(yg[i]) - slope*double(xg[i])) ;
+                cc[2*i+1] = T(slope) ;
+            }
+            T* hh = head.data() + 4*p ;
+            hh[0] = x0 ;
+            hh[1] = x1 ;
+            hh[2] = T(n/(double(x1) - double(x0))) ;
+            hh[3] = T(n) ;
+
+            err = 0 ;
+            for(int i=0 ; i < ni ; i++)
+            {
+                T y = CompiledInterp<T>( hh, cc.data(), xk[i] ) ;
+                err = std::max( err, T(std::abs( y - yk[i] )) ) ;
+            }
+            if( err <= tolerance || n == max_cells ) break ;
+        }
+        if( err > tolerance ) num_fail += 1 ;
+        max_err = std::max( max_err, err ) ;
+    }
+
+    int nc = 0 ;
+    for(int p=0 ; p < num_prop ; p++) nc = std::max( nc, int(cells[p].size()/2) ) ;
+
+    std::vector<int> sh(src->shape) ;
+    sh[ndim-2] = 2 + nc ;
+    NP* dst = new NP(src->dtype, sh) ;
+    T* dd = dst->values<T>() ;
+    for(int p=0 ; p < num_prop ; p++)
+    {
+        T* d = dd + p*(2+nc)*2 ;
+        const std::vector<T>& cc = cells[p] ;
+        int n = cc.size()/2 ;
+        for(int i=0 ; i < 4 ; i++) d[i] = head[4*p+i] ;
+        for(int i=0 ; i < nc ; i++)
+        {
+            int j = std::min(i, n-1) ;
+            d[4+2*i+0] = cc[2*j+0] ;
+            d[4+2*i+1] = cc[2*j+1] ;
+        }
+    }
+    dst->set_meta<T>("compiled_tolerance", tolerance );
+    dst->set_meta<T>("compiled_max_err", max_err );
+    dst->set_meta<int>("compiled_max_cells", nc );
+
+    if(num_fail > 0) std::cerr
+        << "NP::MakeCompiledProperty"
+        << " tolerance " << tolerance
+        << " not met by " << num_fail << " of " << num_prop
+        << " properties with max_cells " << max_cells
+        << " max_err " << max_err
+        << std::endl
+        ;
+    return dst ;
+}
+
+/**
+NP::InterpSource
+    interpolation of (ni,2) source property values vv, same as NP::interp
+**/
+
+template<typename T> inline void NP::InterpSource(const T* vv, int ni, const T* x, T* y, int n ) // static
+{
+    std::vector<int> lo(n) ;
+    std::vector<T>   fx(n) ;
+    InterpBins<T>( vv, ni, 2, x, n, lo.data(), fx.data() );
+    for(int i=0 ; i < n ; i++)
+    {
+        int l = lo[i] ;
+        y[i] = l < 0 ? vv[2*(~l)+1] : vv[2*l+1] + (vv[2*l+3] - vv[2*l+1])*fx[i] ;
+    }
+}
+
+/**
+NP::CompiledInterp
+    lookup from head (x0, x1, inv_dx, num_cells) and cells (intercept, slope),
+    x beyond the domain is clamped to it, so values beyond are those at the edges as with NP::interp
+**/
+
+template<typename T> inline T NP::CompiledInterp(const T* hh, const T* cc, T x ) // static
+{
+    T xc = std::min( std::max( x, hh[0] ), hh[1] ) ;
+    int c = std::min( int((xc - hh[0])*hh[2]), int(hh[3]) - 1 ) ;
+    return cc[2*c+1]*xc + cc[2*c] ;
+}
+
+/**
+NP::compiled_interp NP::compiled_interp_many
+-----------------------------------------------
+
+Lookups on arrays from NP::MakeCompiledProperty, iprop is the flattened
+item index, eg i*nj*nk+j*nk+k for a compiled (ni,nj,nk,...) NP::Combine stack
+as with NP::combined_interp_5. The batch loop has no data dependent
+branches so it vectorizes, large n are spread over UPool threads.
+
+**/
+
+template<typename T> inline T NP::compiled_interp(int iprop, T x) const
+{
+    int ndim = shape.size() ;
+    int stride = shape[ndim-2]*shape[ndim-1] ;
+    assert( iprop >= 0 && int64_t(iprop)*stride < size );
+    const T* hh = cvalues<T>() + int64_t(iprop)*stride ;
+    return CompiledInterp<T>( hh, hh + 4, x );
+}
+
+template<typename T> inline void NP::compiled_interp_many(int iprop, const T* x, T* y, int64_t n, int num_threads ) const
+{
+    int ndim = shape.size() ;
+    int stride = shape[ndim-2]*shape[ndim-1] ;
+    assert( iprop >= 0 && int64_t(iprop)*stride < size );
+    const T* hh = cvalues<T>() + int64_t(iprop)*stride ;
+    const T* cc = hh + 4 ;
+    const T x0 = hh[0] ;
+    const T x1 = hh[1] ;
+    const T inv_dx = hh[2] ;
+    const int nc = int(hh[3]) ;
+
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            T xc = std::min( std::max( x[i], x0 ), x1 ) ;
+            int c = std::min( int((xc - x0)*inv_dx), nc - 1 ) ;
+            y[i] = cc[2*c+1]*xc + cc[2*c] ;
+        }
+    };
+    UPool::ParallelFor( n, fn, num_threads, 1 << 16 );
+}
+
 /**
 NP::FractionalRange
 ---------------------
@@ -4730,10 +5840,19 @@ template std::string NP::GetMeta<std::string>(const std::string& , const char*,
 
 
 
+/**
+NP::get_meta
+--------------
+
+Same results as NP::GetMeta on the meta string, using the meta_idx 
+key -> value index which avoids parsing meta for every access. 
+
+**/
+
 template<typename T> inline T NP::get_meta(const char* key, T fallback) const 
 {
     if(meta.empty()) return fallback ; 
-    return GetMeta<T>( meta.c_str(), key, fallback ); 
+    return meta_idx.get<T>( meta, key, fallback ); 
 }
 
 template int      NP::get_meta<int>(const char*, int ) const ; 
@@ -4742,6 +5861,18 @@ template float    NP::get_meta<float>(const char*, float ) const ;
 template double   NP::get_meta<double>(const char*, double ) const ; 
 template std::string NP::get_meta<std::string>(const char*, std::string ) const ; 
 
+inline std::string NP::get_meta_string(const char* key) const
+{
+    std::string value ; 
+    if(!meta.empty()) meta_idx.get(meta, key, value) ; 
+    return value ; 
+}
+
+inline bool NP::has_meta_key(const char* key) const
+{
+    return meta.empty() ? false : meta_idx.has(meta, key) ; 
+}
+
 
 /**
 NP::SetMeta
@@ -4802,12 +5933,13 @@ NP::set_meta
 --------------
 
 A preexisting keyed k:v pair is changed by this otherwise if there is no 
-such pre-existing key a new k:v pair is added. 
+such pre-existing key a new k:v pair is added. The meta string
+is edited in place as NP::SetMeta would without reparsing it.  
 
 **/
 template<typename T> inline void NP::set_meta(const char* key, T value)  
 {
-    SetMeta(meta, key, value); 
+    meta_idx.set(meta, key, value); 
 }
 
 template void     NP::set_meta<uint64_t>(const char*, uint64_t ); 
@@ -4821,7 +5953,7 @@ template void     NP::set_meta<std::string>(const char*, std::string );
 
 template<typename T> inline void NP::set_meta_kv(const std::vector<std::pair<std::string, T>>& kvs )
 {
-    SetMetaKV(meta, kvs ); 
+    meta_idx.set_kv(meta, kvs ); 
 }
 template<typename T> inline void NP::SetMetaKV( std::string& meta, const std::vector<std::pair<std::string, T>>& kvs ) // static
 {
@@ -4860,7 +5992,7 @@ inline void NP::SetMetaKV_(
 
 inline void NP::setMetaKV_( const std::vector<std::string>& keys,  const std::vector<std::string>& vals )
 {
-    SetMetaKV_(meta, keys, vals); 
+    meta_idx.set_kv(meta, keys, vals); 
 }
 
 
@@ -5455,8 +6587,8 @@ NP::Memcmp
 
 inline int NP::Memcmp(const NP* a, const NP* b ) // static
 {
-    unsigned a_bytes = a->arr_bytes() ; 
-    unsigned b_bytes = b->arr_bytes() ; 
+    size_t a_bytes = a->arr_bytes() ; 
+    size_t b_bytes = b->arr_bytes() ; 
     return a_bytes == b_bytes ? memcmp(a->bytes(), b->bytes(), a_bytes) : -1 ; 
 }
 
@@ -5479,14 +6611,14 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
 
     NP* a0 = aa[0] ; 
     
-    unsigned nv0 = a0->num_itemvalues() ; 
+    size_t nv0 = a0->num_itemvalues() ; 
     const char* dtype0 = a0->dtype ; 
 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         NP* a = aa[i] ;
 
-        unsigned nv = a->num_itemvalues() ; 
+        size_t nv = a->num_itemvalues() ; 
         bool compatible = nv == nv0 && strcmp(dtype0, a->dtype) == 0 ; 
         if(!compatible) 
             std::cout 
@@ -5502,8 +6634,9 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
         if(VERBOSE) std::cout << "NP::Concatenate " << std::setw(3) << i << " " << a->desc() << " nv " << nv << std::endl ; 
     }
 
-    unsigned ni_total = 0 ; 
+    int64_t ni_total = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++) ni_total += aa[i]->shape[0] ; 
+    assert( ni_total <= std::numeric_limits<int>::max() );  // first dimension extent must fit shape int 
     if(VERBOSE) std::cout << "NP::Concatenate ni_total " << ni_total << std::endl ; 
 
     std::vector<int> comb_shape ; 
@@ -5511,15 +6644,16 @@ inline NP* NP::Concatenate(const std::vector<NP*>& aa)  // static
     comb_shape[0] = ni_total ; 
 
     NP* c = new NP(a0->dtype); 
-    c->set_shape(comb_shape); 
+    bool zero = false ;   // every byte is copied from the inputs 
+    c->set_shape(comb_shape, zero); 
     if(VERBOSE) std::cout << "NP::Concatenate c " << c->desc() << std::endl ; 
 
-    unsigned offset_bytes = 0 ; 
+    size_t offset_bytes = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         NP* a = aa[i]; 
-        unsigned a_bytes = a->arr_bytes() ; 
-        memcpy( c->data.data() + offset_bytes ,  a->data.data(),  a_bytes ); 
+        size_t a_bytes = a->arr_bytes() ; 
+        memcpy( c->bytes() + offset_bytes ,  a->bytes(),  a_bytes ); 
         offset_bytes += a_bytes ;  
         a->clear(); // HUH: THATS A BIT IMPOLITE ASSUMING CALLER DOESNT WANT TO USE INPUTS
     }
@@ -5608,7 +6742,7 @@ inline NP* NP::Combine(const std::vector<const NP*>& aa, bool annotate, const NP
     assert( ldim0 == 2 && "last dimension must currently be 2"); 
 
     NP* c = new NP(a0->dtype, aa.size(), width, ldim0 ); 
-    unsigned item_bytes = c->item_bytes(); 
+    size_t item_bytes = c->item_bytes(); 
 
     if(VERBOSE) std::cout 
         << "NP::Combine"
@@ -5622,15 +6756,15 @@ inline NP* NP::Combine(const std::vector<const NP*>& aa, bool annotate, const NP
         ; 
 
     assert( item_bytes % ebyte0 == 0 ); 
-    unsigned item_values = item_bytes/ebyte0 ; 
+    size_t item_values = item_bytes/ebyte0 ; 
 
-    unsigned offset_bytes = 0 ; 
+    size_t offset_bytes = 0 ; 
     for(unsigned i=0 ; i < aa.size() ; i++)
     {
         const NP* a = aa[i]; 
-        unsigned a_bytes = a->arr_bytes() ; 
+        size_t a_bytes = a->arr_bytes() ; 
 
-        memcpy( c->data.data() + offset_bytes ,  a->data.data(),  a_bytes ); 
+        memcpy( c->bytes() + offset_bytes ,  a->bytes(),  a_bytes ); 
 
         // NB: a_bytes may be less than item_bytes 
         // effectively are padding to allow ragged arrays to be handled together
@@ -5742,10 +6876,13 @@ NP::load
 ----------
 
 Formerly read an arbitrary initial buffer size, 
-now reading up to first newline, which marks the 
-end of the header, then adding the newline to the 
-header string for correctness as getline consumes the 
-newline from the stream without returning it. 
+then read up to first newline with getline. 
+Now NPU::_read_header reads the preamble and HEADER_LEN
+field and then exactly that number of header bytes. 
+This handles format 1.0 (2 byte HEADER_LEN) and 
+format 2.0/3.0 (4 byte HEADER_LEN) headers and avoids 
+misreading when the HEADER_LEN bytes happen to contain 
+a newline character. 
 
 **/
 
@@ -5767,10 +6904,14 @@ inline int NP::load(const char* _path)
         return 1 ; 
     }
 
-    std::getline(fp, _hdr );   
-    _hdr += '\n' ; 
+    bool hdr_ok = NPU::_read_header(fp, _hdr ); 
+    if(!hdr_ok)
+    {
+        std::cerr << "NP::load Failed to read npy header from path " << path << std::endl ; 
+        return 1 ; 
+    }
 
-    decode_header(); 
+    if(!decode_header()) return 1 ; 
 
     if(nodata)
     {
@@ -5781,15 +6922,435 @@ inline int NP::load(const char* _path)
         fp.read(bytes(), arr_bytes() );
     }
 
-    load_meta( path ); 
-    load_names( path ); 
-    load_labels( path ); 
+    if(load_embedded(fp, hdr_bytes() + arr_bytes()) != 0) load_sidecars(path) ; 
+    if(!nodata && !KeepForeign()) to_native(); 
 
     if(VERBOSE) std::cerr << "] NP::load " << path << std::endl ; 
     return 0 ; 
 }
 
 
+/**
+NP::load_mapped
+-----------------
+
+Instead of reading the payload into *data* the file is mmap-ed and
+NP::bytes, NP::values, NP::cvalues point into the mapping. 
+Processes on the same node loading the same file then share the pages 
+of the OS page cache and no copy is made at load.  
+
+The mapping is MAP_PRIVATE of a file opened read only : the file is 
+never modified, but writing into the array is still permitted and 
+copies only the touched pages (copy-on-write). 
+
+The mapping is unmapped when the NP is destroyed or by NP::unmap. 
+Copies of the NP do not share it, the copy constructor copies 
+the mapped payload into *data*. 
+Any change that reallocates the payload (NP::init, NP::clear etc..)
+also unmaps. 
+
+Saving a mapped array over its own file with NP::save would truncate 
+the file beneath the mapping, so NP::save_ refuses, see NP::is_mapped_file. 
+Save elsewhere or save an NP::MakeCopy instead. 
+
+Headers written by NPU::_make_header are padded such that the payload 
+starts 64-byte aligned within the page aligned mapping. 
+
+**/
+
+inline int NP::load_mapped(const char* path)
+{
+    nodata = false ; 
+    lpath = path ;  
+    lfold = U::DirName(path); 
+
+    std::ifstream fp(path, std::ios::in|std::ios::binary);
+    if(fp.fail() || !NPU::_read_header(fp, _hdr))
+    {
+        std::cerr << "NP::load_mapped Failed to read npy header from path " << path << std::endl ; 
+        return 1 ; 
+    }
+    fp.close(); 
+
+    int fd = open(path, O_RDONLY); 
+    struct stat st ; 
+    if( fd < 0 || fstat(fd, &st) != 0 )
+    {
+        std::cerr << "NP::load_mapped Failed to open path " << path << std::endl ; 
+        if(fd > -1) close(fd); 
+        return 1 ; 
+    }
+    size_t file_bytes = st.st_size ; 
+    void* base = mmap(nullptr, file_bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0 ); 
+    close(fd);   // mapping keeps its own reference to the file 
+
+    if( base == MAP_FAILED )
+    {
+        std::cerr << "NP::load_mapped Failed to mmap path " << path << std::endl ; 
+        return 1 ; 
+    }
+
+    data.clear(); 
+    data.shrink_to_fit(); 
+    _map = std::shared_ptr<char>( (char*)base, [file_bytes](char* p){ munmap(p, file_bytes) ; } ); 
+    _mapped = _map.get() + hdr_bytes() ;  
+
+    if(!decode_header())   // does not resize data when _mapped
+    {
+        _mapped = nullptr ; 
+        _map.reset(); 
+        return 1 ; 
+    }
+
+    bool complete = hdr_bytes() + arr_bytes() <= file_bytes ; 
+    if(!complete)
+    {
+        std::cerr 
+            << "NP::load_mapped TRUNCATED FILE " << path 
+            << " file_bytes " << file_bytes 
+            << " hdr_bytes " << hdr_bytes() 
+            << " arr_bytes " << arr_bytes() 
+            << std::endl
+            ; 
+        unmap(); 
+        return 1 ; 
+    }
+
+    size_t payload_end = hdr_bytes() + arr_bytes() ; 
+    if(load_embedded_(_map.get() + payload_end, file_bytes - payload_end) != 0) load_sidecars(path) ; 
+    if(!KeepForeign()) to_native();   // copy-on-write of every page when foreign  
+    return 0 ; 
+}
+
+/**
+NP::load_slice
+----------------
+
+Parses the header and then with pread reads only the bytes 
+of items [i0,i1) from their offset within the file, 
+avoiding reading the full payload when only a few items 
+of a large array are needed. The metadata sidecars are loaded
+as with NP::load, names with one entry per item are sliced together 
+with the array. The resulting array shape has first dimension i1-i0.
+
+**/
+
+inline int NP::load_slice(const char* path, int i0_, int i1_)
+{
+    nodata = false ; 
+    lpath = path ;  
+    lfold = U::DirName(path); 
+
+    std::ifstream fp(path, std::ios::in|std::ios::binary);
+    if(fp.fail() || !NPU::_read_header(fp, _hdr))
+    {
+        std::cerr << "NP::load_slice Failed to read npy header from path " << path << std::endl ; 
+        return 1 ; 
+    }
+
+    std::vector<int> file_shape ; 
+    std::string descr ; 
+    bool file_fortran_order = false ; 
+    NPU::parse_header( file_shape, descr, uifc, ebyte, file_fortran_order, _hdr ) ; 
+    dtype = strdup(descr.c_str());  
+    if(file_fortran_order && file_shape.size() > 1)
+    {
+        std::cerr << "NP::load_slice items of fortran_order arrays are not contiguous, use NP::Load and NPView " << path << std::endl ; 
+        return 1 ; 
+    }
+    if(file_shape.empty())
+    {
+        std::cerr << "NP::load_slice 0-d arrays have no items to slice, use NP::Load " << path << std::endl ; 
+        return 1 ; 
+    }
+
+    int ni = file_shape.size() > 0 ? file_shape[0] : 0 ; 
+    int i0 = i0_ < 0 ? ni + i0_ : i0_ ; 
+    int i1 = i1_ < 0 ? ni + i1_ : i1_ ; 
+    bool valid = 0 <= i0 && i0 <= i1 && i1 <= ni ; 
+    if(!valid)
+    {
+        std::cerr 
+            << "NP::load_slice INVALID ITEM RANGE " 
+            << " i0_ " << i0_ << " i1_ " << i1_ 
+            << " i0 " << i0 << " i1 " << i1 
+            << " ni " << ni << " path " << path 
+            << std::endl 
+            ;
+        return 1 ; 
+    }
+
+    size_t file_hdr_bytes = _hdr.size() ; 
+    size_t file_item_bytes = NPS::itemsize(file_shape)*ebyte ;  
+
+    shape = file_shape ; 
+    shape[0] = i1 - i0 ;  
+    size = NPS::size(shape) ; 
+    unmap(); 
+    data.resize(size*ebyte); 
+    _hdr = make_header();   // header for the sliced shape 
+
+    int fd = open(path, O_RDONLY); 
+    if( fd < 0 )
+    {
+        std::cerr << "NP::load_slice Failed to open path " << path << std::endl ; 
+        return 1 ; 
+    }
+
+    char* dst = bytes() ; 
+    size_t remaining = arr_bytes() ; 
+    off_t offset = file_hdr_bytes + size_t(i0)*file_item_bytes ; 
+    while( remaining > 0 )
+    {
+        ssize_t n = pread(fd, dst, remaining, offset ); 
+        if( n <= 0 ) break ;   // error or unexpected end of file 
+        dst += n ; 
+        offset += n ; 
+        remaining -= n ; 
+    }
+    close(fd); 
+
+    if( remaining > 0 )
+    {
+        std::cerr << "NP::load_slice TRUNCATED FILE " << path << " missing bytes " << remaining << std::endl ; 
+        return 1 ; 
+    }
+
+    size_t payload_end = file_hdr_bytes + size_t(ni)*file_item_bytes ; 
+    if(load_embedded(fp, payload_end) != 0) load_sidecars(path) ; 
+    if(!KeepForeign()) to_native(); 
+
+    if( int(names.size()) == ni ) names = std::vector<std::string>( names.begin() + i0, names.begin() + i1 ) ; // per-item names 
+
+    return 0 ; 
+}
+
+inline bool NP::is_mapped() const 
+{
+    return _mapped != nullptr ; 
+}
+
+/**
+NP::is_mapped_file
+--------------------
+
+Returns true when this array is mapped from the file at *path*, 
+comparing device and inode so that different spellings of the path 
+are detected. 
+
+**/
+
+inline bool NP::is_mapped_file(const char* path) const 
+{
+    if(_mapped == nullptr) return false ; 
+    struct stat ps ; 
+    struct stat ls ; 
+    if( stat(path, &ps) != 0 || stat(lpath.c_str(), &ls) != 0 ) return false ; 
+    return ps.st_dev == ls.st_dev && ps.st_ino == ls.st_ino ; 
+}
+
+/**
+NP::unmap
+----------
+
+Drops this NP reference to the mapping, leaving empty *data*. 
+Used prior to reallocating the payload, to release a mapped 
+array use NP::clear which also sets the first dimension to zero.
+To keep the values use NP::MakeCopy prior to this.  
+
+**/
+
+inline void NP::unmap()
+{
+    _mapped = nullptr ; 
+    _map.reset(); 
+}
+
+/**
+NP::interleave
+----------------
+
+Sets the memory policy of the whole pages of the payload to interleave 
+across the online NUMA nodes, using the mbind syscall directly to avoid 
+a libnuma dependency. This must be done before the pages are touched, 
+see NP::MakeNUMA. Returns non-zero when not possible. 
+
+**/
+
+inline int NP::interleave()
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    uint64_t mask = NUMANodeMask() ; 
+    uintptr_t page = sysconf(_SC_PAGESIZE) ; 
+    uintptr_t p0 = ( uintptr_t(bytes()) + page - 1 )/page*page ; 
+    uintptr_t p1 = uintptr_t(bytes()) + arr_bytes() ; 
+    if( mask == 0 || p0 >= p1 ) return 1 ; 
+
+    const int MPOL_INTERLEAVE_ = 3 ;  // from linux/mempolicy.h 
+    long rc = syscall(SYS_mbind, (void*)p0, p1 - p0, MPOL_INTERLEAVE_, &mask, 8*sizeof(mask) + 1, 0 ); 
+    if(rc != 0 && VERBOSE) std::cerr << "NP::interleave mbind FAILED errno " << errno << std::endl ; 
+    return rc == 0 ? 0 : 1 ; 
+#else
+    return 1 ; 
+#endif
+}
+
+/**
+NP::NUMANodeMask
+------------------
+
+Bitmask of online NUMA nodes parsed from eg "0-1" or "0,2-3", zero when unknown. 
+
+**/
+
+inline uint64_t NP::NUMANodeMask() // static
+{
+    std::ifstream fp("/sys/devices/system/node/online") ; 
+    std::string line ; 
+    if(fp.fail() || !std::getline(fp, line)) return 0 ; 
+
+    uint64_t mask = 0 ; 
+    std::vector<std::string> elem ; 
+    U::Split(line.c_str(), ',', elem ); 
+    for(unsigned i=0 ; i < elem.size() ; i++)
+    {
+        size_t pos = elem[i].find('-') ; 
+        int n0 = std::atoi(elem[i].c_str()) ; 
+        int n1 = pos == std::string::npos ? n0 : std::atoi(elem[i].c_str() + pos + 1) ; 
+        for(int n=n0 ; n <= n1 && n < 64 ; n++) mask |= uint64_t(1) << n ; 
+    }
+    return mask ; 
+}
+
+/**
+NP::load_data
+---------------
+
+Upgrades a nodata array, loaded with NP::NODATA_PREFIX path 
+or from an NPFold manifest, into a full array by reading the payload 
+from *lpath*. The header is read again and must match the shape, dtype 
+and fortran_order already loaded, to detect the file being changed in the meantime. 
+Metadata, names and labels loaded with the header are unchanged. 
+
+**/
+
+inline int NP::load_data()
+{
+    if(!nodata) return 0 ; 
+    std::ifstream fp(lpath.c_str(), std::ios::in|std::ios::binary);
+    std::string hdr ; 
+    bool hdr_ok = !fp.fail() && NPU::_read_header(fp, hdr) ; 
+
+    std::vector<int> hdr_shape ; 
+    std::string hdr_descr ; 
+    char hdr_uifc ; 
+    int hdr_ebyte ; 
+    bool hdr_fortran_order = false ; 
+    if(hdr_ok) NPU::parse_header( hdr_shape, hdr_descr, hdr_uifc, hdr_ebyte, hdr_fortran_order, hdr ) ; 
+    bool foreign_file = hdr_ok && hdr_descr.compare(dtype) != 0 && NPU::_make_native(hdr_descr.c_str()).compare(dtype) == 0 ;  // swapped by earlier load_data 
+    bool same = hdr_ok && hdr_shape == shape && hdr_fortran_order == fortran_order && ( hdr_descr.compare(dtype) == 0 || foreign_file ) ; 
+    if(!same)
+    {
+        std::cerr << "NP::load_data Failed to read npy header or header changed from path " << lpath << std::endl ; 
+        return 1 ; 
+    }
+    bool order_expect = !hdr_fortran_order || hdr_shape.size() < 2 || allow_fortran_order ; 
+    if(!order_expect)
+    {
+        std::cerr << "NP::load_data fortran_order payload requires NP::LoadFortran and NPView access " << lpath << std::endl ; 
+        return 1 ; 
+    }
+    _hdr = hdr ; 
+    nodata = false ; 
+    data.resize(size*ebyte) ; 
+    fp.read(bytes(), arr_bytes() );
+    if(fp.fail())
+    {
+        std::cerr << "NP::load_data Failed to read payload from path " << lpath << std::endl ; 
+        release_data(); 
+        return 1 ; 
+    }
+    if(foreign_file)
+    {
+        _byteswap() ; 
+        _hdr = make_header(); 
+    }
+    else if(!KeepForeign())
+    {
+        to_native(); 
+    }
+    return 0 ; 
+}
+
+inline bool NP::KeepForeign() // static
+{
+    return getenv(NP_KEEP_FOREIGN) != nullptr ; 
+}
+
+inline bool NP::is_native() const 
+{
+    return NPU::_is_native(dtype) ; 
+}
+
+/**
+NP::to_native
+---------------
+
+Swaps a foreign byte order payload, such as '>f8' from big-endian 
+writers, into native order in place and changes dtype and header 
+accordingly. Returns 0 when the payload is (now) native and 1 
+for nodata arrays, which are swapped when NP::load_data reads them. 
+
+**/
+
+inline int NP::to_native(int num_threads)
+{
+    if(is_native()) return 0 ; 
+    if(nodata) return 1 ; 
+    _byteswap(num_threads) ; 
+    std::string descr = NPU::_make_native(dtype) ; 
+    dtype = strdup(descr.c_str()) ; 
+    _hdr = make_header(); 
+    return 0 ; 
+}
+
+/**
+NP::_byteswap
+---------------
+
+Reverses the byte order of every element without changing dtype, 
+splitting large payloads between UPool threads. Complex elements
+are swapped as pairs of real values. 
+
+**/
+
+inline void NP::_byteswap(int num_threads)
+{
+    int width = uifc == 'c' ? ebyte/2 : ebyte ; 
+    if(width < 2) return ; 
+    int64_t num = arr_bytes()/width ; 
+    char* p = bytes() ; 
+    UPool::ParallelFor( num, [p, width](int64_t i0, int64_t i1){ NPU::_byteswap( p + i0*width, i1 - i0, width ) ; }, num_threads, 1 << 20 ); 
+}
+
+/**
+NP::release_data
+------------------
+
+Frees the payload keeping the header, metadata and lpath, 
+returning the array to nodata state such that NP::load_data 
+can subsequently restore it. 
+
+**/
+
+inline void NP::release_data()
+{
+    unmap(); 
+    decltype(data)().swap(data) ; 
+    nodata = true ; 
+}
+
+
 inline int NP::load_string_( const char* path, const char* ext, std::string& str )
 {
     std::string str_path = U::ChangeExt(path, ".npy", ext ); 
@@ -5826,6 +7387,13 @@ inline int NP::load_strings_( const char* path, const char* ext, std::vector<std
 }
 
 
+inline void NP::load_sidecars( const char* path )
+{
+    load_meta( path ); 
+    load_names( path ); 
+    load_labels( path ); 
+}
+
 inline int NP::load_meta(  const char* path ){  return load_string_( path, "_meta.txt",  meta  ) ; }
 inline int NP::load_names( const char* path ){  return load_strings_( path, "_names.txt", &names ) ; }
 inline int NP::load_labels( const char* path )
@@ -5865,6 +7433,123 @@ inline void NP::save_names( const char* path) const { save_strings_(path, "_name
 inline void NP::save_labels(const char* path) const { if(labels) save_strings_(path, "_labels.txt", *labels );  }
 
 
+inline bool NP::EmbedDefault() // static
+{
+    return getenv(NP_EMBED) != nullptr ; 
+}
+
+/**
+NP::make_embedded
+-------------------
+
+Returns the block written after the payload by NP::save_embedded 
+or by NP::save when envvar NP_EMBED is defined::
+
+    meta text 
+    names, one per line 
+    labels, one per line 
+    trailer : 8 bytes "NPEMBED1" then meta, names and labels byte counts as uint64_t 
+
+The npy header is unchanged so numpy, which reads only the number of bytes 
+from the shape, loads the payload and ignores the block. NP::load reads the
+trailer from the end of the file and only when it is absent looks for the 
+sidecar files. Empty names and labels are written as zero bytes as with 
+sidecars and the trailer is written even when there is nothing to embed, 
+avoiding the sidecar opens on loading. 
+
+**/
+
+inline std::string NP::make_embedded() const 
+{
+    std::string n ; 
+    for(unsigned i=0 ; i < names.size() ; i++) n += names[i] + '\n' ;  
+    std::string l ; 
+    if(labels) for(unsigned i=0 ; i < labels->size() ; i++) l += (*labels)[i] + '\n' ;  
+
+    uint64_t sz[3] = { meta.size(), n.size(), l.size() } ; 
+    std::string tail ; 
+    tail.reserve( sz[0] + sz[1] + sz[2] + EMBED_TRAILER ); 
+    tail += meta ; 
+    tail += n ; 
+    tail += l ; 
+    tail.append( EMBED_MAGIC, 8 ); 
+    tail.append( (const char*)sz, sizeof(sz) ); 
+    assert( tail.size() == sz[0] + sz[1] + sz[2] + EMBED_TRAILER ); 
+    return tail ; 
+}
+
+/**
+NP::load_embedded
+-------------------
+
+Reads the trailer at the end of the file and when valid the embedded 
+block that follows the payload ending at *payload_end*. 
+Returns non-zero when there is no valid embedded block. 
+
+**/
+
+inline int NP::load_embedded( std::istream& fp, size_t payload_end )
+{
+    fp.clear(); 
+    fp.seekg(0, std::ios::end); 
+    std::streamoff file_bytes = fp.tellg() ; 
+    if( file_bytes < 0 || size_t(file_bytes) < payload_end + EMBED_TRAILER ) return 1 ; 
+
+    size_t tail_bytes = file_bytes - payload_end ; 
+    std::string trailer(EMBED_TRAILER, '\0') ; 
+    fp.seekg( file_bytes - std::streamoff(EMBED_TRAILER) ); 
+    fp.read( &trailer[0], EMBED_TRAILER ); 
+    if( fp.fail() || memcmp(trailer.data(), EMBED_MAGIC, 8) != 0 ) return 1 ;   
+
+    std::string tail(tail_bytes, '\0') ; 
+    fp.seekg( payload_end ); 
+    fp.read( &tail[0], tail_bytes ); 
+    if( fp.fail() ) return 1 ; 
+    return load_embedded_( tail.data(), tail_bytes ); 
+}
+
+/**
+NP::load_embedded_
+--------------------
+
+Sets meta, names and labels from the in memory *tail* of the file 
+that follows the payload, applying the same conventions as the sidecar 
+loaders NP::load_meta NP::load_names NP::load_labels. 
+
+**/
+
+inline int NP::load_embedded_( const char* tail, size_t tail_bytes )
+{
+    if( tail == nullptr || tail_bytes < EMBED_TRAILER ) return 1 ; 
+    const char* trailer = tail + tail_bytes - EMBED_TRAILER ; 
+    if( memcmp(trailer, EMBED_MAGIC, 8) != 0 ) return 1 ; 
+
+    uint64_t sz[3] ; 
+    memcpy( sz, trailer + 8, sizeof(sz) ); 
+    if( sz[0] + sz[1] + sz[2] + EMBED_TRAILER != tail_bytes ) return 1 ; 
+
+    std::string line ; 
+    if( sz[0] > 0 )
+    {
+        std::istringstream ms(std::string(tail, sz[0])) ; 
+        std::stringstream ss ; 
+        while (std::getline(ms, line)) ss << line << std::endl ;   // as load_string_ 
+        meta = ss.str(); 
+    }
+
+    std::istringstream ns(std::string(tail + sz[0], sz[1])) ; 
+    while (std::getline(ns, line)) names.push_back(line) ; 
+
+    labels = sz[2] > 0 ? new std::vector<std::string> : nullptr ; 
+    if( labels )
+    {
+        std::istringstream ls(std::string(tail + sz[0] + sz[1], sz[2])) ; 
+        while (std::getline(ls, line)) labels->push_back(line) ; 
+    }
+    return 0 ; 
+}
+
+
 inline void NP::save_header(const char* path)
 {
     update_headers(); 
@@ -5875,6 +7560,7 @@ inline void NP::save_header(const char* path)
 inline void NP::old_save(const char* path)  // non-const due to update_headers
 {
     std::cout << "NP::save path [" << path  << "]" << std::endl ; 
+    if(is_mapped_file(path)) return ; 
     update_headers(); 
     std::ofstream stream(path, std::ios::out|std::ios::binary);
     stream << _hdr ; 
@@ -5891,14 +7577,61 @@ inline void NP::save(const char* path_) const
     if(VERBOSE) std::cout << "NP::save path [" << ( path ? path : "-" ) << "] rc:" << rc  << std::endl ; 
     assert( rc == 0 ); 
 
+    save_(path); 
+}
+
+/**
+NP::save_
+-----------
+
+Writes array and sidecars to the already resolved path whose directory 
+must exist. Returns non-zero when the array write fails, 
+allowing callers such as NPFold::save_async to report errors.  
+With *embed* (default from envvar NP_EMBED) meta, names and labels 
+are written into the .npy after the payload instead of sidecars, 
+see NP::make_embedded. 
+
+Saving a mapped array over the file it is mapped from is refused, 
+as truncating the file would remove the pages beneath the mapping. 
+
+**/
+
+inline int NP::save_(const char* path, bool embed) const 
+{
+    if(is_mapped_file(path))
+    {
+        std::cerr << "NP::save_ REFUSED TO WRITE OVER THE FILE MAPPED BY THIS ARRAY, save elsewhere or save NP::MakeCopy " << path << std::endl ; 
+        return 1 ; 
+    }
     std::string hdr = make_header(); 
     std::ofstream fpa(path, std::ios::out|std::ios::binary);
     fpa << hdr ; 
     fpa.write( bytes(), arr_bytes() );
+    if(embed)
+    {
+        std::string tail = make_embedded(); 
+        fpa.write( tail.data(), tail.size() ); 
+    }
+    fpa.close(); 
+    int rc = fpa.fail() ? 1 : 0 ; 
+    if(rc != 0) std::cerr << "NP::save_ FAILED TO WRITE " << path << std::endl ; 
+    if(embed) return rc ; 
 
     save_meta( path); 
     save_names(path); 
     save_labels(path); 
+    return rc ; 
+}
+
+inline void NP::save_embedded(const char* path_) const 
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) std::cerr << "NP::save_embedded failed to U::Resolve path_ " << ( path_ ? path_ : "-" ) << std::endl ; 
+    if(path == nullptr) return ; 
+
+    int rc = U::MakeDirsForFile(path); 
+    assert( rc == 0 ); 
+    save_(path, true); 
 }
 
 inline void NP::save(const char* dir, const char* reldir, const char* name) const 
@@ -6050,7 +7783,7 @@ template <typename T> void NP::read(const T* src)
     for(int m=0 ; m < sh.nm_() ; m++ )
     for(int o=0 ; o < sh.no_() ; o++ )
     {  
-        int index = sh.idx(i,j,k,l,m,o); 
+        int64_t index = sh.idx(i,j,k,l,m,o); 
         *(v + index) = *(src + index ) ; 
     }   
 }
@@ -6758,14 +8491,15 @@ inline std::istream& operator>>(std::istream& is, NP& a)
         << std::endl
         ;
 
-    std::getline( is, a._hdr );  
-    a._hdr += '\n' ;     // getline consumes newline ending header but does not return it 
+    bool hdr_ok = NPU::_read_header( is, a._hdr );  
+    assert( hdr_ok ); 
     assert( hdr_bytes_nh == a._hdr.length() ); 
 
     a.decode_header();   // resizes data array 
 
     assert( a.arr_bytes() == arr_bytes_nh ); 
     is.read(a.bytes(), a.arr_bytes() );
+    if(!NP::KeepForeign()) a.to_native(); 
 
     a.meta.resize(meta_bytes_nh);
     is.read( (char*)a.meta.data(), meta_bytes_nh );
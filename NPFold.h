@@ -73,6 +73,7 @@ Hid fts.h usage behind WITH_FTS as getting compilation error on Linux::
 #include <vector> 
 #include <map> 
 #include <set> 
+#include <unordered_map> 
 #include <cstdlib>
 #include <csignal>
 #include <cstdio>
@@ -87,9 +88,202 @@ Hid fts.h usage behind WITH_FTS as getting compilation error on Linux::
 #include <sstream>
 #include <iomanip>
 
+#include <atomic>
+#include <memory>
+
 #include "NP.hh"
 #include "NPX.h"
 
+/**
+NPFoldAsync : writer thread pool used by NPFold::save_async
+-------------------------------------------------------------
+
+Holds the UPool that performs the file writes and the accounting
+of the bytes of snapshot arrays not yet written. NPFoldAsync::acquire
+blocks the caller of NPFold::save_async when the in-flight bytes would
+exceed *max_inflight*, bounding the memory used for snapshots when
+saves are issued faster than they can be written.
+
+NPFoldAsync::Get returns the default writer, a function static
+whose dtor completes pending writes at exit. The number of threads
+of the default writer is controlled by envvar NP_THREADS.
+
+**/
+
+struct NPFoldAsync
+{
+    static constexpr size_t MAX_INFLIGHT_BYTES = size_t(1) << 30 ;
+    static NPFoldAsync* Get();
+
+    struct Handle  // state shared by the write tasks of one save_async
+    {
+        std::atomic<int> remaining ;
+        std::atomic<int> errors ;
+        std::promise<int> done ;
+        Handle() : remaining(1), errors(0) {}   // remaining starts at 1 for the submitting traversal
+    };
+    static void Finish( std::shared_ptr<Handle> h, int rc );
+
+    UPool                   pool ;
+    size_t                  max_inflight ;
+    size_t                  inflight ;
+    std::mutex              mtx ;
+    std::condition_variable cv ;
+
+    NPFoldAsync(int num_threads=0, size_t max_inflight_bytes=MAX_INFLIGHT_BYTES );
+
+    void acquire(size_t bytes);
+    void release(size_t bytes);
+    size_t get_inflight();
+};
+
+inline NPFoldAsync* NPFoldAsync::Get() // static
+{
+    static NPFoldAsync writer ;
+    return &writer ;
+}
+
+/**
+NPFoldAsync::Finish
+--------------------
+
+Invoked when each task completes, the last one fulfils the promise
+with the number of failed tasks.
+
+**/
+
+inline void NPFoldAsync::Finish( std::shared_ptr<Handle> h, int rc ) // static
+{
+    if(rc != 0) h->errors += 1 ;
+    if(--h->remaining == 0) h->done.set_value( h->errors );
+}
+
+inline NPFoldAsync::NPFoldAsync(int num_threads, size_t max_inflight_bytes )
+    :
+    pool(num_threads),
+    max_inflight(max_inflight_bytes),
+    inflight(0)
+{
+}
+
+/**
+NPFoldAsync::acquire
+---------------------
+
+Blocks until *bytes* can be added to the in-flight total without exceeding
+the maximum. A single snapshot larger than the maximum proceeds once
+nothing else is in flight.
+
+**/
+
+inline void NPFoldAsync::acquire(size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this, bytes]{ return inflight == 0 || inflight + bytes <= max_inflight ; });
+    inflight += bytes ;
+}
+
+inline void NPFoldAsync::release(size_t bytes)
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        inflight -= bytes ;
+    }
+    cv.notify_all();
+}
+
+inline size_t NPFoldAsync::get_inflight()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    return inflight ;
+}
+
+
+
+/**
+NPFoldPacked : single file container holding all the files of a saved NPFold tree
+------------------------------------------------------------------------------------
+
+Instead of a directory tree with an index, metadata, one .npy and up to
+three sidecars per array for every subfold, the packed container is one file::
+
+    [0,8)             magic "NPFOLDPK"
+    [8,16)            little endian uint64 : table_bytes
+    [16,16+table)     table text, one line per entry : offset nbytes path dtype shape (tab delimited)
+    padding to 64
+    payloads          each entry starts 64-byte aligned, offsets are relative to the first
+
+Each entry holds the exact bytes of one of the files that NPFold::save
+would write, keyed by its path relative to the top fold directory,
+eg "sub/key.npy" "sub/key_meta.txt" "sub/NPFold_index.txt".
+For .npy entries the dtype and shape are included in the table so
+arrays can be listed without reading the payloads. As the npy headers
+are multiple of 64 bytes long the array data is also 64-byte aligned.
+
+Writing every entry to its path with NPFoldPacked::unpack recreates
+the directory layout of NPFold::save byte for byte.
+
+NPFoldPacked::open reads only the preamble and table, indexing the entries
+by path and keeping the file open for the lifetime of the NPFoldPacked.
+Subsequent NPFoldPacked::find_array uses pread to read only the entries for
+one array and its sidecars, with the array data read directly into the array.
+
+**/
+
+struct NPFold ;
+
+struct NPFoldPacked
+{
+    static constexpr const char* MAGIC = "NPFOLDPK" ;
+    static constexpr const uint64_t PREAMBLE = 16 ;
+    static constexpr const uint64_t ALIGN = 64 ;
+
+    struct Entry
+    {
+        std::string path ;
+        uint64_t    offset ;
+        uint64_t    nbytes ;
+        std::string dtype ;
+        std::string shape ;
+        const NP*   a ;      // writing only : array payload that follows text
+        std::string text ;   // writing only : file content, or npy header for arrays
+    };
+
+    std::string         path ;
+    std::vector<Entry>  entries ;
+    std::unordered_map<std::string, int> entries_idx ;   // path -> index into entries
+    uint64_t            data_start ;
+    int                 fd ;
+
+    static uint64_t Align(uint64_t n) ;
+    static std::string Join(const std::string& rel, const char* name) ;
+    static std::string Lines(const std::vector<std::string>& lines) ;
+    static void SplitLines(std::vector<std::string>& lines, const std::string& str) ;
+    static std::string ShapeString(const std::vector<int>& shape) ;
+
+    static int Write(const char* path, std::vector<Entry>& ee) ;
+
+    NPFoldPacked();
+    ~NPFoldPacked();
+    NPFoldPacked(const NPFoldPacked&) = delete ;             // owns fd
+    NPFoldPacked& operator=(const NPFoldPacked&) = delete ;
+
+    int open(const char* path) ;
+    void close() ;
+    int pread_(char* dst, uint64_t nbytes, uint64_t offset) const ;
+    int find(const char* epath) const ;
+    int read(std::string& bytes, int idx) const ;
+    bool read(std::string& bytes, const char* epath) const ;
+
+    NP* find_array(const char* apath) const ;
+    NPFold* load() const ;
+    void load_r(NPFold* f, const std::string& rel) const ;
+    int unpack(const char* dir) const ;
+
+    std::string desc() const ;
+};
+
+
 struct NPFold 
 {
     // PRIMARY MEMBERS : KEYS, ARRAYS, SUBFOLD
@@ -100,15 +294,29 @@ struct NPFold
     std::vector<std::string> ff ;  // keys of sub-NPFold 
     std::vector<NPFold*> subfold ;  
 
+    // hashed key to index lookup, kept in sync with kk and ff by add_, add_subfold and clear_ 
+    std::unordered_map<std::string, int> kk_idx ; 
+    std::unordered_map<std::string, int> ff_idx ; 
+
     // METADATA FIELDS 
     std::string               headline ; 
     std::string               meta ; 
+    mutable NPMeta            meta_idx ;   // parsed key -> value index of meta, see NPMeta
     std::vector<std::string>  names ;
     const char*               savedir ; 
     const char*               loaddir ; 
 
     // nodata:true used for lightweight access to metadata from many arrays
     bool                      nodata ; 
+    // mapped:true arrays loaded with NP::LoadMapped sharing the OS page cache  
+    bool                      mapped ; 
+    // lazy:true arrays loaded nodata with payload read on first access, see NPFold::LoadLazy
+    bool                      lazy ; 
+    std::shared_ptr<std::mutex> lazy_mtx ; 
+
+    // pending array and subfold loads collected by NPFold::load_parallel, nullptr otherwise 
+    struct Pending { NPFold* fold ; std::string base ; std::string relp ; const NP* a ; NPFold* sub ; } ; 
+    std::vector<Pending>*     pending ; 
     bool                      verbose_ ; 
 
     static constexpr const int UNDEF = -1 ; 
@@ -121,6 +329,7 @@ struct NPFold
     static constexpr const char* INDEX = "NPFold_index.txt" ; 
     static constexpr const char* META  = "NPFold_meta.txt" ; 
     static constexpr const char* NAMES = "NPFold_names.txt" ; 
+    static constexpr const char* MANIFEST = "NPFold_manifest.txt" ; 
     static constexpr const char* kNP_PROP_BASE = "NP_PROP_BASE" ; 
 
 
@@ -139,6 +348,8 @@ struct NPFold
     static bool    Exists(const char* base); 
     static NPFold* Load_(const char* base ); 
     static NPFold* LoadNoData_(const char* base ); 
+    static NPFold* LoadMapped_(const char* base ); 
+    static NPFold* LoadLazy_(const char* base ); 
 
     static const char* Resolve(const char* base_, const char* rel1_=nullptr, const char* rel2_=nullptr); 
     static NPFold* Load(const char* base); 
@@ -149,6 +360,15 @@ struct NPFold
     static NPFold* LoadNoData(const char* base, const char* rel ); 
     static NPFold* LoadNoData(const char* base, const char* rel1, const char* rel2 ); 
 
+    static NPFold* LoadMapped(const char* base); 
+    static NPFold* LoadMapped(const char* base, const char* rel ); 
+
+    static NPFold* LoadLazy(const char* base); 
+    static NPFold* LoadLazy(const char* base, const char* rel ); 
+
+    typedef std::function<void(int, int)> Progress ;  // (num_loaded, num_total) 
+    static NPFold* LoadParallel(const char* base, int num_threads=0, Progress progress=nullptr ); 
+
 
     static NPFold* LoadProp(const char* rel0, const char* rel1=nullptr ); 
 
@@ -178,6 +398,7 @@ public:
 
     NPFold*        find_subfold_(const char* fpath) const  ; 
     const NPFold*  find_subfold(const char* fpath) const  ; 
+    const NPFold*  _find_subfold_r(const std::string& qpath) const  ; 
 
 
     const void     find_subfold_with_all_keys(
@@ -249,6 +470,8 @@ public:
 
     const NP* get(const char* k) const ; 
     NP*       get_(const char* k); 
+    const NP* _lazy_get(const NP* a) const ; 
+    bool      release(const char* k); 
 
 
     const NP* get_optional(const char* k) const ; 
@@ -273,8 +496,23 @@ public:
     void _save(const char* base) ; 
     int  _save_arrays(const char* base); 
     void _save_subfold_r(const char* base); 
+    static int _SaveIndex(const char* base, 
+          const std::vector<std::string>& kk, 
+          const std::vector<std::string>& ff, 
+          const std::string& meta, 
+          const std::vector<std::string>& names ); 
+
+    std::string make_manifest() const ; 
+    static int  _SaveManifest(const char* base, const std::string& manifest); 
+    static bool HasFreshManifest(const char* base); 
+    static int64_t MTime(const char* path); 
+    int         load_manifest(const char* base); 
+
+    std::future<int> save_async(const char* base, NPFoldAsync* writer=nullptr) ; 
+    void _save_async_r(const char* base, NPFoldAsync* writer, std::shared_ptr<NPFoldAsync::Handle> h ); 
 
     void load_array(const char* base, const char* relp); 
+    const NP* _load_array(const char* base, const char* relp) const ; 
     void load_subfold(const char* base, const char* relp);
 
 #ifdef WITH_FTS
@@ -287,6 +525,13 @@ public:
 
     int load(const char* base ) ; 
     int load(const char* base, const char* rel0, const char* rel1=nullptr ) ; 
+    int load_parallel(const char* base, int num_threads=0, Progress progress=nullptr ) ; 
+
+    static int     SavePacked(const NPFold* fold, const char* path) ; 
+    static NPFold* LoadPacked(const char* path) ; 
+    static NP*     LoadPackedArray(const char* path, const char* apath) ; 
+    static int     UnpackPacked(const char* path, const char* dir) ; 
+    void _pack_r(std::vector<NPFoldPacked::Entry>& ee, const std::string& rel) const ; 
 
 
     std::string descKeys() const ; 
@@ -461,6 +706,47 @@ inline NPFold* NPFold::LoadNoData_(const char* base_ )
     return nf ;  
 }
 
+/**
+NPFold::LoadMapped_
+--------------------
+
+Arrays of the fold and all its subfold are loaded with NP::LoadMapped, 
+so the payloads are memory mapped rather than read and copied. 
+
+**/
+
+inline NPFold* NPFold::LoadMapped_(const char* base )
+{
+    if(base == nullptr) return nullptr ; 
+    NPFold* nf = new NPFold ; 
+    nf->mapped = true ; 
+    nf->load(base); 
+    return nf ;  
+}
+
+/**
+NPFold::LoadLazy_
+-------------------
+
+Only the index, fold metadata and the headers and sidecars of the
+arrays are read, the arrays are nodata placeholders recording 
+path, shape and dtype. The payload of each array is read on first 
+access with NPFold::get NPFold::get_ NPFold::get_array or 
+NPFold::find_array and can be freed again with NPFold::release. 
+This makes opening a large fold cheap when only a few of its 
+arrays are used. 
+
+**/
+
+inline NPFold* NPFold::LoadLazy_(const char* base )
+{
+    if(base == nullptr) return nullptr ; 
+    NPFold* nf = new NPFold ; 
+    nf->lazy = true ; 
+    nf->load(base); 
+    return nf ;  
+}
+
 inline const char* NPFold::Resolve(const char* base_, const char* rel1_, const char* rel2_ )
 {
     const char* base = U::Resolve(base_, rel1_, rel2_ ); 
@@ -511,6 +797,28 @@ inline NPFold* NPFold::LoadNoData(const char* base_, const char* rel1_, const ch
     return LoadNoData_(base); 
 }
 
+inline NPFold* NPFold::LoadMapped(const char* base_)
+{
+    const char* base = Resolve(base_); 
+    return LoadMapped_(base); 
+}
+inline NPFold* NPFold::LoadMapped(const char* base_, const char* rel_)
+{
+    const char* base = Resolve(base_, rel_); 
+    return LoadMapped_(base); 
+}
+
+inline NPFold* NPFold::LoadLazy(const char* base_)
+{
+    const char* base = Resolve(base_); 
+    return LoadLazy_(base); 
+}
+inline NPFold* NPFold::LoadLazy(const char* base_, const char* rel_)
+{
+    const char* base = Resolve(base_, rel_); 
+    return LoadLazy_(base); 
+}
+
 
 
 
@@ -607,12 +915,18 @@ inline NPFold::NPFold()
     aa(),
     ff(),
     subfold(),
+    kk_idx(),
+    ff_idx(),
     headline(),
     meta(),
     names(),
     savedir(nullptr),
     loaddir(nullptr),
     nodata(false),
+    mapped(false),
+    lazy(false),
+    lazy_mtx(),
+    pending(nullptr),
     verbose_(VERBOSE)
 {
     if(verbose_) std::cerr << "NPFold::NPFold" << std::endl ; 
@@ -636,6 +950,8 @@ inline void NPFold::check_integrity() const
 {
     assert( kk.size() == aa.size() ); 
     assert( ff.size() == subfold.size() ); 
+    assert( kk_idx.size() == kk.size() ); 
+    assert( ff_idx.size() <= ff.size() ); 
 }
 
 
@@ -648,6 +964,7 @@ inline void NPFold::check_integrity() const
 inline void NPFold::add_subfold(const char* f, NPFold* fo )
 {
     if(fo == nullptr) return ; 
+    ff_idx.emplace(f, ff.size()) ;  // does not replace, so duplicate keys find the first as std::find did
     ff.push_back(f); // subfold keys 
     subfold.push_back(fo); 
 }
@@ -669,8 +986,8 @@ inline const char* NPFold::get_subfold_key(unsigned idx) const
 }
 inline int NPFold::get_subfold_idx(const char* f) const
 {
-    size_t idx = std::distance( ff.begin(), std::find( ff.begin(), ff.end(), f )) ; 
-    return idx < ff.size() ? idx : UNDEF ; 
+    std::unordered_map<std::string, int>::const_iterator it = ff_idx.find(f) ; 
+    return it == ff_idx.end() ? UNDEF : it->second ; 
 }
 inline NPFold* NPFold::get_subfold(const char* f) const 
 {
@@ -718,33 +1035,43 @@ inline NPFold* NPFold::find_subfold_(const char* qpath) const
 NPFold::find_subfold using full subfold qpath, start path is "" 
 ----------------------------------------------------------------
 
-0. recursively collects vectors of folds and paths
-1. attempts to match the qpath with the vector or paths to get the idx 
-2. returns the subfold or nullptr if not found
+The qpath is matched one level at a time using the hashed subfold keys 
+of each fold, so the cost depends on the depth of the qpath rather 
+than the size of the tree. The paths are as collected by NPFold::Traverse_r, 
+eg "" for this fold and "sub/subsub" for its subfold. 
 
 **/
 
 inline const NPFold* NPFold::find_subfold(const char* qpath) const 
 {
-    std::vector<const NPFold*> folds ;
-    std::vector<std::string>   paths ;
-    Traverse_r( this, "",  folds, paths ); 
-    size_t idx = std::distance( paths.begin(), std::find( paths.begin(), paths.end(), qpath ) ) ; 
+    if(qpath == nullptr) return nullptr ; 
+    if(strlen(qpath) == 0) return this ; 
+    std::string q(qpath) ; 
+    return _find_subfold_r(q) ; 
+}
 
-    if(VERBOSE) 
-    {
-        std::cout 
-            << "NPFold::find_subfold"
-            << " qpath[" << qpath << "]" << std::endl 
-            << " paths.size " << paths.size() << std::endl 
-            << " folds.size " << folds.size() << std::endl 
-            << " idx " << idx << std::endl 
-            ; 
+/**
+NPFold::_find_subfold_r
+-------------------------
+
+1. try the full remaining qpath as subfold key, as keys can contain slashes
+2. otherwise for each slash try the prefix as subfold key and 
+   the remainder within that subfold 
+
+**/
+
+inline const NPFold* NPFold::_find_subfold_r(const std::string& q) const 
+{
+    int idx = get_subfold_idx(q.c_str()) ; 
+    if(idx != UNDEF) return subfold[idx] ; 
 
-        for(unsigned i=0 ; i < paths.size() ; i++) 
-            std::cout << i << " [" << paths[i].c_str() << "]" << std::endl ;
-    }  
-    return idx < paths.size() ? folds[idx] : nullptr ;  
+    for(size_t p = q.find('/') ; p != std::string::npos && p + 1 < q.size() ; p = q.find('/', p+1))
+    {
+        int i = get_subfold_idx(q.substr(0, p).c_str()) ; 
+        const NPFold* f = i == UNDEF ? nullptr : subfold[i]->_find_subfold_r(q.substr(p+1)) ; 
+        if(f) return f ; 
+    }
+    return nullptr ;  
 }
 
 
@@ -988,7 +1315,7 @@ inline void NPFold::add_(const char* k, const NP* a)
 {
     if(verbose_) std::cerr << "NPFold::add_ [" << k  << "]" <<  std::endl ; 
 
-    bool have_key_already = std::find( kk.begin(), kk.end(), k ) != kk.end() ; 
+    bool have_key_already = kk_idx.count(k) == 1 ; 
     if(have_key_already) std::cerr 
         << "NPFold::add_ FATAL : have_key_already [" << k << "]"  
         << std::endl 
@@ -996,6 +1323,7 @@ inline void NPFold::add_(const char* k, const NP* a)
         ; 
     assert( !have_key_already ); 
 
+    kk_idx[k] = kk.size() ; 
     kk.push_back(k); 
     aa.push_back(a); 
 }
@@ -1098,6 +1426,7 @@ inline void NPFold::clear_(const std::vector<std::string>* keep)
     } 
     aa.clear(); 
     kk.clear();  
+    kk_idx.clear(); 
 
     // HUH: CLEARS ARRAY POINTER VECTOR BUT DOES NOT DELETE 
     // ARRAYS WITH KEYS IN THE KEEP LIST SO IT LOOSES 
@@ -1114,6 +1443,7 @@ inline void NPFold::clear_(const std::vector<std::string>* keep)
 
     subfold.clear();
     ff.clear();       // folder keys 
+    ff_idx.clear(); 
 }
 
 /**
@@ -1327,6 +1657,7 @@ inline void NPFold::CopyMeta( NPFold* b , const NPFold* a ) // static
     b->savedir = a->savedir ? strdup(a->savedir) : nullptr ; 
     b->loaddir = a->loaddir ? strdup(a->loaddir) : nullptr ; 
     b->nodata  = a->nodata ; 
+    b->mapped  = a->mapped ; 
 }
 
 
@@ -1369,7 +1700,7 @@ inline const char* NPFold::get_key(unsigned idx) const
 
 inline const NP* NPFold::get_array(unsigned idx) const 
 {
-    return idx < aa.size() ? aa[idx] : nullptr ;
+    return idx < aa.size() ? _lazy_get(aa[idx]) : nullptr ;
 }
 
 /**
@@ -1377,16 +1708,15 @@ NPFold::find (non recursive)
 -----------------------------
 
 If the query key *k* does not end with the DOT_NPY ".npy" then that is added before searching.
-
-std::find returns iterator to the first match
+The index is looked up from the kk_idx hash, avoiding a scan of all keys. 
 
 **/
 inline int NPFold::find(const char* k) const
 {
     bool change_txt_to_npy = true ; 
-    std::string key = FormKey(k, change_txt_to_npy); 
-    size_t idx = std::distance( kk.begin(), std::find( kk.begin(), kk.end(), key.c_str() )) ; 
-    return idx < kk.size() ? idx : UNDEF ; 
+    std::string key = IsNPY(k) ? std::string(k) : FormKey(k, change_txt_to_npy); 
+    std::unordered_map<std::string, int>::const_iterator it = kk_idx.find(key) ; 
+    return it == kk_idx.end() ? UNDEF : it->second ; 
 }
 
 inline bool NPFold::has_key(const char* k) const 
@@ -1414,7 +1744,7 @@ inline bool NPFold::has_all_keys(const char* qq_, char delim) const
 inline const NP* NPFold::get(const char* k) const 
 {
     int idx = find(k) ; 
-    return idx == UNDEF ? nullptr : aa[idx] ; 
+    return idx == UNDEF ? nullptr : _lazy_get(aa[idx]) ; 
 }
 
 inline NP* NPFold::get_(const char* k)
@@ -1423,6 +1753,46 @@ inline NP* NPFold::get_(const char* k)
     return const_cast<NP*>(a) ; 
 }
 
+/**
+NPFold::_lazy_get
+-------------------
+
+With lazy:true the nodata placeholder array is upgraded with NP::load_data 
+on first access. The fold mutex makes concurrent first accesses from 
+multiple threads read the payload only once. 
+
+**/
+
+inline const NP* NPFold::_lazy_get(const NP* a) const 
+{
+    if(!lazy || a == nullptr) return a ; 
+    std::lock_guard<std::mutex> lock(*lazy_mtx); 
+    if(a->nodata) const_cast<NP*>(a)->load_data() ; 
+    return a ; 
+}
+
+/**
+NPFold::release
+-----------------
+
+With lazy:true frees the payload of the array with key *k*, returning it 
+to nodata state such that the next access reads it again. 
+Returns false when not lazy or the key is not found. 
+Pointers to the array remain valid but must not be used to access 
+the payload after release. 
+
+**/
+
+inline bool NPFold::release(const char* k)
+{
+    int idx = find(k) ; 
+    if(!lazy || idx == UNDEF || aa[idx] == nullptr) return false ; 
+    std::lock_guard<std::mutex> lock(*lazy_mtx); 
+    NP* a = const_cast<NP*>(aa[idx]) ; 
+    if(!a->nodata) a->release_data() ; 
+    return true ; 
+}
+
 
 /**
 NPFold::get_optional
@@ -1488,7 +1858,7 @@ inline std::string NPFold::DescCounts(const std::vector<std::string>& keys, cons
 template<typename T> inline T NPFold::get_meta(const char* key, T fallback) const 
 {
     if(meta.empty()) return fallback ; 
-    return NP::GetMeta<T>( meta.c_str(), key, fallback ); 
+    return meta_idx.get<T>( meta, key, fallback ); 
 }
 
 template int         NPFold::get_meta<int>(const char*, int ) const ; 
@@ -1507,7 +1877,9 @@ If the key is not found returns an empty string
 **/
 inline std::string NPFold::get_meta_string(const char* key) const
 {
-    return NP::get_meta_string(meta, key);  
+    std::string value ; 
+    if(!meta.empty()) meta_idx.get(meta, key, value) ; 
+    return value ; 
 }
 
 
@@ -1516,7 +1888,7 @@ inline std::string NPFold::get_meta_string(const char* key) const
 
 template<typename T> inline void NPFold::set_meta(const char* key, T value)  
 {
-    NP::SetMeta(meta, key, value); 
+    meta_idx.set(meta, key, value); 
 }
 
 template void     NPFold::set_meta<int>(const char*, int ); 
@@ -1607,141 +1979,523 @@ inline void NPFold::_save(const char* base)  // not const as sets savedir
 
     if(slic > 0) 
     {
-        NP::WriteNames(base, INDEX, kk );  
-
-        NP::WriteNames(base, INDEX, ff, 0, true  ); // append:true : write subfold keys (without .npy ext) to INDEX  
+        _SaveIndex(base, kk, ff, meta, names ); 
 
         _save_subfold_r(base); 
 
-        bool with_meta = !meta.empty() ; 
-
-        if(with_meta) U::WriteString(base, META, meta.c_str() );  
-
-        NP::WriteNames_Simple(base, NAMES, names) ; 
+        _SaveManifest(base, make_manifest() );  // last, so not older than the index 
     }
 }
 
+/**
+NPFold::_SaveIndex
+--------------------
 
+Writes the index of array keys followed by subfold keys and 
+the fold level metadata and names. 
 
+**/
 
-inline int NPFold::_save_arrays(const char* base) // using the keys with .npy ext as filenames
+inline int NPFold::_SaveIndex(const char* base, 
+          const std::vector<std::string>& kk, 
+          const std::vector<std::string>& ff, 
+          const std::string& meta, 
+          const std::vector<std::string>& names ) // static
 {
-    int count = 0 ; 
-    for(unsigned i=0 ; i < kk.size() ; i++) 
-    {
-        const char* k = kk[i].c_str() ; 
-        const NP* a = aa[i] ; 
-        if( a == nullptr )
-        {
-            if(VERBOSE) std::cerr 
-                << "NPFold::_save_arrays"
-                << " base " << base 
-                << " k " << k 
-                << " ERROR MISSING ARRAY FOR KEY " 
-                << std::endl 
-                ;   
-        }
-        else
-        { 
-            a->save(base, k );  
-            count += 1 ; 
-        }
-    }
-    // this motivated adding directory creation to NP::save 
-    return count ; 
-}
+    NP::WriteNames(base, INDEX, kk );  
 
-inline void NPFold::_save_subfold_r(const char* base)  // NB recursively called via NPFold::save
-{
-    assert( subfold.size() == ff.size() ); 
-    for(unsigned i=0 ; i < ff.size() ; i++) 
-    {
-        const char* f = ff[i].c_str() ; 
-        NPFold* sf = subfold[i] ; 
-        sf->save(base, f );  
-    }
-}
+    NP::WriteNames(base, INDEX, ff, 0, true  ); // append:true : write subfold keys (without .npy ext) to INDEX  
+
+    bool with_meta = !meta.empty() ; 
+
+    if(with_meta) U::WriteString(base, META, meta.c_str() );  
 
+    NP::WriteNames_Simple(base, NAMES, names) ; 
 
+    return NP::Exists(base, INDEX) ? 0 : 1 ;   
+}
 
 
 /**
-NPFold::load_array
---------------------
+NPFold::make_manifest
+-----------------------
 
-0. NP::Load for relp ending .npy otherwise NP::LoadFromTxtFile<double>
-1. add the array using relp as the key
+The manifest summarizes the fold in a single text file, avoiding the 
+opening of every array and sidecar for loads that do not need the payloads
+(NPFold::LoadNoData, NPFold::LoadLazy). Text blocks are preceded by their 
+byte or line count::
+
+    NPFold_manifest 2
+    M <meta_nbytes>                 fold metadata, as loaded 
+    N <num_names>                   fold names, one per line 
+    A <key> <dtype> <shape> <fortran_order> <arr_bytes> <meta_nbytes> <num_names> <num_labels>
+                                    array metadata as loaded, names and labels lines, num_labels -1 for none 
+    F <key>                         subfold, with its own manifest  
+
+Fields are tab delimited, A and F lines are in index order. 
+Metadata is stored in the form read by NPFold::load and NP::load 
+so loading needs no conversion. 
 
 **/
-inline void NPFold::load_array(const char* _base, const char* relp)
-{
-    bool is_nodata = NP::IsNoData(_base); 
-    bool is_npy = IsNPY(relp) ; 
-    bool is_txt = IsTXT(relp) ; 
 
+inline std::string NPFold::make_manifest() const 
+{
+    std::vector<std::string> lines ; 
+    NPFoldPacked::SplitLines(lines, meta) ; 
+    std::stringstream ms ; 
+    for(unsigned i=0 ; i < lines.size() ; i++) ms << lines[i] << ( i < lines.size() - 1 ? "\n" : "" ) ;  // as U::ReadString 
+    std::string fmeta = ms.str(); 
 
-    NP* a = nullptr ; 
+    std::stringstream ss ; 
+    ss << "NPFold_manifest 2" << "\n" ; 
+    ss << "M\t" << fmeta.size() << "\n" << fmeta << "\n" ; 
+    ss << "N\t" << names.size() << "\n" << NPFoldPacked::Lines(names) ; 
 
-    if(is_npy)  
-    {
-        a = NP::Load(_base, relp) ; 
-    }
-    else if(is_nodata)   // nodata mode only do nodata load of arrays
-    {
-        a = nullptr ; 
-    }
-    else if(is_txt)
+    for(unsigned i=0 ; i < kk.size() ; i++)
     {
-        a = NP::LoadFromTxtFile<double>(_base, relp) ; 
+        const NP* a = aa[i] ;   // not get_array : only header level info needed 
+        if(a == nullptr) continue ; 
+
+        std::vector<std::string> alines ; 
+        NPFoldPacked::SplitLines(alines, a->meta) ; 
+        std::string ameta = NPFoldPacked::Lines(alines) ;  // as NP::load_string_ 
+        int num_labels = a->labels && a->labels->size() > 0 ? a->labels->size() : -1 ; 
+
+        ss << "A\t" << kk[i] 
+           << "\t" << a->dtype 
+           << "\t" << NPFoldPacked::ShapeString(a->shape) 
+           << "\t" << int(a->fortran_order) 
+           << "\t" << a->arr_bytes() 
+           << "\t" << ameta.size() 
+           << "\t" << a->names.size() 
+           << "\t" << num_labels 
+           << "\n" 
+           << ameta << "\n" 
+           << NPFoldPacked::Lines(a->names) 
+           ;
+        if(num_labels > 0) ss << NPFoldPacked::Lines(*a->labels) ; 
     }
-    else
-    {
-        a = nullptr ; 
-    } 
-    if(a) add(relp,a ) ; 
+    for(unsigned i=0 ; i < ff.size() ; i++) ss << "F\t" << ff[i] << "\n" ; 
+
+    std::string str = ss.str(); 
+    return str ; 
+}
+
+inline int NPFold::_SaveManifest(const char* base, const std::string& manifest) // static
+{
+    std::string path = U::form_path(base, MANIFEST) ; 
+    std::ofstream fp(path.c_str(), std::ios::out|std::ios::binary);
+    fp << manifest ; 
+    fp.close(); 
+    return fp.fail() ? 1 : 0 ; 
 }
 
 /**
-NPFold::load_subfold
----------------------
+NPFold::HasFreshManifest
+--------------------------
+
+The manifest is only used when it is not older than the index, 
+so folds saved again by code that does not write the manifest 
+are loaded from the individual files. NPFold::load_manifest 
+also compares the manifest with each of its arrays, so arrays 
+written again with NP::save into the fold directory after 
+the manifest also cause the individual files to be loaded. 
 
 **/
 
-inline void NPFold::load_subfold(const char* _base, const char* relp)
+inline bool NPFold::HasFreshManifest(const char* base) // static
 {
-    assert(!IsNPY(relp)); 
-    add_subfold(relp,  NPFold::Load(_base, relp) ) ; 
+    std::string mpath = U::form_path(base, MANIFEST) ; 
+    std::string ipath = U::form_path(base, INDEX) ; 
+    int64_t mt = MTime(mpath.c_str()) ; 
+    int64_t it = MTime(ipath.c_str()) ; 
+    return mt > -1 && it > -1 && mt >= it ; 
 }
 
+/**
+NPFold::MTime
+---------------
+
+Modification time of *path* in nanoseconds, -1 when it does not exist. 
 
+**/
 
-#ifdef WITH_FTS
-inline int NPFold::FTS_Compare(const FTSENT** one, const FTSENT** two)
+inline int64_t NPFold::MTime(const char* path) // static
 {
-    return (strcmp((*one)->fts_name, (*two)->fts_name));
+    struct stat st ; 
+    if( stat(path, &st) != 0 ) return -1 ; 
+    return int64_t(st.st_mtim.tv_sec)*1000000000 + st.st_mtim.tv_nsec ; 
 }
 
-
 /**
-NPFold::no_longer_used_load_fts
-----------------------------------
-
-This was formerly called by NPFold::load when the 
-base directory does not include an INDEX file. 
-
-It has been replaced by NPFold::load_dir
-because of the structural difference between 
-loading with index and loading with fts. 
+NPFold::load_manifest
+-----------------------
 
-fts traverses the directory tree and invokes NPFold::load_array when 
-meeting regular files or symbolic links.
-See "man fts" and tests/fts_test.sh for background.
+Reads the manifest of a fold in place of its index, metadata, names and 
+the headers and sidecars of its arrays, creating nodata arrays with 
+path, shape, dtype, metadata, names and labels. 
+Subfolds are loaded with NPFold::load_subfold using their own manifests. 
 
-This fts approach resulted in a single NPFold 
-with keys containing slash.
- 
-Switching to NP::load_dir unifies the structure 
-with an NPFold for each directory. 
+Returns non-zero without changing the fold when the manifest is 
+missing, stale or cannot be parsed, so the caller can fallback 
+to loading from the individual files. The manifest is stale 
+when older than the index or than any of its array files. 
+Missing array files do not make it stale, as only the payloads 
+are read from them. 
+
+**/
+
+inline int NPFold::load_manifest(const char* _base) 
+{
+    const char* base = NP::IsNoData(_base) ? _base + 1 : _base ;  
+    if(!HasFreshManifest(base)) return 1 ; 
+
+    std::string path = U::form_path(base, MANIFEST) ; 
+    int64_t mt = MTime(path.c_str()) ; 
+    bool stale = false ; 
+    std::ifstream fp(path.c_str(), std::ios::in|std::ios::binary);
+    std::stringstream buf ; 
+    buf << fp.rdbuf() ; 
+    std::istringstream iss(buf.str()) ; 
+
+    std::string fmeta ; 
+    std::vector<std::string> fnames ; 
+    std::vector<std::string> akeys ; 
+    std::vector<NP*> arrs ; 
+    std::vector<std::string> fkeys ; 
+
+    std::string line ; 
+    bool ok = bool(std::getline(iss, line)) ; 
+    if(ok && line.compare("NPFold_manifest 2") != 0) return 1 ;  // older format : load the individual files 
+    while(ok && !stale && std::getline(iss, line))
+    {
+        std::vector<std::string> elem ; 
+        U::Split(line.c_str(), '\t', elem ); 
+        std::string tag = elem.size() > 0 ? elem[0] : "" ; 
+
+        if(tag == "M" && elem.size() == 2)
+        {
+            fmeta.resize( std::stoull(elem[1]) ); 
+            iss.read( &fmeta[0], fmeta.size() ); 
+            iss.ignore(1);   // newline after text block 
+        }
+        else if(tag == "N" && elem.size() == 2)
+        {
+            int num = std::stoi(elem[1]) ; 
+            for(int i=0 ; i < num && std::getline(iss, line) ; i++) fnames.push_back(line) ; 
+            ok = int(fnames.size()) == num ; 
+        }
+        else if(tag == "A" && elem.size() == 9)
+        {
+            std::vector<int> shape ; 
+            if(elem[3] != "-") U::MakeVec<int>(shape, elem[3].c_str(), ',' ); 
+            bool fortran_order = elem[4] == "1" ; 
+
+            NP* a = new NP(elem[2].c_str()) ; 
+            a->release_data();   // nodata:true 
+            a->_hdr = NPU::_make_header(shape, elem[2].c_str(), fortran_order) ;  // as written by NP::save 
+            bool hdr_ok = a->decode_header(); 
+            a->lpath = U::form_path(base, elem[1].c_str()) ; 
+            a->lfold = base ; 
+            stale = MTime(a->lpath.c_str()) > mt ;   // array saved again after the manifest 
+
+            a->meta.resize( std::stoull(elem[6]) ); 
+            iss.read( &a->meta[0], a->meta.size() ); 
+            iss.ignore(1); 
+
+            int num_names = std::stoi(elem[7]) ; 
+            int num_labels = std::stoi(elem[8]) ; 
+            for(int i=0 ; i < num_names && std::getline(iss, line) ; i++) a->names.push_back(line) ; 
+            if(num_labels > -1) a->labels = new std::vector<std::string> ; 
+            for(int i=0 ; i < num_labels && std::getline(iss, line) ; i++) a->labels->push_back(line) ; 
+
+            ok = hdr_ok 
+              && int(a->names.size()) == num_names 
+              && ( num_labels == -1 || int(a->labels->size()) == num_labels ) 
+              && int64_t(a->arr_bytes()) == std::stoll(elem[5]) ; 
+            akeys.push_back(elem[1]); 
+            arrs.push_back(a); 
+        }
+        else if(tag == "F" && elem.size() == 2)
+        {
+            fkeys.push_back(elem[1]); 
+        }
+        else
+        {
+            ok = false ; 
+        }
+        ok = ok && !iss.fail() ; 
+    }
+
+    if(!ok || stale) 
+    {
+        if(!ok) std::cerr << "NPFold::load_manifest FAILED TO PARSE " << path << std::endl ; 
+        for(unsigned i=0 ; i < arrs.size() ; i++) delete arrs[i] ; 
+        return 1 ; 
+    }
+
+    meta = fmeta ; 
+    names = fnames ; 
+    for(unsigned i=0 ; i < arrs.size() ; i++) add_( akeys[i].c_str(), arrs[i] ); 
+    for(unsigned i=0 ; i < fkeys.size() ; i++) load_subfold(_base, fkeys[i].c_str()); 
+    return 0 ; 
+}
+
+
+/**
+NPFold::save_async
+--------------------
+
+Snapshots the fold and its subfolds on the calling thread, copying 
+the arrays and the index, meta and names strings, and queues the 
+file writes onto the *writer* pool (default NPFoldAsync::Get). 
+As the snapshot is taken before returning the fold can be changed 
+or deleted immediately after the call. 
+
+Copying the arrays waits via NPFoldAsync::acquire while the bytes 
+of snapshots still to be written exceeds the writer maximum. 
+
+The returned future gives the number of failed writes, zero for success. 
+The files written are the same as those from NPFold::save. 
+The manifest of each fold is written by whichever of the tasks 
+writing the arrays and index of that fold completes last, so it 
+is not older than any of them, see NPFold::HasFreshManifest. 
+
+**/
+
+inline std::future<int> NPFold::save_async(const char* base_, NPFoldAsync* writer_)
+{
+    NPFoldAsync* writer = writer_ ? writer_ : NPFoldAsync::Get() ; 
+    std::shared_ptr<NPFoldAsync::Handle> h = std::make_shared<NPFoldAsync::Handle>() ; 
+    std::future<int> result = h->done.get_future() ; 
+
+    const char* base = U::Resolve(base_); 
+    if(base == nullptr) std::cerr 
+        << "NPFold::save_async(\"" << ( base_ ? base_ : "-" ) << "\")"
+        << " did not resolve all tokens in argument "
+        << std::endl
+        ;
+
+    if(base == nullptr) 
+    {
+        NPFoldAsync::Finish( h, 1 );  
+    }
+    else
+    {
+        _save_async_r(base, writer, h ); 
+        NPFoldAsync::Finish( h, 0 );   // completes the traversal count 
+    }
+    return result ; 
+}
+
+inline void NPFold::_save_async_r(const char* base, NPFoldAsync* writer, std::shared_ptr<NPFoldAsync::Handle> h ) 
+{
+    assert( !nodata ); 
+    savedir = strdup(base); 
+    U::MakeDirs(base); 
+
+    int slic = _save_local_item_count(); 
+    std::string dir(base) ; 
+    std::shared_ptr<const std::string> manifest = std::make_shared<const std::string>( slic > 0 ? make_manifest() : "" ) ; 
+    std::shared_ptr<std::atomic<int>> unwritten = std::make_shared<std::atomic<int>>(1) ;  // array writes and the index write of this fold
+
+    for(unsigned i=0 ; i < kk.size() ; i++) 
+    {
+        const NP* a = get_array(i) ; 
+        if( a == nullptr ) continue ; 
+
+        std::string path = U::form_path(base, kk[i].c_str()) ; 
+        U::MakeDirsForFile(path.c_str()); 
+
+        size_t bytes = a->arr_bytes() ; 
+        writer->acquire(bytes); 
+        NP* snap = NP::MakeCopy(a) ; 
+
+        h->remaining += 1 ; 
+        *unwritten += 1 ; 
+        writer->pool.submit( [writer, h, snap, path, bytes, dir, manifest, unwritten]() -> int {
+            int rc = snap->save_(path.c_str()) ; 
+            delete snap ; 
+            writer->release(bytes); 
+            if(--*unwritten == 0) rc += _SaveManifest(dir.c_str(), *manifest ) ; 
+            NPFoldAsync::Finish(h, rc); 
+            return rc ; 
+        }); 
+    }
+
+    if(slic > 0) 
+    {
+        std::vector<std::string> kk_(kk), ff_(ff), names_(names) ; 
+        std::string meta_(meta) ; 
+
+        h->remaining += 1 ; 
+        writer->pool.submit( [h, dir, kk_, ff_, meta_, names_, manifest, unwritten]() -> int {
+            int rc = _SaveIndex(dir.c_str(), kk_, ff_, meta_, names_ ) ; 
+            if(--*unwritten == 0) rc += _SaveManifest(dir.c_str(), *manifest ) ; 
+            NPFoldAsync::Finish(h, rc); 
+            return rc ; 
+        }); 
+
+        assert( subfold.size() == ff.size() ); 
+        for(unsigned i=0 ; i < ff.size() ; i++) 
+        {
+            std::string sub = U::form_path(base, ff[i].c_str()) ; 
+            subfold[i]->_save_async_r(sub.c_str(), writer, h ); 
+        }
+    }
+}
+
+
+
+
+inline int NPFold::_save_arrays(const char* base) // using the keys with .npy ext as filenames
+{
+    int count = 0 ; 
+    for(unsigned i=0 ; i < kk.size() ; i++) 
+    {
+        const char* k = kk[i].c_str() ; 
+        const NP* a = get_array(i) ; 
+        if( a == nullptr )
+        {
+            if(VERBOSE) std::cerr 
+                << "NPFold::_save_arrays"
+                << " base " << base 
+                << " k " << k 
+                << " ERROR MISSING ARRAY FOR KEY " 
+                << std::endl 
+                ;   
+        }
+        else
+        { 
+            a->save(base, k );  
+            count += 1 ; 
+        }
+    }
+    // this motivated adding directory creation to NP::save 
+    return count ; 
+}
+
+inline void NPFold::_save_subfold_r(const char* base)  // NB recursively called via NPFold::save
+{
+    assert( subfold.size() == ff.size() ); 
+    for(unsigned i=0 ; i < ff.size() ; i++) 
+    {
+        const char* f = ff[i].c_str() ; 
+        NPFold* sf = subfold[i] ; 
+        sf->save(base, f );  
+    }
+}
+
+
+
+
+/**
+NPFold::load_array
+--------------------
+
+0. NP::Load for relp ending .npy otherwise NP::LoadFromTxtFile<double>
+1. add the array using relp as the key
+
+**/
+inline void NPFold::load_array(const char* _base, const char* relp)
+{
+    if(pending)   // defer loading until the tree structure is known, see NPFold::load_parallel 
+    {
+        Pending p = { this, _base, relp, nullptr, nullptr } ; 
+        pending->push_back(p); 
+        return ; 
+    }
+    const NP* a = _load_array(_base, relp) ; 
+    if(a) add(relp,a ) ; 
+}
+
+inline const NP* NPFold::_load_array(const char* _base, const char* relp) const 
+{
+    bool is_nodata = NP::IsNoData(_base); 
+    bool is_npy = IsNPY(relp) ; 
+    bool is_txt = IsTXT(relp) ; 
+
+
+    NP* a = nullptr ; 
+
+    if(is_npy && lazy)  
+    {
+        a = NP::Load(NP::PathWithNoDataPrefix(_base), relp) ;  // payload read on first access 
+    }
+    else if(is_npy)  
+    {
+        a = mapped ? NP::LoadMapped(_base, relp) : NP::Load(_base, relp) ; 
+    }
+    else if(is_nodata)   // nodata mode only do nodata load of arrays
+    {
+        a = nullptr ; 
+    }
+    else if(is_txt)
+    {
+        a = NP::LoadFromTxtFile<double>(_base, relp) ; 
+    }
+    else
+    {
+        a = nullptr ; 
+    } 
+    return a ; 
+}
+
+/**
+NPFold::load_subfold
+---------------------
+
+**/
+
+inline void NPFold::load_subfold(const char* _base, const char* relp)
+{
+    assert(!IsNPY(relp)); 
+    const char* base = Resolve(_base, relp) ; 
+    if(base == nullptr) return ; 
+
+    NPFold* sub = new NPFold ;   // as NPFold::Load but passing along the load mode 
+    sub->mapped = mapped ; 
+    sub->lazy = lazy ; 
+    if(pending)   // added now to keep the order, loaded with the next level, see NPFold::load_parallel
+    {
+        add_subfold(relp, sub ) ; 
+        Pending p = { this, base, relp, nullptr, sub } ; 
+        pending->push_back(p); 
+        return ; 
+    }
+    sub->load(base); 
+    add_subfold(relp, sub ) ; 
+}
+
+
+
+#ifdef WITH_FTS
+inline int NPFold::FTS_Compare(const FTSENT** one, const FTSENT** two)
+{
+    return (strcmp((*one)->fts_name, (*two)->fts_name));
+}
+
+
+/**
+NPFold::no_longer_used_load_fts
+----------------------------------
+
+This was formerly called by NPFold::load when the 
+base directory does not include an INDEX file. 
+
+It has been replaced by NPFold::load_dir
+because of the structural difference between 
+loading with index and loading with fts. 
+
+fts traverses the directory tree and invokes NPFold::load_array when 
+meeting regular files or symbolic links.
+See "man fts" and tests/fts_test.sh for background.
+
+This fts approach resulted in a single NPFold 
+with keys containing slash.
+ 
+Switching to NP::load_dir unifies the structure 
+with an NPFold for each directory. 
 
 **/
  
@@ -1867,8 +2621,11 @@ inline int NPFold::load(const char* _base)
 {
     nodata = NP::IsNoData(_base) ;  // _path starting with NP::NODATA_PREFIX eg '@' 
     const char* base = nodata ? _base + 1 : _base ;  
+    if(lazy && !lazy_mtx) lazy_mtx = std::make_shared<std::mutex>() ; 
 
     loaddir = strdup(base); 
+    if((nodata || lazy) && load_manifest(_base) == 0) return 0 ;  // one read instead of opening every array 
+
     bool has_meta = NP::Exists(base, META) ; 
     if(has_meta) meta = U::ReadString( base, META ); 
 
@@ -1880,6 +2637,100 @@ inline int NPFold::load(const char* _base)
 
     return rc ; 
 }
+/**
+NPFold::load_parallel
+-----------------------
+
+ 1. loads the tree structure one level at a time : the fold meta, names, 
+    index or directory listing of all the folds of a level are loaded in 
+    parallel with UPool::ParallelEach, each fold collecting its deferred 
+    array loads and subfolds into its own pending list
+ 2. the pending lists are merged in level order : arrays into the array list 
+    and subfolds into the next level, which is loaded in the same way
+ 3. loads the pending arrays in parallel with UPool::ParallelEach, 
+    where each thread takes the next pending array when it becomes free, 
+    invoking the optional progress callback after each 
+ 4. adds the arrays serially in the pending order, which keeps the 
+    order of NPFold::load within each fold so the keys are in the same order 
+
+Subfolds are added to their parent when listed, so the subfold order is
+also that of NPFold::load. The array loads dominate when there are many
+arrays and sidecars as each involves several file opens, whose latency is
+overlapped between the threads, as is that of the index reads of wide trees. 
+
+**/
+
+inline int NPFold::load_parallel(const char* base, int num_threads, Progress progress) 
+{
+    std::vector<Pending> pp ;   // array loads 
+    std::vector<std::vector<Pending>> lp(1) ;   // pending of each fold of the level  
+    pending = &lp[0] ; 
+    int rc = load(base) ; 
+    pending = nullptr ; 
+
+    while(true)
+    {
+        std::vector<Pending> level ;   // subfolds to load 
+        for(unsigned i=0 ; i < lp.size() ; i++) 
+        for(unsigned j=0 ; j < lp[i].size() ; j++) 
+        {
+            const Pending& p = lp[i][j] ; 
+            if(p.sub) level.push_back(p) ; 
+            else      pp.push_back(p) ; 
+        }
+        if(level.size() == 0) break ; 
+
+        lp.clear(); 
+        lp.resize(level.size()); 
+        UPool::ParallelEach( level.size(), [&level, &lp](int64_t i){
+            NPFold* sub = level[i].sub ; 
+            sub->pending = &lp[i] ; 
+            sub->load( level[i].base.c_str() ); 
+            sub->pending = nullptr ; 
+        }, num_threads ); 
+    }
+
+    int num = pp.size() ; 
+    std::atomic<int> num_loaded(0) ; 
+    std::mutex progress_mtx ; 
+
+    UPool::ParallelEach( num, [&pp, &num_loaded, &progress, &progress_mtx, num](int64_t i){
+        Pending& p = pp[i] ; 
+        p.a = p.fold->_load_array( p.base.c_str(), p.relp.c_str() ) ; 
+        int n = ++num_loaded ; 
+        if(progress) 
+        {
+            std::lock_guard<std::mutex> lock(progress_mtx); 
+            progress(n, num); 
+        }
+    }, num_threads ); 
+
+    for(int i=0 ; i < num ; i++) 
+    {
+        const Pending& p = pp[i] ; 
+        if(p.a) p.fold->add( p.relp.c_str(), p.a ) ; 
+    }
+    return rc ; 
+}
+
+/**
+NPFold::LoadParallel
+----------------------
+
+As NPFold::Load but loading arrays with *num_threads* threads, see NPFold::load_parallel. 
+The default num_threads 0 uses envvar NP_THREADS or the hardware concurrency. 
+
+**/
+
+inline NPFold* NPFold::LoadParallel(const char* base_, int num_threads, Progress progress) // static 
+{
+    const char* base = Resolve(base_); 
+    if(base == nullptr) return nullptr ; 
+    NPFold* nf = new NPFold ; 
+    nf->load_parallel(base, num_threads, progress); 
+    return nf ;  
+}
+
 inline int NPFold::load(const char* base_, const char* rel0, const char* rel1) 
 {
     std::string base = U::form_path(base_, rel0, rel1); 
@@ -1968,7 +2819,7 @@ inline int NPFold::getMetaNumProfile() const
 
 inline void NPFold::setMetaKV(const std::vector<std::string>& keys, const std::vector<std::string>& vals) 
 {
-    NP::SetMetaKV_( meta, keys, vals ); 
+    meta_idx.set_kv( meta, keys, vals ); 
 }
 
 
@@ -2779,3 +3630,520 @@ inline std::string NPFold::DescCommonKV(
 }
 
 
+
+
+/**
+NPFold::SavePacked
+--------------------
+
+Writes the fold tree into a single NPFoldPacked container file at *path*.
+Returns non-zero on failure.
+
+**/
+
+inline int NPFold::SavePacked(const NPFold* fold, const char* path_) // static
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return 1 ; 
+    std::vector<NPFoldPacked::Entry> ee ; 
+    fold->_pack_r(ee, "" ); 
+    return NPFoldPacked::Write(path, ee); 
+}
+
+/**
+NPFold::_pack_r
+-----------------
+
+Collects entries for the same files as NPFold::_save with the 
+content of the text files generated in memory and with array 
+payloads referenced rather than copied. 
+
+**/
+
+inline void NPFold::_pack_r(std::vector<NPFoldPacked::Entry>& ee, const std::string& rel) const 
+{
+    assert( !nodata ); 
+    for(unsigned i=0 ; i < kk.size() ; i++) 
+    {
+        const NP* a = get_array(i) ; 
+        if( a == nullptr ) continue ; 
+        std::string apath = NPFoldPacked::Join(rel, kk[i].c_str()) ; 
+
+        NPFoldPacked::Entry e = {} ;
+        e.path = apath ; 
+        e.a = a ; 
+        e.text = a->make_header(); 
+        e.dtype = a->dtype ; 
+        e.shape = NPFoldPacked::ShapeString(a->shape) ; 
+        ee.push_back(e) ; 
+
+        const char* ap = apath.c_str() ; 
+        std::vector<std::string> sidecar_text ; 
+        std::vector<std::string> sidecar_path ; 
+        if(!a->meta.empty())                    { sidecar_path.push_back(U::ChangeExt(ap, ".npy", "_meta.txt"))   ; sidecar_text.push_back(a->meta) ; }
+        if(a->names.size() > 0)                 { sidecar_path.push_back(U::ChangeExt(ap, ".npy", "_names.txt"))  ; sidecar_text.push_back(NPFoldPacked::Lines(a->names)) ; } 
+        if(a->labels && a->labels->size() > 0)  { sidecar_path.push_back(U::ChangeExt(ap, ".npy", "_labels.txt")) ; sidecar_text.push_back(NPFoldPacked::Lines(*a->labels)) ; }
+
+        for(unsigned j=0 ; j < sidecar_path.size() ; j++)
+        {
+            NPFoldPacked::Entry s = {} ;
+            s.path = sidecar_path[j] ; 
+            s.text = sidecar_text[j] ; 
+            ee.push_back(s) ; 
+        }
+    }
+
+    int slic = _save_local_item_count(); 
+    if(slic == 0) return ; 
+
+    NPFoldPacked::Entry idx = {} ; 
+    idx.path = NPFoldPacked::Join(rel, INDEX) ; 
+    idx.text = NPFoldPacked::Lines(kk) + NPFoldPacked::Lines(ff) ; 
+    ee.push_back(idx); 
+
+    if(!meta.empty())
+    {
+        NPFoldPacked::Entry m = {} ; 
+        m.path = NPFoldPacked::Join(rel, META) ; 
+        m.text = meta ; 
+        ee.push_back(m); 
+    }
+
+    NPFoldPacked::Entry n = {} ; 
+    n.path = NPFoldPacked::Join(rel, NAMES) ; 
+    n.text = NPFoldPacked::Lines(names) ; 
+    ee.push_back(n); 
+
+    NPFoldPacked::Entry mf = {} ; 
+    mf.path = NPFoldPacked::Join(rel, MANIFEST) ; 
+    mf.text = make_manifest() ; 
+    ee.push_back(mf); 
+
+    assert( subfold.size() == ff.size() ); 
+    for(unsigned i=0 ; i < ff.size() ; i++) subfold[i]->_pack_r(ee, NPFoldPacked::Join(rel, ff[i].c_str()) ); 
+}
+
+inline NPFold* NPFold::LoadPacked(const char* path_) // static
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    NPFoldPacked pk ; 
+    if(pk.open(path) != 0) return nullptr ; 
+    return pk.load(); 
+}
+
+/**
+NPFold::LoadPackedArray
+-------------------------
+
+Reads a single array and its sidecars from the packed container *path*, 
+with *apath* relative to the top fold eg "sub/key.npy", without 
+reading any other payloads. 
+
+**/
+
+inline NP* NPFold::LoadPackedArray(const char* path_, const char* apath) // static
+{
+    const char* path = U::Resolve(path_); 
+    if(path == nullptr) return nullptr ; 
+    NPFoldPacked pk ; 
+    if(pk.open(path) != 0) return nullptr ; 
+    return pk.find_array(apath) ; 
+}
+
+inline int NPFold::UnpackPacked(const char* path_, const char* dir_) // static
+{
+    const char* path = U::Resolve(path_); 
+    const char* dir = U::Resolve(dir_); 
+    if(path == nullptr || dir == nullptr) return 1 ; 
+    NPFoldPacked pk ; 
+    if(pk.open(path) != 0) return 1 ; 
+    return pk.unpack(dir) ; 
+}
+
+
+
+inline uint64_t NPFoldPacked::Align(uint64_t n) // static
+{
+    return ( n + ALIGN - 1 )/ALIGN*ALIGN ; 
+}
+inline std::string NPFoldPacked::Join(const std::string& rel, const char* name) // static
+{
+    return rel.empty() ? std::string(name) : rel + "/" + name ; 
+}
+
+/**
+NPFoldPacked::Lines
+---------------------
+
+Newline terminated lines, as written by NP::WriteNames and NP::save_strings_ 
+
+**/
+
+inline std::string NPFoldPacked::Lines(const std::vector<std::string>& lines) // static
+{
+    std::stringstream ss ; 
+    for(unsigned i=0 ; i < lines.size() ; i++) ss << lines[i] << "\n" ; 
+    std::string str = ss.str(); 
+    return str ; 
+}
+inline void NPFoldPacked::SplitLines(std::vector<std::string>& lines, const std::string& str) // static
+{
+    std::istringstream iss(str) ; 
+    std::string line ; 
+    while(std::getline(iss, line)) lines.push_back(line) ;  // as NP::ReadNames
+}
+inline std::string NPFoldPacked::ShapeString(const std::vector<int>& shape) // static
+{
+    std::stringstream ss ; 
+    for(unsigned i=0 ; i < shape.size() ; i++) ss << shape[i] << ( i < shape.size() - 1 ? "," : "" ) ; 
+    std::string str = ss.str(); 
+    return str.empty() ? "-" : str ; 
+}
+
+/**
+NPFoldPacked::Write
+---------------------
+
+Assigns 64-byte aligned payload offsets, then writes preamble, table and payloads. 
+
+**/
+
+inline int NPFoldPacked::Write(const char* path, std::vector<Entry>& ee) // static
+{
+    uint64_t offset = 0 ; 
+    for(unsigned i=0 ; i < ee.size() ; i++)
+    {
+        Entry& e = ee[i] ; 
+        e.offset = offset ; 
+        e.nbytes = e.text.size() + ( e.a ? e.a->arr_bytes() : 0 ) ; 
+        offset = Align( offset + e.nbytes ) ; 
+    }
+
+    std::stringstream ts ; 
+    for(unsigned i=0 ; i < ee.size() ; i++)
+    {
+        const Entry& e = ee[i] ; 
+        ts << e.offset << "\t" << e.nbytes << "\t" << e.path << "\t" 
+           << ( e.dtype.empty() ? "-" : e.dtype ) << "\t" 
+           << ( e.shape.empty() ? "-" : e.shape ) << "\n" ; 
+    }
+    std::string table = ts.str(); 
+    uint64_t table_bytes = table.size() ; 
+    uint64_t data_start = Align( PREAMBLE + table_bytes ) ; 
+
+    U::MakeDirsForFile(path); 
+    std::ofstream fp(path, std::ios::out|std::ios::binary);
+    if(fp.fail()) 
+    {
+        std::cerr << "NPFoldPacked::Write FAILED TO OPEN " << path << std::endl ; 
+        return 1 ; 
+    }
+
+    fp.write( MAGIC, 8 ); 
+    for(int i=0 ; i < 8 ; i++) fp.put( char( (table_bytes >> (8*i)) & 0xff ) ); 
+    fp << table ; 
+
+    std::string zeros(ALIGN, '\0') ; 
+    uint64_t pos = PREAMBLE + table_bytes ; 
+    fp.write( zeros.data(), data_start - pos ); 
+    pos = data_start ; 
+
+    for(unsigned i=0 ; i < ee.size() ; i++)
+    {
+        const Entry& e = ee[i] ; 
+        uint64_t start = data_start + e.offset ; 
+        fp.write( zeros.data(), start - pos ); 
+        fp << e.text ; 
+        if(e.a) fp.write( e.a->bytes(), e.a->arr_bytes() ); 
+        pos = start + e.nbytes ; 
+    }
+    fp.close(); 
+    return fp.fail() ? 1 : 0 ; 
+}
+
+
+inline NPFoldPacked::NPFoldPacked()
+    :
+    data_start(0),
+    fd(-1)
+{
+}
+
+inline NPFoldPacked::~NPFoldPacked()
+{
+    close();
+}
+
+/**
+NPFoldPacked::open
+--------------------
+
+Reads only the preamble and the table of entries, indexing them by path.
+The file stays open for the reads of NPFoldPacked::read and
+NPFoldPacked::find_array until NPFoldPacked::close or destruction.
+
+**/
+
+inline int NPFoldPacked::open(const char* path_)
+{
+    close();
+    path = path_ ; 
+
+    fd = ::open(path_, O_RDONLY);
+    char pre[PREAMBLE] ; 
+    if(fd < 0 || pread_(pre, PREAMBLE, 0) != 0 || strncmp(pre, MAGIC, 8) != 0)
+    {
+        std::cerr << "NPFoldPacked::open NOT A PACKED NPFold " << path << std::endl ; 
+        return 1 ; 
+    }
+    uint64_t table_bytes = 0 ; 
+    for(int i=0 ; i < 8 ; i++) table_bytes |= uint64_t((unsigned char)pre[8+i]) << (8*i) ; 
+    data_start = Align( PREAMBLE + table_bytes ) ; 
+
+    std::string table(table_bytes, '\0') ; 
+    if(pread_( &table[0], table_bytes, PREAMBLE ) != 0) return 1 ; 
+
+    std::vector<std::string> lines ; 
+    SplitLines(lines, table); 
+    for(unsigned i=0 ; i < lines.size() ; i++)
+    {
+        std::vector<std::string> elem ; 
+        U::Split(lines[i].c_str(), '\t', elem ); 
+        if(elem.size() != 5) 
+        {
+            std::cerr << "NPFoldPacked::open BAD TABLE LINE " << lines[i] << std::endl ; 
+            return 1 ; 
+        }
+        Entry e = {} ; 
+        e.offset = std::stoull(elem[0]) ; 
+        e.nbytes = std::stoull(elem[1]) ; 
+        e.path = elem[2] ; 
+        e.dtype = elem[3] == "-" ? "" : elem[3] ; 
+        e.shape = elem[4] == "-" ? "" : elem[4] ; 
+        e.a = nullptr ; 
+        entries_idx[e.path] = entries.size() ; 
+        entries.push_back(e); 
+    }
+    return 0 ; 
+}
+
+inline void NPFoldPacked::close()
+{
+    if(fd > -1) ::close(fd);
+    fd = -1 ;
+    entries.clear();
+    entries_idx.clear();
+    data_start = 0 ;
+}
+
+/**
+NPFoldPacked::pread_
+----------------------
+
+Reads *nbytes* at absolute file *offset* into *dst*, looping over short reads.
+
+**/
+
+inline int NPFoldPacked::pread_(char* dst, uint64_t nbytes, uint64_t offset) const 
+{
+    if( fd < 0 ) return 1 ; 
+    uint64_t remaining = nbytes ; 
+    while( remaining > 0 )
+    {
+        ssize_t n = pread(fd, dst, remaining, offset ); 
+        if( n <= 0 ) break ; 
+        dst += n ; 
+        offset += n ; 
+        remaining -= n ; 
+    }
+    return remaining == 0 ? 0 : 1 ; 
+}
+
+inline int NPFoldPacked::find(const char* epath) const 
+{
+    const char* p = epath && epath[0] == '/' ? epath + 1 : epath ; 
+    if( p == nullptr ) return -1 ; 
+    std::unordered_map<std::string, int>::const_iterator it = entries_idx.find(p) ; 
+    return it == entries_idx.end() ? -1 : it->second ; 
+}
+
+/**
+NPFoldPacked::read
+--------------------
+
+Reads the bytes of entry *idx* with pread. 
+
+**/
+
+inline int NPFoldPacked::read(std::string& bytes, int idx) const 
+{
+    if( idx < 0 || idx >= int(entries.size()) ) return 1 ; 
+    const Entry& e = entries[idx] ; 
+    bytes.resize(e.nbytes) ; 
+    return e.nbytes == 0 ? 0 : pread_( &bytes[0], e.nbytes, data_start + e.offset ) ; 
+}
+
+inline bool NPFoldPacked::read(std::string& bytes, const char* epath) const 
+{
+    return read(bytes, find(epath)) == 0 ; 
+}
+
+/**
+NPFoldPacked::find_array
+--------------------------
+
+Creates the array and its sidecar metadata, names and labels from 
+the packed entries, applying the same conventions as NP::load.
+Only the header is read into a string, the array data is read
+with pread directly into the array.
+
+**/
+
+inline NP* NPFoldPacked::find_array(const char* apath) const 
+{
+    int idx = find(apath) ; 
+    if( idx < 0 ) return nullptr ; 
+    const Entry& e = entries[idx] ; 
+    uint64_t e_start = data_start + e.offset ; 
+
+    NP* a = new NP ; 
+    bool ok = false ; 
+    std::string head ; 
+    for(uint64_t hb = std::min( e.nbytes, uint64_t(256) ) ; !ok ; hb = std::min( 2*hb, e.nbytes ))   // headers are usually 128 bytes
+    {
+        head.resize(hb) ; 
+        if(hb == 0 || pread_( &head[0], hb, e_start ) != 0) break ; 
+        std::istringstream iss(head) ; 
+        ok = NPU::_read_header(iss, a->_hdr) ; 
+        if(hb == e.nbytes) break ; 
+    }
+    if(ok) a->decode_header(); 
+    size_t payload_end = ok ? a->hdr_bytes() + a->arr_bytes() : 0 ; 
+    if(ok) ok = payload_end <= e.nbytes && pread_( a->bytes(), a->arr_bytes(), e_start + a->hdr_bytes() ) == 0 ; 
+    if(!ok)
+    {
+        std::cerr << "NPFoldPacked::find_array FAILED FOR " << apath << " IN " << path << std::endl ; 
+        delete a ; 
+        return nullptr ; 
+    }
+    if(!NP::KeepForeign()) a->to_native(); 
+
+    std::string tail(e.nbytes - payload_end, '\0') ; 
+    if(tail.size() > 0 && pread_( &tail[0], tail.size(), e_start + payload_end ) == 0
+       && a->load_embedded_(tail.data(), tail.size()) == 0) return a ; 
+
+    std::string meta_text ; 
+    std::string names_text ; 
+    std::string labels_text ; 
+
+    if(read(meta_text, U::ChangeExt(apath, ".npy", "_meta.txt").c_str()))
+    {
+        std::vector<std::string> lines ; 
+        SplitLines(lines, meta_text) ; 
+        a->meta = Lines(lines) ;  // as NP::load_string_ 
+    }
+    if(read(names_text, U::ChangeExt(apath, ".npy", "_names.txt").c_str())) SplitLines(a->names, names_text) ; 
+    if(read(labels_text, U::ChangeExt(apath, ".npy", "_labels.txt").c_str()))
+    {
+        a->labels = new std::vector<std::string> ; 
+        SplitLines(*a->labels, labels_text) ; 
+    }
+    return a ; 
+}
+
+inline NPFold* NPFoldPacked::load() const 
+{
+    NPFold* f = new NPFold ; 
+    load_r(f, "" ); 
+    return f ; 
+}
+
+/**
+NPFoldPacked::load_r
+----------------------
+
+Follows NPFold::load and NPFold::load_index using the packed entries. 
+
+**/
+
+inline void NPFoldPacked::load_r(NPFold* f, const std::string& rel) const 
+{
+    std::string meta_text ; 
+    if(read(meta_text, Join(rel, NPFold::META).c_str()))
+    {
+        std::vector<std::string> lines ; 
+        SplitLines(lines, meta_text) ; 
+        for(unsigned i=0 ; i < lines.size() ; i++) f->meta += lines[i] + ( i < lines.size() - 1 ? "\n" : "" ) ;  // as U::ReadString 
+    }
+
+    std::string names_text ; 
+    if(read(names_text, Join(rel, NPFold::NAMES).c_str())) SplitLines(f->names, names_text) ; 
+
+    std::string index_text ; 
+    if(!read(index_text, Join(rel, NPFold::INDEX).c_str())) return ; 
+    std::vector<std::string> keys ; 
+    SplitLines(keys, index_text) ; 
+
+    for(unsigned i=0 ; i < keys.size() ; i++)
+    {
+        const char* key = keys[i].c_str() ; 
+        std::string kpath = Join(rel, key) ; 
+        if(NPFold::IsNPY(key))
+        {
+            NP* a = find_array(kpath.c_str()) ; 
+            if(a) f->add(key, a) ; 
+        }
+        else
+        {
+            NPFold* sub = new NPFold ; 
+            load_r(sub, kpath ); 
+            f->add_subfold(key, sub); 
+        }
+    }
+}
+
+/**
+NPFoldPacked::unpack
+----------------------
+
+Writes each entry to its path within *dir*, recreating the NPFold::save layout. 
+
+**/
+
+inline int NPFoldPacked::unpack(const char* dir) const 
+{
+    int rc = 0 ; 
+    for(unsigned i=0 ; i < entries.size() ; i++)
+    {
+        std::string bytes ; 
+        rc += read(bytes, i) ; 
+        std::string fpath = U::form_path(dir, entries[i].path.c_str()) ; 
+        U::MakeDirsForFile(fpath.c_str()); 
+        std::ofstream fp(fpath.c_str(), std::ios::out|std::ios::binary);
+        fp << bytes ; 
+        fp.close(); 
+        if(fp.fail()) rc += 1 ; 
+    }
+    return rc ; 
+}
+
+inline std::string NPFoldPacked::desc() const 
+{
+    std::stringstream ss ; 
+    ss << "NPFoldPacked::desc " << path << " entries " << entries.size() << " data_start " << data_start << std::endl ; 
+    for(unsigned i=0 ; i < entries.size() ; i++) 
+    {
+        const Entry& e = entries[i] ; 
+        ss << std::setw(12) << e.offset 
+           << std::setw(12) << e.nbytes 
+           << " " << std::setw(40) << e.path 
+           << " " << std::setw(5) << e.dtype 
+           << " " << e.shape 
+           << std::endl 
+           ;
+    }
+    std::string str = ss.str(); 
+    return str ; 
+}
+
@@ -0,0 +1,538 @@
+#pragma once
+/**
+NPTex.h : CPU sampling of 2D and 3D NP arrays like CUDA textures
+==================================================================
+
+NP::interp2D answers one (x,y) query with the linear filtering formula
+of CUDA textures but without address modes, asserting that the texels
+are in range, and without 3D. NPTex<T> samples (ny,nx) and (nz,ny,nx)
+arrays as tex2D and tex3D do with::
+
+    filter     NPTex::Point or NPTex::Linear       (cudaFilterModePoint/Linear)
+    address    NPTex::Wrap Clamp Mirror Border     (cudaAddressModeWrap/...), per dimension
+    normalized coordinates in [0,1) or texel coordinates in [0,N)
+
+x addresses the last dimension of the array, as for NP::interp2D and
+the CUDA texture of the array, for example tests/demoTexNP.cu::
+
+    NP* a = NP::Load("/tmp/demoTexNP/a.npy") ;     // (ny,nx) float
+    NPTex<float> tex(a, NPTex<float>::Linear, NPTex<float>::Clamp) ;
+    float v = tex.sample(x, y) ;
+    tex.sample(xs, ys, out, n) ;                   // batch, same values bit for bit
+
+As with CUDA, Wrap and Mirror are only used with normalized coordinates,
+otherwise Clamp is used, and Border gives the border value (zero) for
+texels outside the array. The single and batch samples use the same
+inline NPTex::Coord NPTex::texel and NPTex::Blend2 NPTex::Blend3 arithmetic,
+so give identical values. The batch is processed in fixed size blocks
+of structure of arrays: coordinates, texel indices and weights
+are computed for all lanes of the block before the texel gathers and the blend,
+so for the Clamp and Border modes all but the gather loops vectorize,
+see NPTex::block2D.
+
+CUDA linear filtering weights have only 8 fractional bits, setting
+emulate_9bit rounds the weights to that precision to get close to GPU
+values, by default the weights have full precision.
+
+**/
+
+#include "NP.hh"
+
+template<typename T>
+struct NPTex
+{
+    enum { Wrap=0, Clamp=1, Mirror=2, Border=3 } ;   // cudaTextureAddressMode values
+    enum { Point=0, Linear=1 } ;                     // cudaTextureFilterMode values
+    static constexpr int GENERIC = -1 ;
+    static constexpr int BLOCK = 128 ;               // lanes per block of the batch sample
+
+    const T* vv ;
+    int      dim ;
+    int      n[3] ;          // texels along x, y, z
+    int      address[3] ;
+    int      filter ;
+    bool     normalized ;
+    bool     emulate_9bit ;
+    T        border ;
+    T        limit ;         // coordinates are limited to +-limit texels keeping texel indices within int range
+
+    NPTex(const NP* a, int filter=Linear, int address=Clamp, bool normalized=false );
+
+    void set_address(int d, int mode);
+    int  uniform_mode() const ;
+
+    T    sample(T x, T y) const ;
+    T    sample(T x, T y, T z) const ;
+    void sample(const T* xs, const T* ys, T* out, int64_t num, int num_threads=0) const ;
+    void sample(const T* xs, const T* ys, const T* zs, T* out, int64_t num, int num_threads=0) const ;
+
+    static int Floor(T u) ;
+    template<int M> int texel(int d, int i, bool& inside) const ;
+    struct Axis { T period, step, scale, half, keep, lim ; } ;   // per dimension constants, see NPTex::axis
+    Axis axis(int d) const ;
+    static void Coord(const Axis& ax, T c, int& i0, T& f) ;
+    static T Round9(T f) ;
+    static T Blend2(T a, T b, T v00, T v01, T v10, T v11) ;
+    static T Blend3(T a, T b, T c, const T* v) ;
+    template<int M> T sample2D(T x, T y) const ;
+    template<int M> T sample3D(T x, T y, T z) const ;
+    template<int M> void block2D(const T* xs, const T* ys, T* out, int nb) const ;
+    template<int M> void block3D(const T* xs, const T* ys, const T* zs, T* out, int nb) const ;
+
+    std::string desc() const ;
+};
+
+template<typename T>
+inline NPTex<T>::NPTex(const NP* a, int filter_, int address_, bool normalized_ )
+    :
+    vv(a->cvalues<T>()),
+    dim(a->shape.size()),
+    filter(filter_),
+    normalized(normalized_),
+    emulate_9bit(false),
+    border(0),
+    limit(1e9)
+{
+    bool expect = ( dim == 2 || dim == 3 ) && a->ebyte == int(sizeof(T)) && !a->nodata && !a->fortran_order ;
+    if(!expect) std::cerr << "NPTex requires 2D or 3D C order array with matching type, not " << a->sstr() << " " << a->dtype << std::endl ;
+    assert( expect );
+    for(int d=0 ; d < 3 ; d++)
+    {
+        n[d] = d < dim ? a->shape[dim-1-d] : 1 ;
+        set_address(d, address_) ;
+    }
+}
+
+template<typename T>
+inline void NPTex<T>::set_address(int d, int mode)
+{
+    assert( d >= 0 && d < 3 && mode >= Wrap && mode <= Border );
+    address[d] = !normalized && ( mode == Wrap || mode == Mirror ) ? Clamp : mode ;
+}
+
+/**
+NPTex::uniform_mode
+    common address mode of the used dimensions or GENERIC,
+    selecting the specialization of sample2D/sample3D
+**/
+
+template<typename T>
+inline int NPTex<T>::uniform_mode() const
+{
+    int m = address[0] ;
+    for(int d=1 ; d < dim ; d++) if( address[d] != m ) return GENERIC ;
+    return m ;
+}
+
+/**
+NPTex::Floor
+    floor without libm, valid for |u| below 2^31 which NPTex::Coord ensures
+**/
+
+template<typename T>
+inline int NPTex<T>::Floor(T u) // static
+{
+    int i = int(u) ;
+    return i - int( T(i) > u ) ;
+}
+
+/**
+NPTex::texel
+    index of texel i along dimension d after addressing, inside false for Border texels outside
+**/
+
+template<typename T>
+template<int M>
+inline int NPTex<T>::texel(int d, int i, bool& inside) const
+{
+    int nd = n[d] ;
+    int mode = M == GENERIC ? address[d] : M ;
+    inside = true ;
+    if( mode == Wrap )
+    {
+        int w = i % nd ;
+        return w < 0 ? w + nd : w ;
+    }
+    else if( mode == Mirror )
+    {
+        int w = i % (2*nd) ;
+        w = w < 0 ? w + 2*nd : w ;
+        return w < nd ? w : 2*nd - 1 - w ;
+    }
+    inside = mode == Clamp || ( i >= 0 && i < nd ) ;
+    return std::min( std::max( i, 0 ), nd - 1 ) ;
+}
+
+/**
+NPTex::axis
+    constants of NPTex::Coord along dimension d from the current address
+    mode, filter and normalized settings, so the per lane arithmetic has
+    no branches on the settings and the coordinate loops of NPTex::block2D
+    vectorize. Subtracting zero or scaling by one leaves a coordinate unchanged.
+    The limit is a member rather than a constant, otherwise the compiler
+    folds the two sides of the clamps into branches that do not vectorize.
+**/
+
+template<typename T>
+inline typename NPTex<T>::Axis NPTex<T>::axis(int d) const
+{
+    bool reduce = normalized && ( address[d] == Wrap || address[d] == Mirror ) ;
+    Axis ax ;
+    ax.period = address[d] == Mirror ? T(2) : T(1) ;
+    ax.step   = reduce ? ax.period : T(0) ;
+    ax.scale  = normalized ? T(n[d]) : T(1) ;
+    ax.half   = filter == Point ? T(0) : T(0.5) ;
+    ax.keep   = filter == Point ? T(0) : T(1) ;
+    ax.lim    = limit ;
+    return ax ;
+}
+
+/**
+NPTex::Coord
+    texel i0 and fraction f of coordinate c along an axis. Normalized
+    Wrap and Mirror coordinates are first reduced to one period and
+    all are limited to +-limit texels keeping the indices within int range
+**/
+
+template<typename T>
+inline void NPTex<T>::Coord(const Axis& ax, T c, int& i0, T& f) // static
+{
+    T p = T(Floor(std::min( std::max( c/ax.period, -ax.lim ), ax.lim ))) ;
+    c -= ax.step*p ;
+    c *= ax.scale ;
+    c = std::min( std::max( c, -ax.lim ), ax.lim ) ;
+    T cB = c - ax.half ;
+    i0 = Floor(cB) ;
+    f = ax.keep*( cB - T(i0) ) ;
+}
+
+/**
+NPTex::Round9
+    fraction rounded to the 8 fractional bits of CUDA linear filtering weights, see emulate_9bit
+**/
+
+template<typename T>
+inline T NPTex<T>::Round9(T f) // static
+{
+    return T( int( f*T(256) + T(0.5) ) )/T(256) ;
+}
+
+/**
+NPTex::Blend2 NPTex::Blend3
+    linear filtering of the 4 or 8 texel values with fractions a b c,
+    shared by the single and batch samples so both give the same values
+**/
+
+template<typename T>
+inline T NPTex<T>::Blend2(T a, T b, T v00, T v01, T v10, T v11) // static
+{
+    const T one(1.) ;
+    T z =  (one - a)*(one - b)*v00 +
+                  a *(one - b)*v01 +
+           (one - a)*       b *v10 +
+                  a *       b *v11 ;
+    return z ;
+}
+
+template<typename T>
+inline T NPTex<T>::Blend3(T a, T b, T c, const T* v) // static
+{
+    const T one(1.) ;      // v[(dk*2+dj)*2+di]
+    T w = (one - a)*(one - b)*(one - c)*v[0] +
+                 a *(one - b)*(one - c)*v[1] +
+          (one - a)*       b *(one - c)*v[2] +
+                 a *       b *(one - c)*v[3] +
+          (one - a)*(one - b)*       c *v[4] +
+                 a *(one - b)*       c *v[5] +
+          (one - a)*       b *       c *v[6] +
+                 a *       b *       c *v[7] ;
+    return w ;
+}
+
+/**
+NPTex::sample2D
+    filtering as documented in NP::interp2D with
+    v00 T[i,j] v01 T[i+1,j] v10 T[i,j+1] v11 T[i+1,j+1], (i,j) along (x,y)
+**/
+
+template<typename T>
+template<int M>
+inline T NPTex<T>::sample2D(T x, T y) const
+{
+    int i, j ;
+    T a, b ;
+    Coord(axis(0), x, i, a) ;
+    Coord(axis(1), y, j, b) ;
+    bool ii0, ii1, jj0, jj1 ;
+    int i0 = texel<M>(0, i, ii0) ;
+    int j0 = texel<M>(1, j, jj0) ;
+    if( filter == Point )
+    {
+        T t = vv[j0*n[0]+i0] ;
+        return ii0 && jj0 ? t : border ;
+    }
+    if( emulate_9bit )
+    {
+        a = Round9(a) ;
+        b = Round9(b) ;
+    }
+
+    int i1 = texel<M>(0, i+1, ii1) ;
+    int j1 = texel<M>(1, j+1, jj1) ;
+    T t00 = vv[j0*n[0]+i0] ;     // addressed texels are always in the array, so load then select
+    T t01 = vv[j0*n[0]+i1] ;
+    T t10 = vv[j1*n[0]+i0] ;
+    T t11 = vv[j1*n[0]+i1] ;
+    T v00 = ii0 && jj0 ? t00 : border ;
+    T v01 = ii1 && jj0 ? t01 : border ;
+    T v10 = ii0 && jj1 ? t10 : border ;
+    T v11 = ii1 && jj1 ? t11 : border ;
+    return Blend2(a, b, v00, v01, v10, v11) ;
+}
+
+template<typename T>
+template<int M>
+inline T NPTex<T>::sample3D(T x, T y, T z) const
+{
+    int i, j, k ;
+    T a, b, c ;
+    Coord(axis(0), x, i, a) ;
+    Coord(axis(1), y, j, b) ;
+    Coord(axis(2), z, k, c) ;
+    bool in[2][3] ;
+    int  ix[2][3] ;
+    ix[0][0] = texel<M>(0, i, in[0][0]) ;
+    ix[0][1] = texel<M>(1, j, in[0][1]) ;
+    ix[0][2] = texel<M>(2, k, in[0][2]) ;
+    if( filter == Point )
+    {
+        T t = vv[(ix[0][2]*n[1]+ix[0][1])*n[0]+ix[0][0]] ;
+        return in[0][0] && in[0][1] && in[0][2] ? t : border ;
+    }
+    if( emulate_9bit )
+    {
+        a = Round9(a) ;
+        b = Round9(b) ;
+        c = Round9(c) ;
+    }
+
+    ix[1][0] = texel<M>(0, i+1, in[1][0]) ;
+    ix[1][1] = texel<M>(1, j+1, in[1][1]) ;
+    ix[1][2] = texel<M>(2, k+1, in[1][2]) ;
+
+    T v[8] ;    // [(dk*2+dj)*2+di]
+    for(int dk=0 ; dk < 2 ; dk++)
+    for(int dj=0 ; dj < 2 ; dj++)
+    for(int di=0 ; di < 2 ; di++)
+    {
+        bool inside = in[di][0] && in[dj][1] && in[dk][2] ;
+        T t = vv[(ix[dk][2]*n[1]+ix[dj][1])*n[0]+ix[di][0]] ;
+        v[(dk*2+dj)*2+di] = inside ? t : border ;
+    }
+    return Blend3(a, b, c, v) ;
+}
+
+/**
+NPTex::block2D
+    samples nb <= BLOCK lanes as structure of arrays in separate passes :
+    coordinates and weights, addressed texel indices, texel gathers
+    and the blend. The lanes are copied into full blocks, padded with
+    zero coordinates, so all passes have the fixed trip count BLOCK
+    and no aliasing with the caller arrays. The settings are hoisted
+    out of the passes into NPTex::axis constants and branches outside
+    the loops, so at -O2 all passes but the gathers vectorize for the
+    Clamp and Border modes. Each lane uses the same NPTex::Coord
+    NPTex::texel and NPTex::Blend2 arithmetic as NPTex::sample2D.
+**/
+
+template<typename T>
+template<int M>
+inline void NPTex<T>::block2D(const T* xs, const T* ys, T* out, int nb) const
+{
+    const int B = BLOCK ;
+    const T bd = border ;
+    const Axis ax = axis(0) ;
+    const Axis ay = axis(1) ;
+    T x[B], y[B], a[B], b[B], t[4][B], z[B] ;
+    int i[B], j[B], ix[2][B], jx[2][B], ii[2][B], jj[2][B] ;
+    for(int k=0 ; k < nb ; k++) x[k] = xs[k] ;
+    for(int k=0 ; k < nb ; k++) y[k] = ys[k] ;
+    for(int k=nb ; k < B ; k++) x[k] = y[k] = T(0) ;
+
+    for(int k=0 ; k < B ; k++) Coord(ax, x[k], i[k], a[k]) ;
+    for(int k=0 ; k < B ; k++) Coord(ay, y[k], j[k], b[k]) ;
+
+    int nl = filter == Point ? 1 : 2 ;
+    for(int l=0 ; l < nl ; l++)
+    for(int k=0 ; k < B ; k++)
+    {
+        bool in_i, in_j ;
+        ix[l][k] = texel<M>(0, i[k]+l, in_i) ;
+        jx[l][k] = texel<M>(1, j[k]+l, in_j) ;
+        ii[l][k] = in_i ;
+        jj[l][k] = in_j ;
+    }
+
+    if( filter == Point )
+    {
+        for(int k=0 ; k < B ; k++) t[0][k] = vv[jx[0][k]*n[0]+ix[0][k]] ;
+        for(int k=0 ; k < B ; k++) z[k] = ( ii[0][k] & jj[0][k] ) ? t[0][k] : bd ;
+    }
+    else
+    {
+        if( emulate_9bit ) for(int k=0 ; k < B ; k++) a[k] = Round9(a[k]) ;
+        if( emulate_9bit ) for(int k=0 ; k < B ; k++) b[k] = Round9(b[k]) ;
+        for(int k=0 ; k < B ; k++)
+        {
+            t[0][k] = vv[jx[0][k]*n[0]+ix[0][k]] ;
+            t[1][k] = vv[jx[0][k]*n[0]+ix[1][k]] ;
+            t[2][k] = vv[jx[1][k]*n[0]+ix[0][k]] ;
+            t[3][k] = vv[jx[1][k]*n[0]+ix[1][k]] ;
+        }
+        for(int k=0 ; k < B ; k++) z[k] = Blend2( a[k], b[k],
+                                                  ( ii[0][k] & jj[0][k] ) ? t[0][k] : bd,
+                                                  ( ii[1][k] & jj[0][k] ) ? t[1][k] : bd,
+                                                  ( ii[0][k] & jj[1][k] ) ? t[2][k] : bd,
+                                                  ( ii[1][k] & jj[1][k] ) ? t[3][k] : bd ) ;
+    }
+    for(int k=0 ; k < nb ; k++) out[k] = z[k] ;
+}
+
+/**
+NPTex::block3D
+    as NPTex::block2D with the arithmetic of NPTex::sample3D
+**/
+
+template<typename T>
+template<int M>
+inline void NPTex<T>::block3D(const T* xs, const T* ys, const T* zs, T* out, int nb) const
+{
+    const int B = BLOCK ;
+    const T bd = border ;
+    T c[3][B], f[3][B], t[8][B], w[B] ;
+    int i[3][B], ix[2][3][B], in[2][3][B] ;
+    for(int k=0 ; k < nb ; k++) c[0][k] = xs[k] ;
+    for(int k=0 ; k < nb ; k++) c[1][k] = ys[k] ;
+    for(int k=0 ; k < nb ; k++) c[2][k] = zs[k] ;
+    for(int k=nb ; k < B ; k++) c[0][k] = c[1][k] = c[2][k] = T(0) ;
+
+    for(int d=0 ; d < 3 ; d++)
+    {
+        const Axis ad = axis(d) ;
+        for(int k=0 ; k < B ; k++) Coord(ad, c[d][k], i[d][k], f[d][k]) ;
+    }
+
+    int nl = filter == Point ? 1 : 2 ;
+    for(int l=0 ; l < nl ; l++)
+    for(int d=0 ; d < 3 ; d++)
+    for(int k=0 ; k < B ; k++)
+    {
+        bool inside ;
+        ix[l][d][k] = texel<M>(d, i[d][k]+l, inside) ;
+        in[l][d][k] = inside ;
+    }
+
+    if( filter == Point )
+    {
+        for(int k=0 ; k < B ; k++) t[0][k] = vv[(ix[0][2][k]*n[1]+ix[0][1][k])*n[0]+ix[0][0][k]] ;
+        for(int k=0 ; k < B ; k++) w[k] = ( in[0][0][k] & in[0][1][k] & in[0][2][k] ) ? t[0][k] : bd ;
+    }
+    else
+    {
+        if( emulate_9bit ) for(int d=0 ; d < 3 ; d++) for(int k=0 ; k < B ; k++) f[d][k] = Round9(f[d][k]) ;
+        for(int q=0 ; q < 8 ; q++)
+        {
+            int di = q & 1, dj = (q >> 1) & 1, dk = q >> 2 ;
+            for(int k=0 ; k < B ; k++) t[q][k] = vv[(ix[dk][2][k]*n[1]+ix[dj][1][k])*n[0]+ix[di][0][k]] ;
+            for(int k=0 ; k < B ; k++) t[q][k] = ( in[di][0][k] & in[dj][1][k] & in[dk][2][k] ) ? t[q][k] : bd ;
+        }
+        for(int k=0 ; k < B ; k++)
+        {
+            T v[8] = { t[0][k], t[1][k], t[2][k], t[3][k], t[4][k], t[5][k], t[6][k], t[7][k] } ;
+            w[k] = Blend3( f[0][k], f[1][k], f[2][k], v ) ;
+        }
+    }
+    for(int k=0 ; k < nb ; k++) out[k] = w[k] ;
+}
+
+template<typename T>
+inline T NPTex<T>::sample(T x, T y) const
+{
+    assert( dim == 2 );
+    switch(uniform_mode())
+    {
+        case Clamp:  return sample2D<Clamp>(x, y)  ;
+        case Border: return sample2D<Border>(x, y) ;
+    }
+    return sample2D<GENERIC>(x, y) ;
+}
+
+template<typename T>
+inline T NPTex<T>::sample(T x, T y, T z) const
+{
+    assert( dim == 3 );
+    switch(uniform_mode())
+    {
+        case Clamp:  return sample3D<Clamp>(x, y, z)  ;
+        case Border: return sample3D<Border>(x, y, z) ;
+    }
+    return sample3D<GENERIC>(x, y, z) ;
+}
+
+/**
+NPTex::sample batch
+    out[i] the same as sample(xs[i], ys[i]) or sample(xs[i], ys[i], zs[i]),
+    with the address mode dispatch outside the NPTex::block2D NPTex::block3D
+    blocks which are spread over UPool threads
+**/
+
+template<typename T>
+inline void NPTex<T>::sample(const T* xs, const T* ys, T* out, int64_t num, int num_threads) const
+{
+    assert( dim == 2 );
+    int m = uniform_mode() ;
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        for(int64_t b0=i0 ; b0 < i1 ; b0 += BLOCK)
+        {
+            int nb = std::min( int64_t(BLOCK), i1 - b0 ) ;
+            if(      m == Clamp )  block2D<Clamp>(  xs + b0, ys + b0, out + b0, nb ) ;
+            else if( m == Border ) block2D<Border>( xs + b0, ys + b0, out + b0, nb ) ;
+            else                   block2D<GENERIC>(xs + b0, ys + b0, out + b0, nb ) ;
+        }
+    };
+    UPool::ParallelFor( num, fn, num_threads, 1 << 16 );
+}
+
+template<typename T>
+inline void NPTex<T>::sample(const T* xs, const T* ys, const T* zs, T* out, int64_t num, int num_threads) const
+{
+    assert( dim == 3 );
+    int m = uniform_mode() ;
+    auto fn = [&](int64_t i0, int64_t i1)
+    {
+        for(int64_t b0=i0 ; b0 < i1 ; b0 += BLOCK)
+        {
+            int nb = std::min( int64_t(BLOCK), i1 - b0 ) ;
+            if(      m == Clamp )  block3D<Clamp>(  xs + b0, ys + b0, zs + b0, out + b0, nb ) ;
+            else if( m == Border ) block3D<Border>( xs + b0, ys + b0, zs + b0, out + b0, nb ) ;
+            else                   block3D<GENERIC>(xs + b0, ys + b0, zs + b0, out + b0, nb ) ;
+        }
+    };
+    UPool::ParallelFor( num, fn, num_threads, 1 << 16 );
+}
+
+template<typename T>
+inline std::string NPTex<T>::desc() const
+{
+    const char* names[4] = { "Wrap", "Clamp", "Mirror", "Border" } ;
+    std::stringstream ss ;
+    ss << "NPTex<" << descr_<T>::dtype() << "> " << dim << "D n (" << n[0] << "," << n[1] ;
+    if( dim == 3 ) ss << "," << n[2] ;
+    ss << ") " << ( filter == Point ? "Point" : "Linear" )
+       << " address (" << names[address[0]] << "," << names[address[1]] ;
+    if( dim == 3 ) ss << "," << names[address[2]] ;
+    ss << ")" << ( normalized ? " normalized" : "" ) << ( emulate_9bit ? " emulate_9bit" : "" ) ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -27,11 +27,32 @@ other projects together with NP.hh
 #include <chrono>
 #include <cctype>
 #include <locale>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <new>
+#include <type_traits>
 
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 
 /**
@@ -186,20 +207,20 @@ struct NPS
 {
     NPS(std::vector<int>& shape_ ) : shape(shape_) {}  ; 
 
-    static int set_shape(std::vector<int>& shape_, int ni, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) 
+    static int64_t set_shape(std::vector<int>& shape_, int ni, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1 ) 
     {
         NPS sh(shape_); 
         sh.set_shape(ni,nj,nk,nl,nm,no); 
         return sh.size(); 
     }
 
-    static int copy_shape(std::vector<int>& dst, const std::vector<int>& src) 
+    static int64_t copy_shape(std::vector<int>& dst, const std::vector<int>& src) 
     {
         for(unsigned i=0 ; i < src.size() ; i++) dst.push_back(src[i]); 
         return size(dst); 
     }
 
-    static int copy_shape(std::vector<int>& dst, int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1) 
+    static int64_t copy_shape(std::vector<int>& dst, int ni=-1, int nj=-1, int nk=-1, int nl=-1, int nm=-1, int no=-1) 
     {
         if(ni >= 0) dst.push_back(ni);   // experimental allow zero items
         if(nj > 0) dst.push_back(nj); 
@@ -224,10 +245,10 @@ struct NPS
         copy_shape(shape, other); 
     }
 
-    static int change_shape(std::vector<int>& shp, int ni_, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1)
+    static int64_t change_shape(std::vector<int>& shp, int ni_, int nj_=-1, int nk_=-1, int nl_=-1, int nm_=-1, int no_=-1)
     {
-        unsigned nv0 = size(shp); 
-        unsigned nv1 = std::max(1,ni_)*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
+        int64_t nv0 = size(shp); 
+        int64_t nv1 = product_(ni_, nj_, nk_, nl_, nm_, no_) ; 
 
         if( nv0 != nv1 )  // try to devine a missing -1 entry 
         {
@@ -238,7 +259,7 @@ struct NPS
             else if( nm_ < 0 ) nm_ = nv0/nv1 ; 
             else if( no_ < 0 ) no_ = nv0/nv1 ; 
 
-            unsigned nv2 = std::max(1,ni_)*std::max(1,nj_)*std::max(1,nk_)*std::max(1,nl_)*std::max(1,nm_)*std::max(1,no_) ; 
+            int64_t nv2 = product_(ni_, nj_, nk_, nl_, nm_, no_) ; 
             bool expect = nv0 % nv1 == 0 && nv2 == nv0 ; 
 
             if(!expect) std::cout 
@@ -263,10 +284,22 @@ struct NPS
         return copy_shape(shp, ni_, nj_, nk_, nl_, nm_, no_ ); 
     }
 
-    static int product(const std::vector<int>& src )
+    static int64_t product_(int ni, int nj, int nk, int nl, int nm, int no)
+    {
+        int64_t prod = 1 ; 
+        prod *= std::max(1,ni) ; 
+        prod *= std::max(1,nj) ; 
+        prod *= std::max(1,nk) ; 
+        prod *= std::max(1,nl) ; 
+        prod *= std::max(1,nm) ; 
+        prod *= std::max(1,no) ; 
+        return prod ; 
+    }
+
+    static int64_t product(const std::vector<int>& src )
     {
         int nd = src.size(); 
-        int prod = 1 ; 
+        int64_t prod = 1 ; 
         for(int i=0 ; i < nd ; i++) prod *= src[i] ; 
         return prod ; 
     }
@@ -308,22 +341,22 @@ struct NPS
         return ss.str(); 
     } 
 
-    static int size(const std::vector<int>& shape)
+    static int64_t size(const std::vector<int>& shape)
     {
         int ndim = int(shape.size()); 
-        int sz = 1;
+        int64_t sz = 1;
         for(int i=0; i<ndim; ++i) sz *= shape[i] ;
         return ndim == 0 ? 0 : sz ;  
     }
 
-    static int itemsize(const std::vector<int>& shape)
+    static int64_t itemsize(const std::vector<int>& shape)
     {
-        int sz = 1;
+        int64_t sz = 1;
         for(unsigned i=1; i<shape.size(); ++i) sz *= shape[i] ;
         return sz ;  
     }
 
-    static int itemsize_(const std::vector<int>& shape, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 )
+    static int64_t itemsize_(const std::vector<int>& shape, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1 )
     {
         // assert only one transition from valid indices to skipped indices 
         if( i == -1 )                                                      assert( j == -1 && k == -1 &&  l == -1 && m == -1 && o == -1 ) ;  
@@ -342,7 +375,7 @@ struct NPS
         if( i > -1 && j > -1 && k >  -1 && l >  -1 && m >  -1 && o == -1 ) dim0 = 5 ; 
         if( i > -1 && j > -1 && k >  -1 && l >  -1 && m >  -1 && o >  -1 ) dim0 = 6 ; 
 
-        int sz = 1;
+        int64_t sz = 1;
         if( dim0 < shape.size() )
         {
             for(unsigned d=dim0; d<shape.size(); ++d) sz *= shape[d] ;
@@ -366,7 +399,7 @@ struct NPS
 
     std::string desc() const { return desc(shape) ; }
     std::string json() const { return json(shape) ; }
-    int size() const { return size(shape) ; }
+    int64_t size() const { return size(shape) ; }
      
 
     static int ni_(const std::vector<int>& shape) { return shape.size() > 0 ? shape[0] : 1 ;  }
@@ -383,14 +416,14 @@ struct NPS
     int nm_() const { return nm_(shape) ; }
     int no_() const { return no_(shape) ; }
 
-    int idx(int i, int j, int k, int l, int m, int o)
+    int64_t idx(int i, int j, int k, int l, int m, int o)
     {
-        //int ni = ni_() ;
-        int nj = nj_() ; 
-        int nk = nk_() ; 
-        int nl = nl_() ;
-        int nm = nm_() ;
-        int no = no_() ;
+        //int64_t ni = ni_() ;
+        int64_t nj = nj_() ; 
+        int64_t nk = nk_() ; 
+        int64_t nl = nl_() ;
+        int64_t nm = nm_() ;
+        int64_t no = no_() ;
 
         return  i*nj*nk*nl*nm*no + j*nk*nl*nm*no + k*nl*nm*no + l*nm*no + m*no + o ;
     }
@@ -1815,7 +1848,10 @@ struct NPU
     static std::string make_jsonhdr(const std::vector<int>& shape );
 
     static void parse_header(std::vector<int>& shape, std::string& descr, char& uifc, int& ebyte, const std::string& hdr );
+    static void parse_header(std::vector<int>& shape, std::string& descr, char& uifc, int& ebyte, bool& fortran_order, const std::string& hdr );
     static int  _parse_header_length(const std::string& hdr );
+    static int  _header_prefix_length(const std::string& hdr ); 
+    static bool _read_header(std::istream& is, std::string& hdr ); 
     static void _parse_tuple(std::vector<int>& shape, const std::string& sh );
     static void _parse_dict(bool& little_endian, char& uifc, int& width, std::string& descr, bool& fortran_order, const char* dict); 
     static void _parse_dict(std::string& descr, bool& fortran_order, const char* dict);
@@ -1828,13 +1864,22 @@ struct NPU
     static std::string _make_narrow(const char* descr);  
     static std::string _make_wide(const char* descr);  
     static std::string _make_other(const char* descr, char other);  
+    static bool        _is_native(const char* descr); 
+    static std::string _make_native(const char* descr);  
+    static void        _byteswap(char* p, size_t num, int width); 
+    static void        _narrow(float* b, const double* a, size_t num); 
+    static void        _widen(double* b, const float* a, size_t num); 
 
     static std::string _make_preamble( int major=1, int minor=0 );
-    static std::string _make_header(const std::vector<int>& shape, const char* descr="<f4" );
+    static std::string _make_header(const std::vector<int>& shape, const char* descr="<f4", bool fortran_order=FORTRAN_ORDER );
     static std::string _make_jsonhdr(const std::vector<int>& shape, const char* descr="<f4" );
     static std::string _little_endian_short_string( uint16_t dlen ) ; 
+    static std::string _little_endian_int_string( uint32_t dlen ) ; 
+    static constexpr uint32_t V1_MAX_HEADER_LEN = 0xffff ;  // beyond this version 2.0 header with 4 byte HEADER_LEN is needed
+    static constexpr uint32_t ARRAY_ALIGN = 64 ;            // header padded such that payload starts aligned to this  
+    static constexpr int GROWTH_AXIS_MAX_DIGITS = 21 ;      // room for the first dimension to grow, see _make_header
     static std::string _make_tuple(const std::vector<int>& shape, bool json );
-    static std::string _make_dict(const std::vector<int>& shape, const char* descr );
+    static std::string _make_dict(const std::vector<int>& shape, const char* descr, bool fortran_order=FORTRAN_ORDER );
     static std::string _make_json(const std::vector<int>& shape, const char* descr );
     static std::string _make_header(const std::string& dict);
     static std::string _make_jsonhdr(const std::string& json);
@@ -1944,9 +1989,7 @@ NumPy np.save / np.load
 * https://github.com/numpy/numpy/blob/master/numpy/lib/format.py
 
 */
-    std::string preamble = hdr.substr(0,8) ;  // 6 char MAGIC + 2 char version  
-    std::string PREAMBLE = _make_preamble(); 
-    assert( preamble.compare(PREAMBLE) == 0 );  
+    int plen = _header_prefix_length(hdr) ;  // 10 for version 1.0, 12 for version 2.0 and 3.0 
 
     // previously used "char" here,
     // but thats a bug as when the header exceeds 128 bytes 
@@ -1954,42 +1997,126 @@ NumPy np.save / np.load
     // observed this first with the bnd.npy which has 5 dimensions
     // causing the header to be larger than for example icdf.npy with 3 dimensions
  
-    unsigned char hlen_lsb = hdr[8] ;  
-    unsigned char hlen_msb = hdr[9] ;  
-    int hlen = hlen_msb << 8 | hlen_lsb ; 
+    const unsigned char* hl = (const unsigned char*)hdr.data() + 8 ; 
+    int hlen = plen == 10 ? 
+                           ( hl[1] << 8 | hl[0] ) 
+                        :
+                           ( hl[3] << 24 | hl[2] << 16 | hl[1] << 8 | hl[0] ) 
+                        ;  
 
 #ifdef NPU_DEBUG
     std::cout 
         << " _parse_header_length  "  << std::endl 
         << " hdr               " << std::endl << xxdisplay(hdr, 16, '.' ) << std::endl  
-        << " preamble          " << preamble << std::endl 
-        << " hlen_lsb(hex)     " << std::hex << int(hlen_lsb) << std::endl 
-        << " hlen_msb(hex)     " << std::hex << int(hlen_msb) << std::endl 
+        << " plen              " << std::dec << plen << std::endl 
         << " hlen(hex)         " << std::hex << hlen << std::endl 
-        << " hlen_lsb(dec)     " << std::dec << int(hlen_lsb) << std::endl 
-        << " hlen_msb(dec)     " << std::dec << int(hlen_msb) << std::endl 
         << " hlen(dec)         " << std::dec << hlen << std::endl 
-        << " hlen+10(dec)      " << std::dec << hlen+10 << std::endl 
-        << " (hlen+10)%16(dec) " << (hlen+10)%16 << std::endl 
+        << " hlen+plen(dec)    " << std::dec << hlen+plen << std::endl 
+        << " (hlen+plen)%16    " << (hlen+plen)%16 << std::endl 
         << " hdr.size() (dec)  " << std::dec << hdr.size() << std::endl 
-        << " preamble.size()   " << std::dec << preamble.size() << std::endl 
         << std::endl 
         ; 
 
 #endif
     assert( hlen > 0 ); 
-    assert( (hlen+10) % 16 == 0 ) ;  
-    assert( hlen+10 == int(hdr.size()) ) ; 
+    assert( (hlen+plen) % 16 == 0 ) ;  
+    assert( hlen+plen == int(hdr.size()) ) ; 
 
     return hlen ; 
 }
 
+/**
+NPU::_header_prefix_length
+----------------------------
+
+Checks the 6 char MAGIC and returns the number of bytes preceeding the 
+header dict, which depends on the format version in bytes 6 and 7: 
+
+* version 1.0 : 2 byte HEADER_LEN, prefix of 10 bytes 
+* version 2.0 : 4 byte HEADER_LEN, prefix of 12 bytes (needed when header exceeds 64 KiB)
+* version 3.0 : same layout as 2.0 but with utf8 dict, the dict is ascii for all arrays handled here
+
+**/
+
+inline int NPU::_header_prefix_length(const std::string& hdr ) 
+{
+    assert( hdr.size() >= 10 ); 
+    std::string magic = hdr.substr(0,6) ; 
+    bool magic_expect = magic.compare(MAGIC) == 0 ; 
+    if(!magic_expect) std::cerr << "NPU::_header_prefix_length UNEXPECTED MAGIC " << std::endl ; 
+    assert( magic_expect ); 
+
+    int major = hdr[6] ; 
+    int minor = hdr[7] ; 
+    bool version_expect = ( major == 1 || major == 2 || major == 3 ) && minor == 0 ; 
+    if(!version_expect) std::cerr << "NPU::_header_prefix_length UNEXPECTED VERSION " << major << "." << minor << std::endl ; 
+    assert( version_expect ); 
+
+    return major == 1 ? 10 : 12 ; 
+}
+
+/**
+NPU::_read_header
+-------------------
+
+Reads the complete .npy header from the stream, leaving the 
+stream positioned at the start of the array data. 
+
+Formerly std::getline was used to read up to the newline that terminates 
+the header, but that is fragile as the binary HEADER_LEN bytes can 
+themselves contain the newline char. Instead the HEADER_LEN is 
+decoded from the prefix and exactly that many bytes are read.  
+
+**/
+
+inline bool NPU::_read_header(std::istream& is, std::string& hdr ) 
+{
+    hdr.resize(10) ; 
+    is.read( &hdr[0], 10 ); 
+    if(is.fail()) return false ; 
+
+    int plen = _header_prefix_length(hdr) ; 
+    if( plen > 10 )
+    {
+        hdr.resize(plen) ; 
+        is.read( &hdr[10], plen - 10 ); 
+        if(is.fail()) return false ; 
+    }
+
+    const unsigned char* hl = (const unsigned char*)hdr.data() + 8 ; 
+    uint32_t hlen = plen == 10 ? 
+                                ( hl[1] << 8 | hl[0] ) 
+                              : 
+                                ( uint32_t(hl[3]) << 24 | hl[2] << 16 | hl[1] << 8 | hl[0] ) 
+                              ; 
+    hdr.resize(plen + hlen) ; 
+    is.read( &hdr[plen], hlen ); 
+    return !is.fail() ; 
+}
+
+
+/**
+NPU::parse_header
+-------------------
+
+This overload asserts that the payload is in C order, see the below 
+overload for headers that may have fortran_order True. 
+
+**/
 
 inline void NPU::parse_header(std::vector<int>& shape, std::string& descr, char& uifc, int& ebyte, const std::string& hdr )
+{
+    bool fortran_order ; 
+    parse_header( shape, descr, uifc, ebyte, fortran_order, hdr ); 
+    assert( fortran_order == FORTRAN_ORDER ); 
+}
+
+inline void NPU::parse_header(std::vector<int>& shape, std::string& descr, char& uifc, int& ebyte, bool& fortran_order, const std::string& hdr )
 {
     int hlen = _parse_header_length( hdr ) ; 
+    int plen = _header_prefix_length( hdr ) ; 
 
-    std::string dict = hdr.substr(10,10+hlen) ; 
+    std::string dict = hdr.substr(plen,hlen) ; 
 
     char last = dict[dict.size()-1] ; 
     bool ends_with_newline = last == '\n' ;   
@@ -2008,13 +2135,10 @@ inline void NPU::parse_header(std::vector<int>& shape, std::string& descr, char&
 
 
     bool little_endian ; 
-    bool fortran_order ; 
   
     _parse_dict(little_endian, uifc, ebyte, descr, fortran_order, dict.c_str());
 
-
-    assert( fortran_order == FORTRAN_ORDER ); 
-    assert( little_endian == true ); 
+    // foreign byte order is retained in descr, see NP::to_native 
 
 #ifdef NPU_DEBUG
     std::cout 
@@ -2022,8 +2146,8 @@ inline void NPU::parse_header(std::vector<int>& shape, std::string& descr, char&
         << " hdr               " << std::endl << xxdisplay(hdr, 16, '.' ) << std::endl  
         << " hlen(hex)         " << std::hex << hlen << std::endl 
         << " hlen(dec)         " << std::dec << hlen << std::endl 
-        << " hlen+10(dec)      " << std::dec << hlen+10 << std::endl 
-        << " (hlen+10)%16(dec) " << (hlen+10)%16 << std::endl 
+        << " plen(dec)         " << std::dec << plen << std::endl 
+        << " (hlen+plen)%16    " << (hlen+plen)%16 << std::endl 
         << " dict [" << xxdisplay(dict,200,'.') << "]"<< std::endl 
         << " p0( " << p0 << std::endl
         << " p1) " << p1 << std::endl
@@ -2221,6 +2345,183 @@ inline std::string NPU::_make_other(const char* descr, char other) // static
     _parse_descr( little_endian, uifc, ebyte, descr ); 
     return _make_descr(little_endian, other, ebyte  ); 
 } 
+
+/**
+NPU::_is_native
+-----------------
+
+True when elements described by *descr* are in the byte order of this 
+machine : single bytes, not applicable '|' or matching endian::detect. 
+
+**/
+
+inline bool NPU::_is_native(const char* descr) // static
+{
+    bool little_endian ; 
+    char uifc ; 
+    int ebyte ; 
+    _parse_descr( little_endian, uifc, ebyte, descr ); 
+    return ebyte == 1 || descr[0] == '|' || descr[0] == endian::detect() ; 
+}
+
+inline std::string NPU::_make_native(const char* descr) // static
+{
+    bool little_endian ; 
+    char uifc ; 
+    int ebyte ; 
+    _parse_descr( little_endian, uifc, ebyte, descr ); 
+    return _make_descr(endian::detect() == endian::LITTLE, uifc, ebyte  ); 
+}
+
+/**
+NPU::_byteswap
+----------------
+
+Reverses in place the byte order of *num* elements of *width* bytes,
+for complex elements use the width of the parts. 
+The payload need not be aligned. Vector kernels swap 16 or 32 bytes 
+per step:
+
+AVX2, SSSE3 (eg with -march=native)
+    byte shuffle of 32 or 16 bytes with a mask reversing each element
+
+SSE2 (any x86_64)
+    16-bit word shuffles reversing the words of each element 
+    then shifts swapping the bytes of each word 
+
+NEON 
+    vrev16q_u8 vrev32q_u8 vrev64q_u8
+
+The remainder and other platforms use __builtin_bswap. 
+
+**/
+
+inline void NPU::_byteswap(char* p, size_t num, int width) // static
+{
+    if(width < 2 || num == 0) return ; 
+    assert( width == 2 || width == 4 || width == 8 ); 
+    size_t bytes = num*width ; 
+    size_t i = 0 ; 
+
+#if defined(__SSSE3__)
+    char mk[32] ; 
+    for(int k=0 ; k < 32 ; k++) mk[k] = (k%16/width)*width + width - 1 - k%width ; 
+#if defined(__AVX2__)
+    const __m256i m32 = _mm256_loadu_si256( (const __m256i*)mk ) ; 
+    for( ; i + 32 <= bytes ; i += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( (const __m256i*)(p + i) ) ; 
+        _mm256_storeu_si256( (__m256i*)(p + i), _mm256_shuffle_epi8(v, m32) ); 
+    }
+#endif
+    const __m128i m16 = _mm_loadu_si128( (const __m128i*)mk ) ; 
+    for( ; i + 16 <= bytes ; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i*)(p + i) ) ; 
+        _mm_storeu_si128( (__m128i*)(p + i), _mm_shuffle_epi8(v, m16) ); 
+    }
+#elif defined(__SSE2__)
+    for( ; i + 16 <= bytes ; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i*)(p + i) ) ; 
+        if( width == 4 )
+        {
+            v = _mm_shufflelo_epi16( v, _MM_SHUFFLE(2,3,0,1) ); 
+            v = _mm_shufflehi_epi16( v, _MM_SHUFFLE(2,3,0,1) ); 
+        }
+        else if( width == 8 )
+        {
+            v = _mm_shufflelo_epi16( v, _MM_SHUFFLE(0,1,2,3) ); 
+            v = _mm_shufflehi_epi16( v, _MM_SHUFFLE(0,1,2,3) ); 
+        }
+        v = _mm_or_si128( _mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8) ); 
+        _mm_storeu_si128( (__m128i*)(p + i), v ); 
+    }
+#elif defined(__ARM_NEON)
+    for( ; i + 16 <= bytes ; i += 16 )
+    {
+        uint8x16_t v = vld1q_u8( (const uint8_t*)(p + i) ) ; 
+        v = width == 2 ? vrev16q_u8(v) : ( width == 4 ? vrev32q_u8(v) : vrev64q_u8(v) ) ; 
+        vst1q_u8( (uint8_t*)(p + i), v ); 
+    }
+#endif
+
+    switch(width)
+    {
+        case 2: for( ; i < bytes ; i += 2 ) { uint16_t v ; memcpy(&v, p + i, 2) ; v = __builtin_bswap16(v) ; memcpy(p + i, &v, 2) ; } ; break ; 
+        case 4: for( ; i < bytes ; i += 4 ) { uint32_t v ; memcpy(&v, p + i, 4) ; v = __builtin_bswap32(v) ; memcpy(p + i, &v, 4) ; } ; break ; 
+        case 8: for( ; i < bytes ; i += 8 ) { uint64_t v ; memcpy(&v, p + i, 8) ; v = __builtin_bswap64(v) ; memcpy(p + i, &v, 8) ; } ; break ; 
+    }
+}
+
+/**
+NPU::_narrow NPU::_widen
+---------------------------
+
+Converts *num* values double to float or float to double, 
+with the same results as the scalar casts (same instructions, 
+current rounding mode). Unaligned pointers are accepted. 
+Vector kernels convert 8 (AVX), 4 (SSE2) or 4 (aarch64 NEON) 
+values per step and the remainder uses scalar casts. 
+
+**/
+
+inline void NPU::_narrow(float* b, const double* a, size_t num) // static
+{
+    size_t i = 0 ; 
+#if defined(__AVX__)
+    for( ; i + 8 <= num ; i += 8 )
+    {
+        __m128 lo = _mm256_cvtpd_ps( _mm256_loadu_pd(a + i) ) ; 
+        __m128 hi = _mm256_cvtpd_ps( _mm256_loadu_pd(a + i + 4) ) ; 
+        _mm256_storeu_ps( b + i, _mm256_insertf128_ps( _mm256_castps128_ps256(lo), hi, 1 ) ); 
+    }
+#endif
+#if defined(__SSE2__)
+    for( ; i + 4 <= num ; i += 4 )
+    {
+        __m128 lo = _mm_cvtpd_ps( _mm_loadu_pd(a + i) ) ; 
+        __m128 hi = _mm_cvtpd_ps( _mm_loadu_pd(a + i + 2) ) ; 
+        _mm_storeu_ps( b + i, _mm_movelh_ps(lo, hi) ); 
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for( ; i + 4 <= num ; i += 4 )
+    {
+        float32x2_t lo = vcvt_f32_f64( vld1q_f64(a + i) ) ; 
+        float32x2_t hi = vcvt_f32_f64( vld1q_f64(a + i + 2) ) ; 
+        vst1q_f32( b + i, vcombine_f32(lo, hi) ); 
+    }
+#endif
+    for( ; i < num ; i++ ) b[i] = float(a[i]) ; 
+}
+
+inline void NPU::_widen(double* b, const float* a, size_t num) // static
+{
+    size_t i = 0 ; 
+#if defined(__AVX__)
+    for( ; i + 8 <= num ; i += 8 )
+    {
+        _mm256_storeu_pd( b + i,     _mm256_cvtps_pd( _mm_loadu_ps(a + i) ) ); 
+        _mm256_storeu_pd( b + i + 4, _mm256_cvtps_pd( _mm_loadu_ps(a + i + 4) ) ); 
+    }
+#endif
+#if defined(__SSE2__)
+    for( ; i + 4 <= num ; i += 4 )
+    {
+        __m128 v = _mm_loadu_ps(a + i) ; 
+        _mm_storeu_pd( b + i,     _mm_cvtps_pd(v) ); 
+        _mm_storeu_pd( b + i + 2, _mm_cvtps_pd( _mm_movehl_ps(v, v) ) ); 
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for( ; i + 4 <= num ; i += 4 )
+    {
+        float32x4_t v = vld1q_f32(a + i) ; 
+        vst1q_f64( b + i,     vcvt_f64_f32( vget_low_f32(v) ) ); 
+        vst1q_f64( b + i + 2, vcvt_high_f64_f32(v) ); 
+    }
+#endif
+    for( ; i < num ; i++ ) b[i] = double(a[i]) ; 
+}
  
 
 
@@ -2255,9 +2556,27 @@ inline int NPU::check(const char* path)
 
 
 
-inline std::string NPU::_make_header(const std::vector<int>& shape, const char* descr )
+/**
+NPU::_make_header
+-------------------
+
+As NumPy does the dict is followed by spaces to allow the growth axis 
+to grow up to GROWTH_AXIS_MAX_DIGITS digits without changing the 
+header length, so the header can be rewritten in place when items 
+are appended to the file. The growth axis is the first dimension, 
+or the last with fortran_order as the payload is column-major. 
+
+**/
+
+inline std::string NPU::_make_header(const std::vector<int>& shape, const char* descr, bool fortran_order )
 {
-    std::string dict = _make_dict( shape, descr ); 
+    std::string dict = _make_dict( shape, descr, fortran_order ); 
+    if( shape.size() > 0 )
+    {
+        int growth_axis = fortran_order ? shape.size() - 1 : 0 ; 
+        int ndig = std::to_string(shape[growth_axis]).size() ; 
+        if( ndig < GROWTH_AXIS_MAX_DIGITS ) dict += std::string( GROWTH_AXIS_MAX_DIGITS - ndig, ' ' ) ; 
+    }
     std::string header = _make_header( dict ); 
     return header ; 
 }
@@ -2270,12 +2589,12 @@ inline std::string NPU::_make_jsonhdr(const std::vector<int>& shape, const char*
 
 
 
-inline std::string NPU::_make_dict(const std::vector<int>& shape, const char* descr )
+inline std::string NPU::_make_dict(const std::vector<int>& shape, const char* descr, bool fortran_order )
 {
     std::stringstream ss ; 
     ss << "{" ; 
     ss << "'descr': '" << descr << "', " ; 
-    ss << "'fortran_order': " << ( FORTRAN_ORDER ? "True" : "False" ) << ", " ; 
+    ss << "'fortran_order': " << ( fortran_order ? "True" : "False" ) << ", " ; 
     ss << "'shape': " ; 
     bool json = false ; 
     ss << _make_tuple( shape, json ) ; 
@@ -2347,6 +2666,14 @@ inline std::string NPU::_little_endian_short_string( uint16_t dlen )
 }
 
 
+inline std::string NPU::_little_endian_int_string( uint32_t dlen )
+{
+    // version 2.0 : The next 4 bytes form a little-endian unsigned int: the length of the header data HEADER_LEN
+    std::string hlen(4, ' ') ;
+    for(int i=0 ; i < 4 ; i++) hlen[i] = char( (dlen >> (8*i)) & 0xff ) ;  
+    return hlen ; 
+}
+
 inline std::string NPU::_make_preamble( int major, int minor )
 {
     std::string preamble(MAGIC) ; 
@@ -2355,12 +2682,32 @@ inline std::string NPU::_make_preamble( int major, int minor )
     return preamble ; 
 }
 
+/**
+NPU::_make_header
+-------------------
+
+Follows NumPy format.py _wrap_header : the dict is padded with spaces 
+and terminated with a newline such that the total header length 
+(preamble + HEADER_LEN field + dict + padding + newline) is a multiple 
+of ARRAY_ALIGN 64 bytes. So the array payload that follows the header 
+starts 64-byte aligned in the file and hence also within a page aligned 
+memory mapping of the file, as used by NP::LoadMapped. 
+
+The version 1.0 header with 2 byte HEADER_LEN is used whenever possible 
+for bit-perfect matching with NumPy. Only when the padded dict would 
+exceed V1_MAX_HEADER_LEN is the version 2.0 header with 4 byte HEADER_LEN used, 
+just as NumPy does. 
+
+**/
+
 inline std::string NPU::_make_header(const std::string& dict)
 {
-    uint16_t dlen = dict.size() ;
-    uint16_t padding = 16 - ((10 + dlen ) % 16 ) - 1 ;
-    padding += 3*16 ; // adhoc extra padding for bit-perfect matching to NumPy (for test array anyhow)
-    uint16_t hlen = dlen + padding + 1 ; 
+    uint32_t dlen = dict.size() ;
+    uint32_t padding_v1 = ARRAY_ALIGN - (( 10 + dlen + 1 ) % ARRAY_ALIGN ) ; 
+    bool v1 = dlen + 1 + padding_v1 <= V1_MAX_HEADER_LEN ; 
+    uint32_t plen = v1 ? 10 : 12 ; 
+    uint32_t padding = ARRAY_ALIGN - (( plen + dlen + 1 ) % ARRAY_ALIGN ) ; 
+    uint32_t hlen = dlen + padding + 1 ; 
 
 #ifdef NPU_DEBUG
     std::cout 
@@ -2371,13 +2718,13 @@ inline std::string NPU::_make_header(const std::string& dict)
         ; 
 #endif
 
-    assert( (hlen + 10) % 16 == 0 );  
+    assert( (hlen + plen) % ARRAY_ALIGN == 0 );  
     std::stringstream ss ; 
-    ss << _make_preamble() ;  
-    ss << _little_endian_short_string( hlen ) ; 
+    ss << _make_preamble( v1 ? 1 : 2, 0 ) ;  
+    ss << ( v1 ? _little_endian_short_string( hlen ) : _little_endian_int_string( hlen ) ) ; 
     ss << dict ; 
  
-    for(int i=0 ; i < padding ; i++ ) ss << " " ; 
+    for(uint32_t i=0 ; i < padding ; i++ ) ss << " " ; 
     ss << "\n" ;  
 
     return ss.str(); 
@@ -2561,6 +2908,1018 @@ inline std::string UName::as_str() const
 
 
 
+/**
+UPool : fixed size pool of worker threads
+-------------------------------------------
+
+Tasks are queued with UPool::submit, each returning a std::future 
+of the int task return code. The threads are started by the ctor 
+and joined by the dtor after draining the queue. 
+
+UPool::NumThreads gives the default thread count, from envvar NP_THREADS 
+when defined otherwise std::thread::hardware_concurrency. 
+
+UPool::ParallelFor splits the range [0,n) into contiguous chunks 
+processed by short lived threads, calling fn(i0, i1) for each chunk. 
+It runs on the calling thread when n is small or only one thread is available.
+
+UPool::ParallelForPinned uses the same chunks with every chunk on a new
+thread pinned with pthread_setaffinity_np to one of the CPUs the process
+may run on, chunk t of nt to CPU (t*num_cpu)/nt of the allowed set.
+Repeated calls with the same n and num_threads therefore process each
+chunk on the same CPU, and so on the same NUMA node, see NP::MakeNUMA.
+Where pinning is not available it behaves as UPool::ParallelFor.
+
+UPool::ParallelEach calls fn(i) for each i in [0,n) with the threads 
+claiming the next index from a shared atomic counter as they become free, 
+which balances the load when the work per index varies greatly, 
+eg reading files of very different sizes. 
+
+**/
+
+struct UPool
+{
+    static constexpr const char* NP_THREADS = "NP_THREADS" ; 
+    static int NumThreads(int num_threads=0); 
+
+    template<typename F>
+    static void ParallelFor(int64_t n, F fn, int num_threads=0, int64_t min_chunk=1024 ); 
+
+    template<typename F>
+    static void ParallelForPinned(int64_t n, F fn, int num_threads=0, int64_t min_chunk=1 ); 
+
+    static std::vector<int> AllowedCPUs(); 
+    static int PinToCPU(int cpu);   // pins the calling thread, returns non-zero on failure 
+
+    template<typename F>
+    static void ParallelEach(int64_t n, F fn, int num_threads=0 ); 
+
+    std::vector<std::thread>               threads ; 
+    std::deque<std::packaged_task<int()>>  tasks ; 
+    std::mutex                             mtx ; 
+    std::condition_variable                cv ; 
+    bool                                   stop ; 
+
+    UPool(int num_threads=0); 
+    ~UPool(); 
+
+    std::future<int> submit(std::function<int()> fn); 
+    int num_threads() const ; 
+
+    private:
+    void work(); 
+}; 
+
+inline int UPool::NumThreads(int num_threads) // static
+{
+    if(num_threads > 0) return num_threads ; 
+    int hc = std::thread::hardware_concurrency() ; 
+    int nt = U::GetEnvInt(NP_THREADS, hc ) ; 
+    return std::max(1, nt) ; 
+}
+
+template<typename F>
+inline void UPool::ParallelFor(int64_t n, F fn, int num_threads, int64_t min_chunk) // static
+{
+    if( n <= 0 ) return ; 
+    int64_t nt = NumThreads(num_threads) ; 
+    int64_t max_nt = std::max( int64_t(1), n/std::max(int64_t(1), min_chunk) ) ; 
+    if( nt > max_nt ) nt = max_nt ; 
+
+    if( nt == 1 ) 
+    {
+        fn(0, n); 
+        return ; 
+    }
+
+    int64_t chunk = (n + nt - 1)/nt ; 
+    std::vector<std::thread> tt ; 
+    for(int64_t t=1 ; t < nt ; t++)
+    {
+        int64_t i0 = t*chunk ; 
+        int64_t i1 = std::min(n, i0 + chunk) ; 
+        if( i0 < i1 ) tt.push_back( std::thread( [&fn, i0, i1](){ fn(i0, i1) ; } ) ); 
+    }
+    fn(0, std::min(n, chunk));   // first chunk on calling thread 
+    for(unsigned i=0 ; i < tt.size() ; i++) tt[i].join(); 
+}
+
+template<typename F>
+inline void UPool::ParallelForPinned(int64_t n, F fn, int num_threads, int64_t min_chunk) // static
+{
+    if( n <= 0 ) return ; 
+    int64_t nt = NumThreads(num_threads) ; 
+    int64_t max_nt = std::max( int64_t(1), n/std::max(int64_t(1), min_chunk) ) ; 
+    if( nt > max_nt ) nt = max_nt ; 
+
+    std::vector<int> cpus = AllowedCPUs() ; 
+    if( nt == 1 || cpus.size() == 0 ) 
+    {
+        ParallelFor( n, fn, nt, min_chunk ); 
+        return ; 
+    }
+
+    int64_t num_cpu = cpus.size() ; 
+    int64_t chunk = (n + nt - 1)/nt ; 
+    std::vector<std::thread> tt ; 
+    for(int64_t t=0 ; t < nt ; t++)
+    {
+        int64_t i0 = t*chunk ; 
+        int64_t i1 = std::min(n, i0 + chunk) ; 
+        int cpu = cpus[(t*num_cpu)/nt] ; 
+        if( i0 < i1 ) tt.push_back( std::thread( [&fn, i0, i1, cpu](){ PinToCPU(cpu) ; fn(i0, i1) ; } ) ); 
+    }
+    for(unsigned i=0 ; i < tt.size() ; i++) tt[i].join(); 
+}
+
+/**
+UPool::AllowedCPUs
+--------------------
+
+Ascending ids of the CPUs in the affinity mask of the process,
+empty when not available.
+
+**/
+
+inline std::vector<int> UPool::AllowedCPUs() // static
+{
+    std::vector<int> cpus ; 
+#if defined(__linux__)
+    cpu_set_t set ; 
+    CPU_ZERO(&set); 
+    if( sched_getaffinity(0, sizeof(set), &set) == 0 ) 
+        for(int c=0 ; c < CPU_SETSIZE ; c++) if(CPU_ISSET(c, &set)) cpus.push_back(c) ; 
+#endif
+    return cpus ; 
+}
+
+inline int UPool::PinToCPU(int cpu) // static
+{
+#if defined(__linux__)
+    cpu_set_t set ; 
+    CPU_ZERO(&set); 
+    CPU_SET(cpu, &set); 
+    return pthread_setaffinity_np( pthread_self(), sizeof(set), &set ); 
+#else
+    return 1 ; 
+#endif
+}
+
+template<typename F>
+inline void UPool::ParallelEach(int64_t n, F fn, int num_threads) // static
+{
+    if( n <= 0 ) return ; 
+    int64_t nt = std::min( int64_t(NumThreads(num_threads)), n ) ; 
+    std::atomic<int64_t> next(0) ; 
+    auto claim = [&fn, &next, n](){ for(int64_t i=next++ ; i < n ; i=next++) fn(i) ; } ; 
+
+    std::vector<std::thread> tt ; 
+    for(int64_t t=1 ; t < nt ; t++) tt.push_back( std::thread(claim) ); 
+    claim(); 
+    for(unsigned i=0 ; i < tt.size() ; i++) tt[i].join(); 
+}
+
+inline UPool::UPool(int num_threads)
+    :
+    stop(false)
+{
+    int nt = NumThreads(num_threads) ; 
+    for(int i=0 ; i < nt ; i++) threads.push_back( std::thread( &UPool::work, this ) ); 
+}
+
+inline UPool::~UPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx); 
+        stop = true ; 
+    }
+    cv.notify_all(); 
+    for(unsigned i=0 ; i < threads.size() ; i++) threads[i].join(); 
+}
+
+inline std::future<int> UPool::submit(std::function<int()> fn)
+{
+    std::packaged_task<int()> task(fn); 
+    std::future<int> result = task.get_future(); 
+    {
+        std::unique_lock<std::mutex> lock(mtx); 
+        tasks.push_back(std::move(task)); 
+    }
+    cv.notify_one(); 
+    return result ; 
+}
+
+inline int UPool::num_threads() const 
+{
+    return threads.size() ; 
+}
+
+inline void UPool::work()
+{
+    while(true)
+    {
+        std::packaged_task<int()> task ; 
+        {
+            std::unique_lock<std::mutex> lock(mtx); 
+            cv.wait(lock, [this]{ return stop || !tasks.empty() ; }); 
+            if(stop && tasks.empty()) return ; 
+            task = std::move(tasks.front()); 
+            tasks.pop_front(); 
+        }
+        task(); 
+    }
+}
+
+
+/**
+NPPhilox : counter based Philox4x32-10 random stream
+------------------------------------------------------
+
+Stateless generator of the Random123 Philox4x32-10 bijection where each 
+128-bit counter gives four 32-bit outputs from a 64-bit key. 
+Construction and draws follow the CUDA curand conventions of 
+curandStatePhilox4_32_10_t such that::
+
+    NPPhilox rng(seed, subsequence, offset) ;   // curand_init(seed, subsequence, offset, &state) 
+    rng.next()                                   // curand(&state)
+    rng.uniform<float>()                         // curand_uniform(&state)          (0,1]
+    rng.uniform<double>()                        // curand_uniform_double(&state)   (0,1]
+
+The stream of each subsequence (eg an item or photon index) depends only 
+on (seed, subsequence, offset), so generating items in any order or 
+from any number of threads gives bitwise identical results, and CPU 
+reproductions of GPU sampling keyed in the same way use the same randoms. 
+
+**/
+
+struct NPPhilox
+{
+    static constexpr uint32_t M0 = 0xD2511F53u ; 
+    static constexpr uint32_t M1 = 0xCD9E8D57u ; 
+    static constexpr uint32_t W0 = 0x9E3779B9u ; 
+    static constexpr uint32_t W1 = 0xBB67AE85u ; 
+
+    static void  Block(uint32_t out[4], const uint32_t ctr[4], const uint32_t key[2]); 
+    static float  U01(uint32_t x) ; 
+    static double U01(uint32_t x, uint32_t y) ; 
+
+    template<typename T> 
+    static T Uniform(uint64_t seed, uint64_t subsequence); 
+
+    uint32_t key[2] ; 
+    uint32_t ctr[4] ; 
+    uint32_t out[4] ; 
+    int      pos ; 
+
+    NPPhilox(uint64_t seed, uint64_t subsequence=0, uint64_t offset=0); 
+
+    void     incr(uint64_t n=1); 
+    uint32_t next(); 
+
+    template<typename T> T uniform(); 
+}; 
+
+/**
+NPPhilox::Block
+-----------------
+
+Ten rounds of the Philox S-box with the key bumped by the Weyl constants 
+between rounds. 
+
+**/
+
+inline void NPPhilox::Block(uint32_t out[4], const uint32_t ctr[4], const uint32_t key[2]) // static
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3] ; 
+    uint32_t k0 = key[0], k1 = key[1] ; 
+    for(int r=0 ; r < 10 ; r++)
+    {
+        uint64_t p0 = uint64_t(M0)*c0 ; 
+        uint64_t p1 = uint64_t(M1)*c2 ; 
+        uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0 ; 
+        uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1 ; 
+        c1 = uint32_t(p1) ; 
+        c3 = uint32_t(p0) ; 
+        c0 = n0 ; 
+        c2 = n2 ; 
+        k0 += W0 ; 
+        k1 += W1 ; 
+    }
+    out[0] = c0 ; out[1] = c1 ; out[2] = c2 ; out[3] = c3 ; 
+}
+
+/**
+NPPhilox::U01
+---------------
+
+32-bit and 53-bit conversions to (0,1] as _curand_uniform and _curand_uniform_double_hq 
+
+**/
+
+inline float NPPhilox::U01(uint32_t x) // static
+{
+    return float(x)*2.3283064e-10f + (2.3283064e-10f/2.0f) ; 
+}
+inline double NPPhilox::U01(uint32_t x, uint32_t y) // static
+{
+    uint64_t z = uint64_t(x) ^ ( uint64_t(y) << (53 - 32) ) ; 
+    return double(z)*1.1102230246251565e-16 + (1.1102230246251565e-16/2.0) ; 
+}
+
+/**
+NPPhilox::Uniform
+-------------------
+
+First uniform of the subsequence, equivalent to NPPhilox(seed, subsequence).uniform<T>() 
+but without keeping the stream state. 
+
+**/
+
+template<typename T>
+inline T NPPhilox::Uniform(uint64_t seed, uint64_t subsequence) // static
+{
+    uint32_t key[2] = { uint32_t(seed), uint32_t(seed >> 32) } ; 
+    uint32_t ctr[4] = { 0u, 0u, uint32_t(subsequence), uint32_t(subsequence >> 32) } ; 
+    uint32_t out[4] ; 
+    Block(out, ctr, key); 
+    return sizeof(T) == sizeof(float) ? T(U01(out[0])) : T(U01(out[0], out[1])) ; 
+}
+
+inline NPPhilox::NPPhilox(uint64_t seed, uint64_t subsequence, uint64_t offset)
+    :
+    pos(0)
+{
+    key[0] = uint32_t(seed) ; 
+    key[1] = uint32_t(seed >> 32) ; 
+    ctr[0] = 0u ; 
+    ctr[1] = 0u ; 
+    ctr[2] = uint32_t(subsequence) ; 
+    ctr[3] = uint32_t(subsequence >> 32) ; 
+    incr( offset >> 2 ); 
+    pos = int(offset & 3) ; 
+    Block(out, ctr, key); 
+}
+
+/**
+NPPhilox::incr
+----------------
+
+Advance the low 64 bits of the counter by n with carry into the subsequence bits. 
+
+**/
+
+inline void NPPhilox::incr(uint64_t n)
+{
+    uint64_t lo = ( uint64_t(ctr[1]) << 32 ) | ctr[0] ; 
+    uint64_t nlo = lo + n ; 
+    ctr[0] = uint32_t(nlo) ; 
+    ctr[1] = uint32_t(nlo >> 32) ; 
+    if( nlo < lo ) 
+    {
+        if( ++ctr[2] == 0u ) ++ctr[3] ; 
+    }
+}
+
+inline uint32_t NPPhilox::next()
+{
+    uint32_t r = out[pos++] ; 
+    if( pos == 4 )
+    {
+        incr(); 
+        Block(out, ctr, key); 
+        pos = 0 ; 
+    }
+    return r ; 
+}
+
+template<typename T>
+inline T NPPhilox::uniform()
+{
+    if( sizeof(T) == sizeof(float) ) return T(U01(next())) ; 
+    uint32_t x = next() ; 
+    uint32_t y = next() ; 
+    return T(U01(x, y)) ; 
+}
+
+
+/**
+NPAlloc : aligned allocator that does not zero 
+-------------------------------------------------
+
+Used for the NP::data payload vector such that:
+
+1. allocations are 64-byte aligned (NPAlloc::ALIGN), allowing SIMD kernels 
+   to assume alignment of NP::bytes NP::values 
+2. when envvar NP_HUGEPAGES is defined allocations of at least 2 MiB 
+   are 2 MiB aligned (NPAlloc::HUGE_ALIGN) and advised to use transparent huge pages 
+3. value initialization from vector resize default-initializes, ie does 
+   not zero, so payloads that are about to be overwritten (loading, copying, 
+   concatenating) are written only once. NP::init zeros explicitly 
+   unless NP::MakeUninitialized is used. 
+
+The allocator carries an optional alignment, eg NPAlloc<char>(NPAlloc<char>::HUGE_ALIGN), 
+used for all allocations in place of the envvar controlled default. 
+That allows the alignment to be chosen per array with NP::set_align
+independently of when NP_HUGEPAGES is first read. 
+Allocators compare equal whatever the alignment as all allocations are 
+released with free. 
+
+**/
+
+template<typename T>
+struct NPAlloc
+{
+    typedef T value_type ; 
+    static constexpr const char* NP_HUGEPAGES = "NP_HUGEPAGES" ; 
+    static constexpr size_t ALIGN = 64 ; 
+    static constexpr size_t HUGE_ALIGN = 2*1024*1024 ; 
+    template<typename U> struct rebind { typedef NPAlloc<U> other ; } ; 
+    typedef std::true_type propagate_on_container_move_assignment ; 
+    typedef std::true_type propagate_on_container_swap ; 
+
+    static bool HugePages(); 
+
+    size_t align ;   // 0 : ALIGN or with NP_HUGEPAGES HUGE_ALIGN for large allocations  
+
+    NPAlloc(size_t align_=0) noexcept : align(align_) {} 
+    template<typename U> NPAlloc(const NPAlloc<U>& other) noexcept : align(other.align) {} 
+
+    T* allocate(size_t n); 
+    void deallocate(T* p, size_t n) noexcept ; 
+
+    template<typename U> void construct(U* p) { ::new((void*)p) U ; }   // default-init : no zeroing 
+    template<typename U, typename... Args> void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...) ; }
+}; 
+
+template<typename T, typename U> inline bool operator==(const NPAlloc<T>&, const NPAlloc<U>&) { return true ; }
+template<typename T, typename U> inline bool operator!=(const NPAlloc<T>&, const NPAlloc<U>&) { return false ; }
+
+template<typename T>
+inline bool NPAlloc<T>::HugePages() // static
+{
+    static bool huge = getenv(NP_HUGEPAGES) != nullptr ; 
+    return huge ; 
+}
+
+template<typename T>
+inline T* NPAlloc<T>::allocate(size_t n)
+{
+    size_t bytes = n*sizeof(T) ; 
+    bool huge = align > 0 ? align >= HUGE_ALIGN : HugePages() && bytes >= HUGE_ALIGN ; 
+    size_t a = align > 0 ? ( align > ALIGN ? align : size_t(ALIGN) ) : ( huge ? HUGE_ALIGN : ALIGN ) ; 
+    void* p = nullptr ; 
+    if( posix_memalign(&p, a, std::max(bytes, size_t(1))) != 0 ) throw std::bad_alloc() ; 
+#ifdef MADV_HUGEPAGE
+    if(huge) madvise(p, bytes, MADV_HUGEPAGE) ; 
+#endif
+    return static_cast<T*>(p) ; 
+}
+
+template<typename T>
+inline void NPAlloc<T>::deallocate(T* p, size_t) noexcept 
+{
+    free(p); 
+}
+
+
+/**
+NPMeta
+-------
+
+Parsed key -> value index over a metadata string of "key:value" lines
+as held by NP::meta and NPFold::meta. The string remains the only
+authority : the index records the length and a signature of the string
+it describes and is rebuilt lazily when either no longer matches, so code
+that assigns or appends to meta directly needs no bookkeeping. 
+Repeated lookups then cost a signature of at most SIG_SAMPLES bytes 
+rather than a parse of every line, and no copy of the string is kept. 
+
+As the signature samples longer strings, a direct edit that keeps the 
+length and changes only unsampled bytes is not detected : change values 
+of existing keys with set_meta rather than by editing the string in place. 
+
+NPMeta::set edits the string in place exactly as NP::SetMeta would,
+including terminating every line with a newline, and updates the index
+rather than invalidating it. As with NP::get_meta_string_ lookups give
+the value of the last line with the key and as with NP::SetMeta updates
+change every line with the key.
+
+The public methods lock, so concurrent const access to the metadata
+of an NP or NPFold remains safe. Copies get their own mutex.
+
+**/
+
+struct NPMeta
+{
+    static constexpr size_t SIG_SAMPLES = 64 ;  // bytes hashed by Signature, all of shorter strings
+    size_t len ;                               // length of the metadata string the index describes
+    uint64_t sig ;                             // Signature of that string
+    std::vector<std::string> keys ;            // keys of all lines with a colon, in order
+    std::vector<size_t> vpos ;                 // offset of each value within the string
+    std::vector<size_t> vend ;                 // offset of the end of each value
+    std::unordered_map<std::string, int> idx ; // key -> index of the last line with the key
+    bool built ;
+    bool dup ;                                 // some key is on more than one line
+    std::mutex mtx ;
+
+    NPMeta();
+    NPMeta(const NPMeta& other);
+    NPMeta& operator=(const NPMeta& other);
+
+    bool get(const std::string& meta, const char* key, std::string& value );
+    bool has(const std::string& meta, const char* key );
+    template<typename T> T get(const std::string& meta, const char* key, T fallback );
+    template<typename T> void set(std::string& meta, const char* key, T value );
+    template<typename T> void set_kv(std::string& meta, const std::vector<std::pair<std::string, T>>& kvs );
+    void set_kv(std::string& meta, const std::vector<std::string>& keys, const std::vector<std::string>& vals );
+    std::string desc() ;
+
+    template<typename T> static std::string Format(T value);
+    static uint64_t Signature(const std::string& meta);
+
+    // require the lock to be held
+    void _clear();
+    void _sync(const std::string& meta);
+    void _mark(const std::string& meta);
+    void _parse(const std::string& meta, size_t p);
+    int  _find(const char* key) const ;
+    void _set(std::string& meta, const char* key, const std::string& value );
+};
+
+inline NPMeta::NPMeta()
+    :
+    len(0),
+    sig(0),
+    built(false),
+    dup(false)
+{
+}
+
+inline NPMeta::NPMeta(const NPMeta& other)
+    :
+    len(0),
+    sig(0),
+    built(false),
+    dup(false)
+{
+    *this = other ;
+}
+
+inline NPMeta& NPMeta::operator=(const NPMeta& other)
+{
+    if(this == &other) return *this ;
+    std::lock_guard<std::mutex> lk(const_cast<NPMeta&>(other).mtx) ;
+    len = other.len ;
+    sig = other.sig ;
+    keys = other.keys ;
+    vpos = other.vpos ;
+    vend = other.vend ;
+    idx = other.idx ;
+    built = other.built ;
+    dup = other.dup ;
+    return *this ;
+}
+
+inline bool NPMeta::get(const std::string& meta, const char* key, std::string& value )
+{
+    std::lock_guard<std::mutex> lk(mtx) ;
+    _sync(meta);
+    int i = _find(key) ;
+    if( i < 0 ) return false ;
+    value.assign( meta, vpos[i], vend[i] - vpos[i] );
+    return true ;
+}
+
+inline bool NPMeta::has(const std::string& meta, const char* key )
+{
+    std::lock_guard<std::mutex> lk(mtx) ;
+    _sync(meta);
+    return _find(key) > -1 ;
+}
+
+/**
+NPMeta::get
+-------------
+
+Returns fallback when the key is absent or has an empty value, as NP::GetMeta.
+
+**/
+
+template<typename T>
+inline T NPMeta::get(const std::string& meta, const char* key, T fallback )
+{
+    std::string s ;
+    if(!get(meta, key, s) || s.empty()) return fallback ;
+    return U::To<T>(s.c_str()) ;
+}
+
+template<typename T>
+inline void NPMeta::set(std::string& meta, const char* key, T value )
+{
+    std::lock_guard<std::mutex> lk(mtx) ;
+    _sync(meta);
+    _set(meta, key, Format(value));
+}
+
+template<typename T>
+inline void NPMeta::set_kv(std::string& meta, const std::vector<std::pair<std::string, T>>& kvs )
+{
+    std::lock_guard<std::mutex> lk(mtx) ;
+    _sync(meta);
+    for(int i=0 ; i < int(kvs.size()) ; i++) _set(meta, kvs[i].first.c_str(), Format(kvs[i].second) );
+}
+
+inline void NPMeta::set_kv(std::string& meta, const std::vector<std::string>& keys_, const std::vector<std::string>& vals_ )
+{
+    assert( keys_.size() == vals_.size() );
+    std::lock_guard<std::mutex> lk(mtx) ;
+    _sync(meta);
+    for(int i=0 ; i < int(keys_.size()) ; i++) _set(meta, keys_[i].c_str(), vals_[i] );
+}
+
+inline std::string NPMeta::desc()
+{
+    std::lock_guard<std::mutex> lk(mtx) ;
+    std::stringstream ss ;
+    ss << "NPMeta::desc"
+       << " built " << built
+       << " dup " << dup
+       << " num_keys " << keys.size()
+       << " num_unique " << idx.size()
+       << " len " << len
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+NPMeta::Format
+----------------
+
+Value text as written by the fresh stringstream of NP::SetMeta.
+
+**/
+
+template<typename T>
+inline std::string NPMeta::Format(T value) // static
+{
+    std::stringstream ss ;
+    ss << value ;
+    std::string str = ss.str();
+    return str ;
+}
+
+/**
+NPMeta::Signature
+-------------------
+
+FNV-1a hash of the length and of at most SIG_SAMPLES bytes spread 
+evenly over the string including the last, all bytes of shorter strings. 
+Cost is independent of the string length. 
+
+**/
+
+inline uint64_t NPMeta::Signature(const std::string& meta) // static
+{
+    size_t n = meta.size() ;
+    uint64_t h = 14695981039346656037ull ^ uint64_t(n) ;
+    if( n == 0 ) return h ;
+    size_t num = n < SIG_SAMPLES ? n : size_t(SIG_SAMPLES) ;
+    const char* s = meta.data() ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        size_t j = num == n ? i : ( i*(n - 1) )/( num - 1 ) ;
+        h ^= uint64_t((unsigned char)s[j]) ;
+        h *= 1099511628211ull ;
+    }
+    return h ;
+}
+
+inline void NPMeta::_clear()
+{
+    len = 0 ;
+    sig = 0 ;
+    keys.clear();
+    vpos.clear();
+    vend.clear();
+    idx.clear();
+    built = false ;
+    dup = false ;
+}
+
+inline void NPMeta::_sync(const std::string& meta)
+{
+    if(built && meta.size() == len && Signature(meta) == sig) return ;
+    _clear();
+    _parse(meta, 0);
+    _mark(meta);
+    built = true ;
+}
+
+inline void NPMeta::_mark(const std::string& meta)
+{
+    len = meta.size() ;
+    sig = Signature(meta) ;
+}
+
+/**
+NPMeta::_parse
+----------------
+
+Indexes the lines of meta starting at offset p, splitting lines at
+newlines and key from value at the first colon as NP::get_meta_string_
+does. Lines without a colon are skipped.
+
+**/
+
+inline void NPMeta::_parse(const std::string& meta, size_t p)
+{
+    const char* s = meta.data() ;
+    size_t n = meta.size() ;
+    while( p < n )
+    {
+        const char* nl = (const char*)memchr( s + p, '\n', n - p ) ;
+        size_t e = nl ? nl - s : n ;
+        const char* co = (const char*)memchr( s + p, ':', e - p ) ;
+        if(co)
+        {
+            size_t c = co - s ;
+            int i = keys.size() ;
+            keys.push_back( meta.substr(p, c - p) );
+            vpos.push_back( c + 1 );
+            vend.push_back( e );
+            std::pair<std::unordered_map<std::string,int>::iterator, bool> r = idx.emplace( keys.back(), i );
+            if(!r.second)
+            {
+                dup = true ;
+                r.first->second = i ;
+            }
+        }
+        p = e + 1 ;
+    }
+}
+
+inline int NPMeta::_find(const char* key) const
+{
+    std::unordered_map<std::string,int>::const_iterator it = idx.find(key) ;
+    return it == idx.end() ? -1 : it->second ;
+}
+
+/**
+NPMeta::_set
+--------------
+
+Expects the index to be in sync with meta. Values of existing lines
+are replaced in place shifting the offsets of later lines, new keys are
+appended and indexed. A value containing a newline changes the lines
+so the index is rebuilt.
+
+**/
+
+inline void NPMeta::_set(std::string& meta, const char* key, const std::string& value )
+{
+    if(!meta.empty() && meta.back() != '\n') meta += '\n' ;
+
+    int i = _find(key) ;
+    if( i < 0 )
+    {
+        size_t p = meta.size() ;
+        std::string line = key ;
+        line += ':' ;
+        line += value ;
+        line += '\n' ;
+        meta += line ;
+        _parse(meta, p);
+        _mark(meta);
+        return ;
+    }
+
+    int num = keys.size() ;
+    int64_t delta = 0 ;
+    for(int j=( dup ? 0 : i ) ; j < num ; j++)
+    {
+        vpos[j] += delta ;
+        vend[j] += delta ;
+        if( j != i && !( dup && keys[j] == keys[i] ) ) continue ;
+        size_t vlen = vend[j] - vpos[j] ;
+        meta.replace( vpos[j], vlen, value );
+        vend[j] = vpos[j] + value.size() ;
+        delta += int64_t(value.size()) - int64_t(vlen) ;
+    }
+    _mark(meta);
+    if(value.find('\n') != std::string::npos)
+    {
+        built = false ;
+        _sync(meta);
+    }
+}
+
+
+
+/**
+NPArray<T,N> : typed fixed rank accessor of C order contiguous payloads
+-------------------------------------------------------------------------
+
+NP::get and NP::set index through NP::index which recomputes strides from
+the shape vector and asserts all six indices on every call. NPArray has
+the rank as template parameter and strides precomputed, so operator() with
+N indices compiles to the same pointer arithmetic as hand-rolled indexing
+of NP::cvalues. Bounds are checked by assert, so only without NDEBUG::
+
+    NPArray<const float,3> pp = a->carray<float,3>() ;   // asserts dtype and rank
+    float y = pp(i,j,1) ;
+    for(auto item : pp.items()) ...                      // NPArray<const float,2> of each item
+    std::sort( qq.begin(), qq.end() )                    // flat payload pointers
+
+The items are the N-1 rank arrays of the first axis, or element
+references for N 1. As with NPView the array is not owned.
+
+**/
+
+template<typename T, int N> struct NPArray ;
+
+template<typename T, int N>
+struct NPArrayItem
+{
+    typedef NPArray<T,N-1> type ;
+    static type Get(const NPArray<T,N>& a, int i) ;
+};
+
+template<typename T>
+struct NPArrayItem<T,1>
+{
+    typedef T& type ;
+    static type Get(const NPArray<T,1>& a, int i) ;
+};
+
+template<typename T, int N>
+struct NPArray
+{
+    static_assert( N > 0, "NPArray rank must be at least 1" );
+    typedef typename NPArrayItem<T,N>::type item_type ;
+
+    struct item_iterator
+    {
+        typedef std::random_access_iterator_tag iterator_category ;
+        typedef typename std::remove_reference<item_type>::type value_type ;
+        typedef int64_t difference_type ;
+        typedef value_type* pointer ;
+        typedef item_type reference ;
+
+        NPArray<T,N> a ;
+        int64_t i ;
+
+        reference operator*() const { return a[i] ; }
+        reference operator[](difference_type n) const { return a[i+n] ; }
+        item_iterator& operator++(){ ++i ; return *this ; }
+        item_iterator& operator--(){ --i ; return *this ; }
+        item_iterator operator++(int){ item_iterator t(*this) ; ++i ; return t ; }
+        item_iterator operator--(int){ item_iterator t(*this) ; --i ; return t ; }
+        item_iterator& operator+=(difference_type n){ i += n ; return *this ; }
+        item_iterator& operator-=(difference_type n){ i -= n ; return *this ; }
+        item_iterator operator+(difference_type n) const { item_iterator t(*this) ; t.i += n ; return t ; }
+        item_iterator operator-(difference_type n) const { item_iterator t(*this) ; t.i -= n ; return t ; }
+        difference_type operator-(const item_iterator& o) const { return i - o.i ; }
+        bool operator==(const item_iterator& o) const { return i == o.i ; }
+        bool operator!=(const item_iterator& o) const { return i != o.i ; }
+        bool operator< (const item_iterator& o) const { return i <  o.i ; }
+        bool operator> (const item_iterator& o) const { return i >  o.i ; }
+        bool operator<=(const item_iterator& o) const { return i <= o.i ; }
+        bool operator>=(const item_iterator& o) const { return i >= o.i ; }
+    };
+
+    struct item_range
+    {
+        item_iterator b ;
+        item_iterator e ;
+        item_iterator begin() const { return b ; }
+        item_iterator end() const { return e ; }
+        int64_t size() const { return e.i - b.i ; }
+    };
+
+    T*      base ;
+    int     shape[N] ;
+    int64_t strides[N] ;   // in elements, C order so strides[N-1] is 1
+
+    NPArray();
+    NPArray(T* base, const int* shape);
+    NPArray(T* base, const std::vector<int>& shape);
+
+    bool    valid() const { return base != nullptr ; }
+    int64_t size() const { return shape[0]*strides[0] ; }
+    T*      data() const { return base ; }
+    T*      begin() const { return base ; }
+    T*      end() const { return base + size() ; }
+
+    template<typename... Args> T& operator()(Args... idx) const ;
+    item_type operator[](int64_t i) const ;
+    item_range items() const ;
+
+    std::string desc() const ;
+};
+
+template<typename T, int N>
+inline typename NPArrayItem<T,N>::type NPArrayItem<T,N>::Get(const NPArray<T,N>& a, int i) // static
+{
+    return NPArray<T,N-1>( a.base + i*a.strides[0], a.shape + 1 ) ;
+}
+
+template<typename T>
+inline typename NPArrayItem<T,1>::type NPArrayItem<T,1>::Get(const NPArray<T,1>& a, int i) // static
+{
+    return a.base[i] ;
+}
+
+template<typename T, int N>
+inline NPArray<T,N>::NPArray()
+    :
+    base(nullptr)
+{
+    for(int d=0 ; d < N ; d++)
+    {
+        shape[d] = 0 ;
+        strides[d] = 0 ;
+    }
+}
+
+template<typename T, int N>
+inline NPArray<T,N>::NPArray(T* base_, const int* shape_)
+    :
+    base(base_)
+{
+    int64_t s = 1 ;
+    for(int d=N-1 ; d >= 0 ; d--)
+    {
+        shape[d] = shape_[d] ;
+        strides[d] = s ;
+        s *= shape[d] ;
+    }
+}
+
+template<typename T, int N>
+inline NPArray<T,N>::NPArray(T* base_, const std::vector<int>& shape_)
+    :
+    NPArray(base_, shape_.data())
+{
+    assert( shape_.size() == N );
+}
+
+/**
+NPArray::operator()
+---------------------
+
+The loop over N compile time indices is unrolled by the compiler.
+Bounds are asserted only in debug builds.
+
+**/
+
+template<typename T, int N>
+template<typename... Args>
+inline T& NPArray<T,N>::operator()(Args... idx_) const
+{
+    static_assert( sizeof...(Args) == N, "NPArray::operator() needs one index per dimension" );
+    const int64_t idx[N] = { int64_t(idx_)... } ;
+    int64_t offset = idx[N-1] ;
+    for(int d=0 ; d < N-1 ; d++) offset += idx[d]*strides[d] ;
+#ifndef NDEBUG
+    bool inbounds = true ;
+    for(int d=0 ; d < N ; d++) inbounds &= uint64_t(idx[d]) < uint64_t(shape[d]) ;
+    assert( inbounds );
+#endif
+    return base[offset] ;
+}
+
+template<typename T, int N>
+inline typename NPArray<T,N>::item_type NPArray<T,N>::operator[](int64_t i) const
+{
+    assert( i >= 0 && i < shape[0] );
+    return NPArrayItem<T,N>::Get(*this, i) ;
+}
+
+template<typename T, int N>
+inline typename NPArray<T,N>::item_range NPArray<T,N>::items() const
+{
+    item_range r ;
+    r.b.a = *this ;
+    r.b.i = 0 ;
+    r.e.a = *this ;
+    r.e.i = shape[0] ;
+    return r ;
+}
+
+template<typename T, int N>
+inline std::string NPArray<T,N>::desc() const
+{
+    std::stringstream ss ;
+    ss << "NPArray<" << ::desc<typename std::remove_const<T>::type>::code << sizeof(T) << "," << N << "> (" ;
+    for(int d=0 ; d < N ; d++) ss << shape[d] << ( d < N - 1 ? "," : "" ) ;
+    ss << ")" << ( valid() ? "" : " INVALID" ) ;
+    std::string str = ss.str();
+    return str ;
+}
+
+
+
 union uc4 
 {
     char c[4] ; 
@@ -0,0 +1,390 @@
+#pragma once
+/**
+NPView.h : non-owning strided views into NP payloads
+======================================================
+
+NP::slice, NP::MakeItemCopy, NP::spawn_item, NP::MakeSelectCopy_ and
+NP::MakeCopy3D allocate and copy even when the caller only needs
+to look at a sub-region. An NPView<T> is a base pointer together with
+a shape and strides in elements, so items, ranges, columns, steps and
+transposes of an array are new views of the same payload::
+
+    NP* a = NP::Load("/tmp/photon.npy") ;                  // (100000,4,4)
+    NPView<const float> v(a) ;
+    NPView<const float> pos = v.range(1000,2000).item_axis(1, 0) ;    // (1000,4) no copy
+    float y = pos(10,1) ;
+    NPView<const float> t = pos.column(3) ;                // (1000,) stride 16
+    NP* b = t.materialize() ;                              // contiguous copy when really needed
+
+Views do not own or keep alive the payload : reallocating the NP,
+eg by NP::set_shape or NP::clear, invalidates its views.
+
+Arrays loaded by NP::LoadFortran from .npy with fortran_order True keep their column-major
+payload (see NP::fortran_order) and NPView of them has column-major
+strides, so indexing gives the same values as numpy without transposing
+the payload on load. NPView::materialize gives a C order NP.
+
+As in numpy NPView::reshape only succeeds without copying when the
+strides allow it, otherwise it returns an invalid view, see NPView::valid.
+Negative axes and item indices count from the end.
+
+**/
+
+#include <type_traits>
+#include "NP.hh"
+
+template<typename T>
+struct NPView
+{
+    typedef typename std::remove_const<T>::type V ;
+
+    T*                   base ;
+    std::vector<int>     shape ;
+    std::vector<int64_t> strides ;   // in elements, not bytes
+
+    NPView();
+    NPView(T* base, const std::vector<int>& shape, const std::vector<int64_t>& strides );
+    NPView(T* base, const std::vector<int>& shape, bool fortran_order=false );
+    NPView(NP* a);
+    NPView(const NP* a);
+
+    static std::vector<int64_t> Strides(const std::vector<int>& shape, bool fortran_order);
+    static int Axis(int axis, int ndim);
+
+    bool    valid() const ;
+    int     ndim() const ;
+    int64_t size() const ;
+    bool    is_contiguous() const ;   // C order without gaps
+
+    template<typename... Args> T& operator()(Args... idx) const ;
+    T& at(const std::vector<int>& idx) const ;
+
+    NPView<T> item(int i) const ;                             // index first axis, dropping it
+    NPView<T> item_axis(int axis, int i) const ;              // index any axis, dropping it
+    NPView<T> column(int j) const ;                           // index last axis, dropping it
+    NPView<T> range(int i0, int i1, int step=1) const ;       // items [i0,i1) of first axis with step
+    NPView<T> range_axis(int axis, int i0, int i1, int step=1) const ;
+    NPView<T> transpose() const ;                             // reverse the axes
+    NPView<T> transpose(int axis0, int axis1) const ;         // swap two axes
+    NPView<T> reshape(const std::vector<int>& shape) const ;  // invalid view when the strides do not allow
+
+    void copy_to(V* dst) const ;   // C order
+    NP*  materialize() const ;
+    std::string desc() const ;
+};
+
+
+template<typename T>
+inline NPView<T>::NPView()
+    :
+    base(nullptr)
+{
+}
+
+template<typename T>
+inline NPView<T>::NPView(T* base_, const std::vector<int>& shape_, const std::vector<int64_t>& strides_ )
+    :
+    base(base_),
+    shape(shape_),
+    strides(strides_)
+{
+    assert( shape.size() == strides.size() );
+}
+
+template<typename T>
+inline NPView<T>::NPView(T* base_, const std::vector<int>& shape_, bool fortran_order )
+    :
+    base(base_),
+    shape(shape_),
+    strides(Strides(shape_, fortran_order))
+{
+}
+
+template<typename T>
+inline NPView<T>::NPView(NP* a)
+    :
+    base(a->values<V>()),
+    shape(a->shape),
+    strides(Strides(a->shape, a->fortran_order))
+{
+    assert( a->ebyte == int(sizeof(T)) );
+    assert( !a->nodata );
+}
+
+/**
+NPView::NPView(const NP*)
+---------------------------
+
+Views of const arrays must have const element type, eg NPView<const float>.
+
+**/
+
+template<typename T>
+inline NPView<T>::NPView(const NP* a)
+    :
+    base(a->cvalues<V>()),
+    shape(a->shape),
+    strides(Strides(a->shape, a->fortran_order))
+{
+    static_assert( std::is_const<T>::value, "NPView of const NP requires const element type" );
+    assert( a->ebyte == int(sizeof(T)) );
+    assert( !a->nodata );
+}
+
+template<typename T>
+inline std::vector<int64_t> NPView<T>::Strides(const std::vector<int>& shape, bool fortran_order) // static
+{
+    int nd = shape.size() ;
+    std::vector<int64_t> st(nd) ;
+    int64_t s = 1 ;
+    for(int i=0 ; i < nd ; i++)
+    {
+        int d = fortran_order ? i : nd - 1 - i ;
+        st[d] = s ;
+        s *= shape[d] ;
+    }
+    return st ;
+}
+
+template<typename T>
+inline int NPView<T>::Axis(int axis, int ndim) // static
+{
+    int ax = axis < 0 ? ndim + axis : axis ;
+    assert( ax >= 0 && ax < ndim );
+    return ax ;
+}
+
+template<typename T>
+inline bool NPView<T>::valid() const
+{
+    return base != nullptr ;
+}
+
+template<typename T>
+inline int NPView<T>::ndim() const
+{
+    return shape.size() ;
+}
+
+template<typename T>
+inline int64_t NPView<T>::size() const
+{
+    int64_t n = 1 ;
+    for(unsigned i=0 ; i < shape.size() ; i++) n *= shape[i] ;
+    return n ;
+}
+
+template<typename T>
+inline bool NPView<T>::is_contiguous() const
+{
+    return strides == Strides(shape, false) ;
+}
+
+template<typename T>
+template<typename... Args>
+inline T& NPView<T>::operator()(Args... idx_) const
+{
+    const int64_t idx[sizeof...(Args)+1] = { int64_t(idx_)..., 0 } ;
+    assert( sizeof...(Args) == shape.size() );
+    int64_t offset = 0 ;
+    for(unsigned d=0 ; d < sizeof...(Args) ; d++) offset += idx[d]*strides[d] ;
+    return base[offset] ;
+}
+
+template<typename T>
+inline T& NPView<T>::at(const std::vector<int>& idx) const
+{
+    assert( idx.size() == shape.size() );
+    int64_t offset = 0 ;
+    for(unsigned d=0 ; d < idx.size() ; d++) offset += int64_t(idx[d])*strides[d] ;
+    return base[offset] ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::item(int i) const
+{
+    return item_axis(0, i) ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::column(int j) const
+{
+    return item_axis(-1, j) ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::item_axis(int axis, int i) const
+{
+    int ax = Axis(axis, ndim()) ;
+    int ii = i < 0 ? shape[ax] + i : i ;
+    assert( ii >= 0 && ii < shape[ax] );
+    NPView<T> v(*this) ;
+    v.base = base + ii*strides[ax] ;
+    v.shape.erase( v.shape.begin() + ax );
+    v.strides.erase( v.strides.begin() + ax );
+    return v ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::range(int i0, int i1, int step) const
+{
+    return range_axis(0, i0, i1, step) ;
+}
+
+/**
+NPView::range_axis
+--------------------
+
+Items [i0,i1) of the axis taking every step-th, with negative i0 i1
+counting from the end as NP::LoadSlice. The range is clamped to the axis.
+
+**/
+
+template<typename T>
+inline NPView<T> NPView<T>::range_axis(int axis, int i0_, int i1_, int step) const
+{
+    assert( step > 0 );
+    int ax = Axis(axis, ndim()) ;
+    int n = shape[ax] ;
+    int i0 = std::min( n, std::max(0, i0_ < 0 ? n + i0_ : i0_ )) ;
+    int i1 = std::min( n, std::max(0, i1_ < 0 ? n + i1_ : i1_ )) ;
+    NPView<T> v(*this) ;
+    v.base = base + i0*strides[ax] ;
+    v.shape[ax] = i1 > i0 ? (i1 - i0 + step - 1)/step : 0 ;
+    v.strides[ax] = strides[ax]*step ;
+    return v ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::transpose() const
+{
+    NPView<T> v(*this) ;
+    std::reverse( v.shape.begin(), v.shape.end() );
+    std::reverse( v.strides.begin(), v.strides.end() );
+    return v ;
+}
+
+template<typename T>
+inline NPView<T> NPView<T>::transpose(int axis0, int axis1) const
+{
+    int a0 = Axis(axis0, ndim()) ;
+    int a1 = Axis(axis1, ndim()) ;
+    NPView<T> v(*this) ;
+    std::swap( v.shape[a0], v.shape[a1] );
+    std::swap( v.strides[a0], v.strides[a1] );
+    return v ;
+}
+
+/**
+NPView::reshape
+-----------------
+
+Follows numpy _attempt_nocopy_reshape : axes of length one are dropped,
+then groups of old and new axes with equal products are matched and each
+old group must be contiguous in itself for the new strides to be derived.
+When that is not the case the returned view is invalid and
+reshaping requires NPView::materialize.
+
+**/
+
+template<typename T>
+inline NPView<T> NPView<T>::reshape(const std::vector<int>& nshape) const
+{
+    int64_t nsize = 1 ;
+    for(unsigned i=0 ; i < nshape.size() ; i++) nsize *= nshape[i] ;
+    assert( nsize == size() );
+
+    NPView<T> v(base, nshape, false) ;
+    if( nsize == 0 || is_contiguous() ) return v ;
+
+    std::vector<int>     od ;
+    std::vector<int64_t> os ;
+    for(int i=0 ; i < ndim() ; i++) if(shape[i] != 1)
+    {
+        od.push_back(shape[i]) ;
+        os.push_back(strides[i]) ;
+    }
+
+    int ond = od.size() ;
+    int nnd = nshape.size() ;
+    int oi = 0, oj = 1, ni = 0, nj = 1 ;
+    while( ni < nnd && oi < ond )
+    {
+        int64_t np = nshape[ni] ;
+        int64_t op = od[oi] ;
+        while( np != op )
+        {
+            if( np < op ) np *= nshape[nj++] ;
+            else          op *= od[oj++] ;
+        }
+        for(int ok=oi ; ok < oj - 1 ; ok++) if( os[ok] != od[ok+1]*os[ok+1] ) return NPView<T>() ;
+
+        v.strides[nj-1] = os[oj-1] ;
+        for(int nk=nj-1 ; nk > ni ; nk--) v.strides[nk-1] = v.strides[nk]*nshape[nk] ;
+        ni = nj++ ;
+        oi = oj++ ;
+    }
+    int64_t last = ni > 0 ? v.strides[ni-1] : 1 ;
+    for(int nk=ni ; nk < nnd ; nk++) v.strides[nk] = last ;   // trailing axes of length one
+    return v ;
+}
+
+/**
+NPView::copy_to
+-----------------
+
+Writes the viewed values in C order to dst, which must have room
+for size() values. Rows along the last axis are copied with memcpy
+when contiguous.
+
+**/
+
+template<typename T>
+inline void NPView<T>::copy_to(V* dst) const
+{
+    int nd = ndim() ;
+    if( nd == 0 ) { *dst = *base ; return ; }
+    if( size() == 0 ) return ;
+
+    int n = shape[nd-1] ;
+    int64_t s = strides[nd-1] ;
+    std::vector<int> idx(nd, 0) ;
+    while(true)
+    {
+        const T* p = base ;
+        for(int d=0 ; d < nd - 1 ; d++) p += idx[d]*strides[d] ;
+        if( s == 1 ) memcpy( dst, p, n*sizeof(T) );
+        else for(int j=0 ; j < n ; j++) dst[j] = p[j*s] ;
+        dst += n ;
+
+        int d = nd - 2 ;
+        while( d >= 0 && ++idx[d] == shape[d] )
+        {
+            idx[d] = 0 ;
+            d-- ;
+        }
+        if( d < 0 ) break ;
+    }
+}
+
+template<typename T>
+inline NP* NPView<T>::materialize() const
+{
+    NP* a = new NP(descr_<V>::dtype().c_str()) ;
+    a->set_shape( shape, false );
+    copy_to( a->values<V>() );
+    return a ;
+}
+
+template<typename T>
+inline std::string NPView<T>::desc() const
+{
+    std::stringstream ss ;
+    ss << "NPView<" << descr_<V>::dtype() << "> shape (" ;
+    for(int i=0 ; i < ndim() ; i++) ss << shape[i] << ( i < ndim() - 1 ? "," : "" ) ;
+    ss << ") strides (" ;
+    for(int i=0 ; i < ndim() ; i++) ss << strides[i] << ( i < ndim() - 1 ? "," : "" ) ;
+    ss << ")" << ( valid() ? "" : " INVALID" ) << ( is_contiguous() ? " contiguous" : "" ) ;
+    std::string str = ss.str();
+    return str ;
+}
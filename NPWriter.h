@@ -0,0 +1,332 @@
+#pragma once
+/**
+NPWriter.h : streaming items into a growing .npy file
+=======================================================
+
+Instead of collecting all items in memory and saving at the end
+the NPWriter appends items or batches of items to the .npy file
+as they are produced, so memory usage stays constant however many
+items are written::
+
+    NPWriter<float> w("/tmp/hits.npy", {4,4}) ;   // itemshape (4,4)
+    for(...) w.add( hit, 1 ) ;   // hit points to 16 floats
+    w.close();                   // NB also done by dtor
+
+The header is written with the NumPy growth padding (see NPU::_make_header)
+such that the first dimension can increase without changing the
+header length. After each NPWriter::flush the buffered items are written
+and the header is rewritten in place with the current item count,
+so the file is always a valid .npy at that point even when the
+writing process continues (or dies) afterwards.
+
+Metadata set with NPWriter::set_meta is written to the usual
+NP sidecar on NPWriter::close.
+
+**/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "NP.hh"
+
+template<typename T>
+struct NPWriter
+{
+    static constexpr size_t BUFFER_BYTES = 1 << 20 ;
+
+    std::string       path ;
+    std::vector<int>  itemshape ;
+    std::string       dtype ;
+    size_t            buffer_bytes ;
+    size_t            item_bytes ;
+    size_t            hdr_bytes ;
+    int64_t           num_items ;   // items written to file, not including buffered
+    int               fd ;
+    std::vector<char> buf ;
+    std::string       meta ;
+
+    NPWriter(const char* path, const std::vector<int>& itemshape, size_t buffer_bytes=BUFFER_BYTES );
+    ~NPWriter();
+
+    bool is_open() const ;
+    int64_t num_added() const ;   // written and buffered items
+
+    static size_t ItemBytes(const std::vector<int>& itemshape);
+
+    int add(const T* items, int num=1 );
+    template<typename S> int add(const std::vector<S>& vv );
+    template<typename V> void set_meta(const char* key, V value);
+
+    int flush();
+    int close();
+
+    std::string make_header(int64_t ni) const ;
+    std::string desc() const ;
+
+    private:
+    int write_(const char* src, size_t bytes );
+    int write_items_(const char* src, size_t bytes );
+};
+
+
+/**
+NPWriter::NPWriter
+-------------------
+
+Creates (or truncates) the file at *path* and writes the header for
+zero items. The *itemshape* are the dimensions following the first,
+an empty itemshape {} gives scalar items and an array of shape (ni,).
+
+**/
+
+template<typename T>
+inline NPWriter<T>::NPWriter(const char* path_, const std::vector<int>& itemshape_, size_t buffer_bytes_ )
+    :
+    path(path_),
+    itemshape(itemshape_),
+    dtype(descr_<T>::dtype()),
+    buffer_bytes(buffer_bytes_),
+    item_bytes(ItemBytes(itemshape_)),
+    hdr_bytes(0),
+    num_items(0),
+    fd(-1)
+{
+    bool item_expect = item_bytes > 0 ;
+    if(!item_expect) std::cerr << "NPWriter::NPWriter INVALID itemshape with zero sized items for " << path << std::endl ;
+    assert( item_expect );
+    if(!item_expect) return ;
+
+    U::MakeDirsForFile(path.c_str());
+    fd = open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+    if(fd < 0)
+    {
+        std::cerr << "NPWriter::NPWriter FAILED TO OPEN " << path << std::endl ;
+        return ;
+    }
+    std::string hdr = make_header(0) ;
+    hdr_bytes = hdr.size() ;
+    if(write_( hdr.data(), hdr.size() ) != 0)
+    {
+        ::close(fd);
+        fd = -1 ;
+        return ;
+    }
+    buf.reserve( buffer_bytes + item_bytes );
+}
+
+/**
+NPWriter::ItemBytes
+---------------------
+
+Bytes per item, the product of the itemshape (1 when empty) times sizeof(T).
+
+**/
+
+template<typename T>
+inline size_t NPWriter<T>::ItemBytes(const std::vector<int>& itemshape) // static
+{
+    int64_t nv = 1 ;
+    for(unsigned i=0 ; i < itemshape.size() ; i++) nv *= itemshape[i] ;
+    return nv > 0 ? nv*sizeof(T) : 0 ;
+}
+
+template<typename T>
+inline NPWriter<T>::~NPWriter()
+{
+    close();
+}
+
+template<typename T>
+inline bool NPWriter<T>::is_open() const
+{
+    return fd > -1 ;
+}
+
+template<typename T>
+inline int64_t NPWriter<T>::num_added() const
+{
+    return num_items + buf.size()/item_bytes ;
+}
+
+/**
+NPWriter::add
+---------------
+
+Buffers *num* items starting at *items*, writing the buffer to file
+whenever it exceeds *buffer_bytes*. The file header is only updated
+by NPWriter::flush and NPWriter::close.
+
+Returns non-zero when a write fails, in which case the items of this
+call are not added, the buffer is kept and the file is truncated
+back to the items written so far, see NPWriter::write_items_.
+
+**/
+
+template<typename T>
+inline int NPWriter<T>::add(const T* items, int num )
+{
+    if(!is_open())
+    {
+        std::cerr << "NPWriter::add NOT OPEN " << path << std::endl ;
+        return 1 ;
+    }
+    const char* src = (const char*)items ;
+    size_t bytes = num*item_bytes ;
+
+    if( buf.size() + bytes > buffer_bytes )
+    {
+        if(write_items_( buf.data(), buf.size() ) != 0) return 1 ;
+        buf.clear();
+    }
+
+    if( bytes > buffer_bytes )  // large batch goes direct
+    {
+        if(write_items_( src, bytes ) != 0) return 1 ;
+    }
+    else
+    {
+        buf.insert( buf.end(), src, src + bytes );
+    }
+    return 0 ;
+}
+
+template<typename T>
+template<typename S>
+inline int NPWriter<T>::add(const std::vector<S>& vv )
+{
+    assert( sizeof(S) == item_bytes );
+    return add( (const T*)vv.data(), vv.size() );
+}
+
+template<typename T>
+template<typename V>
+inline void NPWriter<T>::set_meta(const char* key, V value)
+{
+    NP::SetMeta<V>(meta, key, value);
+}
+
+/**
+NPWriter::flush
+-----------------
+
+Writes the buffered items and rewrites the header in place with the
+current number of items, leaving a valid .npy file.
+
+**/
+
+template<typename T>
+inline int NPWriter<T>::flush()
+{
+    if(!is_open()) return 1 ;
+    int rc = 0 ;
+    if(buf.size() > 0)
+    {
+        int wrc = write_items_( buf.data(), buf.size() );
+        if(wrc == 0) buf.clear();   // kept on failure so num_added still counts them
+        rc += wrc ;
+    }
+
+    std::string hdr = make_header(num_items) ;
+    bool same_length = hdr.size() == hdr_bytes ;
+    if(!same_length) std::cerr << "NPWriter::flush UNEXPECTED HEADER LENGTH CHANGE " << hdr_bytes << " " << hdr.size() << std::endl ;
+    assert( same_length );
+
+    ssize_t n = pwrite( fd, hdr.data(), hdr.size(), 0 );
+    if( n != ssize_t(hdr.size()) ) rc += 1 ;
+    return rc ;
+}
+
+/**
+NPWriter::close
+-----------------
+
+Flushes and closes the file and saves any metadata into the sidecar.
+
+**/
+
+template<typename T>
+inline int NPWriter<T>::close()
+{
+    if(!is_open()) return 0 ;
+    int rc = flush();
+    ::close(fd);
+    fd = -1 ;
+
+    if(!meta.empty())
+    {
+        NP a(dtype.c_str()) ;   // empty array just for saving the sidecar
+        a.meta = meta ;
+        a.save_meta(path.c_str());
+    }
+    return rc ;
+}
+
+template<typename T>
+inline std::string NPWriter<T>::make_header(int64_t ni) const
+{
+    assert( ni <= std::numeric_limits<int>::max() );
+    std::vector<int> shape ;
+    shape.push_back(ni);
+    for(unsigned i=0 ; i < itemshape.size() ; i++) shape.push_back(itemshape[i]);
+    return NPU::_make_header(shape, dtype.c_str() );
+}
+
+template<typename T>
+inline std::string NPWriter<T>::desc() const
+{
+    std::stringstream ss ;
+    ss << "NPWriter::desc"
+       << " path " << path
+       << " dtype " << dtype
+       << " item_bytes " << item_bytes
+       << " num_items " << num_items
+       << " num_added " << num_added()
+       << " buffered " << buf.size()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+template<typename T>
+inline int NPWriter<T>::write_(const char* src, size_t bytes )
+{
+    while( bytes > 0 )
+    {
+        ssize_t n = ::write( fd, src, bytes );
+        if( n <= 0 )
+        {
+            std::cerr << "NPWriter::write_ FAILED " << path << " remaining bytes " << bytes << std::endl ;
+            return 1 ;
+        }
+        src += n ;
+        bytes -= n ;
+    }
+    return 0 ;
+}
+
+/**
+NPWriter::write_items_
+------------------------
+
+Appends whole items to the file and counts them in num_items only when
+fully written. After a failed or short write the file is truncated back
+to the end of the items already counted, so the header written by
+NPWriter::flush always matches the file content.
+
+**/
+
+template<typename T>
+inline int NPWriter<T>::write_items_(const char* src, size_t bytes )
+{
+    int rc = write_( src, bytes );
+    if( rc == 0 )
+    {
+        num_items += bytes/item_bytes ;
+    }
+    else
+    {
+        off_t end = hdr_bytes + num_items*item_bytes ;
+        if( ftruncate(fd, end) != 0 || lseek(fd, end, SEEK_SET) != end )
+            std::cerr << "NPWriter::write_items_ FAILED TO RESTORE FILE END " << path << std::endl ;
+    }
+    return rc ;
+}
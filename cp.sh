@@ -1,6 +1,6 @@
 #!/bin/bash -l 
 
-sysrap_names="NP.hh NPU.hh NPFold.h NPX.h"
+sysrap_names="NP.hh NPU.hh NPFold.h NPX.h NPWriter.h NPView.h NPTex.h"
 
 
 for name in $sysrap_names ; do 
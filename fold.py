@@ -182,6 +182,7 @@ class Fold(object):
 
     SFRAME = "sframe.npy"
     INDEX = "NPFold_index.txt" 
+    MANIFEST = "NPFold_manifest.txt"   # written by NPFold::save for C++ loads, not a fold entry
 
     def brief(self):
         return "Fold : symbol %30s base %s " % (self.symbol, self.base) 
@@ -200,7 +201,7 @@ class Fold(object):
     def get_names(self, base):
         """
         :param base: directory path 
-        :return names: list of names that are either .txt .npy or subfold
+        :return names: list of names that are either .txt .npy or subfold, excluding the manifest
         """
         nn = os.listdir(base)
         if not self.order is None:
@@ -214,7 +215,9 @@ class Fold(object):
 
         names = []
         for n in nn:
-            if n.endswith(".npy") or n.endswith(".txt"):
+            if n == self.MANIFEST:
+                pass
+            elif n.endswith(".npy") or n.endswith(".txt"):
                 names.append(n)
             elif self.IsFold(base,n):
                 names.append(n)
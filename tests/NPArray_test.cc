@@ -0,0 +1,109 @@
+// name=NPArray_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPArray_test.cc
+=================
+
+Checks NP::array and NP::carray indexing against NP::get and NP::set,
+item iteration with range-for and <algorithm>, the dtype and rank checks
+and times a 4D loop with NP::get, NPArray and hand-rolled indexing.
+Build without -O2 or with -DNDEBUG to compare checked and unchecked.
+
+**/
+
+#include <chrono>
+#include "NP.hh"
+
+void test_index()
+{
+    NP* a = NP::Make<float>(5, 4, 3, 2) ;
+    a->fillIndexFlat();
+    NPArray<float,4> aa = a->array<float,4>() ;
+    NPArray<const float,4> ca = a->carray<float,4>() ;
+    assert( aa.size() == a->size && aa.strides[0] == 24 && aa.strides[3] == 1 );
+
+    for(int i=0 ; i < 5 ; i++) for(int j=0 ; j < 4 ; j++) for(int k=0 ; k < 3 ; k++) for(int l=0 ; l < 2 ; l++)
+    {
+        assert( ca(i,j,k,l) == a->get<float>(i,j,k,l) );
+        assert( aa[i][j][k][l] == a->get<float>(i,j,k,l) );
+    }
+    aa(4,3,2,1) = -1.f ;
+    assert( a->get<float>(4,3,2,1) == -1.f );
+    aa[1][2](0,1) = -2.f ;
+    assert( a->get<float>(1,2,0,1) == -2.f );
+
+    assert( (a->is_array<float,4>()) );
+    assert( !(a->is_array<float,3>()) );
+    assert( !(a->is_array<double,4>()) );
+    assert( !(a->is_array<int,4>()) );      // same size different kind
+}
+
+void test_items()
+{
+    NP* a = NP::Make<int>(6, 3) ;
+    int* vv = a->values<int>() ;
+    for(int i=0 ; i < 6 ; i++) for(int j=0 ; j < 3 ; j++) vv[i*3+j] = (i*7) % 6 + 10*j ;
+
+    NPArray<int,2> aa = a->array<int,2>() ;
+    int n = 0 ;
+    for(auto item : aa.items())
+    {
+        assert( item.size() == 3 && item(1) == vv[n*3+1] );
+        n++ ;
+    }
+    assert( n == 6 && aa.items().size() == 6 );
+
+    auto it = std::find_if( aa.items().begin(), aa.items().end(), [](const NPArray<int,2>::item_type& item){ return item(0) == 5 ; } );
+    assert( it - aa.items().begin() == 5 );
+    assert( std::count_if( aa.begin(), aa.end(), [](int v){ return v >= 20 ; } ) == 6 );
+
+    NPArray<int,1> col = aa[2] ;
+    int* mx = std::max_element( col.begin(), col.end() ) ;
+    assert( *mx == 22 );
+    for(int& v : aa[0].items()) v = 0 ;
+    assert( a->get<int>(0,2) == 0 );
+
+    std::sort( aa.begin(), aa.end() );                      // flat payload
+    assert( std::is_sorted( vv, vv + a->size ) );
+}
+
+void test_timing()
+{
+    int ni = U::GetEnvInt("NI", 200000) ;
+    NP* a = NP::Make<double>(ni, 4, 4, 2) ;
+    a->fillIndexFlat();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    double s0 = 0. ;
+    for(int i=0 ; i < ni ; i++) for(int j=0 ; j < 4 ; j++) for(int k=0 ; k < 4 ; k++) s0 += a->get<double>(i,j,k,1) ;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    NPArray<const double,4> aa = a->carray<double,4>() ;
+    double s1 = 0. ;
+    for(int i=0 ; i < ni ; i++) for(int j=0 ; j < 4 ; j++) for(int k=0 ; k < 4 ; k++) s1 += aa(i,j,k,1) ;
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+    const double* vv = a->cvalues<double>() ;
+    double s2 = 0. ;
+    for(int i=0 ; i < ni ; i++) for(int j=0 ; j < 4 ; j++) for(int k=0 ; k < 4 ; k++) s2 += vv[((i*4+j)*4+k)*2+1] ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    assert( s0 == s1 && s1 == s2 );
+    std::cout
+        << "test_timing " << a->sstr() << " sums " << s0 << " " << s1 << " " << s2
+        << " NP::get " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " NPArray " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << " raw " << std::chrono::duration<double>(t3 - t2).count() << " s "
+        << std::endl
+        << aa.desc()
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_index();
+    test_items();
+    test_timing();
+    std::cout << "NPArray_test" << std::endl ;
+    return 0 ;
+}
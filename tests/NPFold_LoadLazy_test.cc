@@ -0,0 +1,81 @@
+// name=NPFold_LoadLazy_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_LoadLazy_test.cc
+=========================
+
+Checks that NPFold::LoadLazy reads only headers and metadata at load,
+that payloads are read on first access from several threads at once,
+that NPFold::release drops a payload which is read again on the next
+access and that saving a lazy fold matches the original.
+
+**/
+
+#include <thread>
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NPFold_LoadLazy_test" ;
+
+int main(int argc, char** argv)
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<std::string>("creator", "NPFold_LoadLazy_test") ;
+    for(int i=0 ; i < 10 ; i++)
+    {
+        NP* a = NP::Make<float>(1000+i, 4) ;
+        a->_fillIndexFlat<float>(i);
+        a->set_meta<int>("i", i);
+        f->add( ("a" + std::to_string(i)).c_str(), a );
+    }
+    NPFold* sub = new NPFold ;
+    NP* hit = NP::Make<double>(50, 4, 4) ;
+    hit->fillIndexFlat();
+    sub->add("hit", hit );
+    f->add_subfold("sub", sub );
+
+    std::string dir = U::form_path(FOLD, "fold") ;
+    f->save(dir.c_str()) ;
+
+    NPFold* z = NPFold::LoadLazy(dir.c_str()) ;
+    assert( z->lazy && z->get_subfold("sub")->lazy );
+    assert( z->kk == f->kk );
+    for(int i=0 ; i < 10 ; i++)
+    {
+        const NP* p = z->aa[i] ;                    // direct access does not load
+        assert( p->nodata && p->data.size() == 0 );
+        assert( p->shape == f->aa[i]->shape );
+        assert( p->get_meta<int>("i") == i );
+    }
+
+    std::vector<const NP*> got(8, nullptr) ;
+    std::vector<std::thread> threads ;
+    for(int t=0 ; t < 8 ; t++) threads.push_back( std::thread( [z, &got, t](){ got[t] = z->get("a3") ; } ) );
+    for(unsigned t=0 ; t < threads.size() ; t++) threads[t].join();
+    for(int t=0 ; t < 8 ; t++) assert( got[t] == z->aa[3] );
+
+    const NP* a3 = z->aa[3] ;
+    assert( !a3->nodata );
+    assert( NP::Memcmp(a3, f->get("a3")) == 0 );
+    assert( z->aa[4]->nodata );                     // others untouched
+
+    const NP* zhit = z->find_array("sub/hit.npy") ;
+    assert( zhit && !zhit->nodata && NP::Memcmp(zhit, hit) == 0 );
+
+    assert( z->release("a3") );
+    assert( a3->nodata && a3->data.size() == 0 );
+    assert( z->get("a3") == a3 && !a3->nodata );
+    assert( NP::Memcmp(a3, f->get("a3")) == 0 );
+    assert( z->release("missing") == false );
+
+    NPFold* e = NPFold::Load(dir.c_str()) ;
+    assert( e->release("a3") == false );            // only lazy folds release
+
+    std::string resaved = U::form_path(FOLD, "resaved") ;
+    NPFold* y = NPFold::LoadLazy(dir.c_str()) ;
+    y->save(resaved.c_str()) ;
+    NPFold* r = NPFold::Load(resaved.c_str()) ;
+    assert( NPFold::Compare(r, f) == 0 );
+    assert( NPFold::Compare(r->get_subfold("sub"), sub) == 0 );
+
+    std::cout << "NPFold_LoadLazy_test" << std::endl << z->desc() << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,79 @@
+// name=NPFold_LoadParallel_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_LoadParallel_test.cc
+=============================
+
+Compares NPFold::LoadParallel with NPFold::Load for a fold tree saved
+with an index and for a directory without index, checking keys come
+out in the same order and the progress callback sees every array, for a
+tree of three levels whose subfolds are loaded in parallel level by level.
+
+**/
+
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NPFold_LoadParallel_test" ;
+
+void compare(const NPFold* a, const NPFold* b)
+{
+    assert( a->kk == b->kk );
+    assert( a->ff == b->ff );
+    assert( NPFold::Compare(a, b) == 0 );
+    assert( a->meta == b->meta );
+    for(unsigned i=0 ; i < a->ff.size() ; i++) compare( a->subfold[i], b->subfold[i] );
+}
+
+const int NUM_ARRAYS = 20 + 5*(7+1) ;
+
+void check(const char* base, int num_threads)
+{
+    NPFold* s = NPFold::Load(base) ;
+
+    int calls = 0 ;
+    int last = 0 ;
+    NPFold* p = NPFold::LoadParallel(base, num_threads, [&calls, &last](int n, int tot){ calls += 1 ; last = n ; assert( n <= tot ); } ) ;
+
+    compare( s, p );
+    assert( calls == NUM_ARRAYS && last == NUM_ARRAYS );
+    std::cout << "check " << base << " num_threads " << num_threads << " calls " << calls << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<std::string>("creator", "NPFold_LoadParallel_test") ;
+    for(int i=0 ; i < 20 ; i++)     // keys deliberately not in sorted order
+    {
+        NP* a = NP::Make<float>(10+i, 4) ;
+        a->_fillIndexFlat<float>(i);
+        f->add( ("z" + std::to_string(20-i)).c_str(), a );
+    }
+    for(int j=0 ; j < 5 ; j++)
+    {
+        NPFold* sub = new NPFold ;
+        for(int i=0 ; i < 7 ; i++) sub->add( ("k" + std::to_string(i)).c_str(), NP::Make<double>(100*j+i+1) );
+        NPFold* subsub = new NPFold ;
+        subsub->add("deep", NP::Make<int>(3,3) );
+        sub->add_subfold("subsub", subsub );
+        f->add_subfold( ("sub" + std::to_string(5-j)).c_str(), sub );
+    }
+
+    std::string indexed = U::form_path(FOLD, "indexed") ;
+    f->save(indexed.c_str()) ;
+
+    check( indexed.c_str(), 1 );
+    check( indexed.c_str(), 4 );
+
+    std::string noindex = U::form_path(FOLD, "noindex") ;   // plain directory of arrays, key order from U::DirList
+    for(int i=0 ; i < 20 ; i++) f->get_array(i)->save(noindex.c_str(), f->get_key(i)) ;
+    for(int j=0 ; j < 5 ; j++)
+    {
+        const NPFold* sub = f->get_subfold(j) ;
+        std::string subdir = U::form_path(noindex.c_str(), f->get_subfold_key(j)) ;
+        for(int i=0 ; i < 8-1 ; i++) sub->get_array(i)->save(subdir.c_str(), sub->get_key(i)) ;
+        sub->get_subfold(0u)->get_array(0)->save(subdir.c_str(), "subsub", "deep.npy") ;
+    }
+    check( noindex.c_str(), 3 );
+
+    return 0 ;
+}
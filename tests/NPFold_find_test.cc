@@ -0,0 +1,86 @@
+// name=NPFold_find_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_find_test.cc
+=====================
+
+Checks the hashed lookups of NPFold::find NPFold::get_subfold_idx
+and NPFold::find_subfold against linear scans of kk, ff and the
+paths from NPFold::Traverse_r, including after clear and clear_except
+and with a subfold key containing a slash.
+
+**/
+
+#include "NPFold.h"
+
+void check_tree(const NPFold* top)
+{
+    std::vector<const NPFold*> folds ;
+    std::vector<std::string>   paths ;
+    NPFold::Traverse_r( top, "", folds, paths );
+    for(unsigned i=0 ; i < paths.size() ; i++)
+    {
+        const NPFold* f = folds[i] ;
+        assert( top->find_subfold(paths[i].c_str()) == f );
+        for(unsigned j=0 ; j < f->kk.size() ; j++)
+        {
+            assert( f->find(f->kk[j].c_str()) == int(j) );
+            if(paths[i].empty()) continue ;   // find_array needs a slash in the path
+            std::string apath = NPFold::Concat(paths[i].c_str(), f->kk[j].c_str(), '/') ;
+            assert( top->find_array(apath.c_str()) == f->aa[j] );
+        }
+        for(unsigned j=0 ; j < f->ff.size() ; j++) assert( f->get_subfold_idx(f->ff[j].c_str()) == int(j) );
+    }
+    std::cout << "check_tree folds " << folds.size() << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    NPFold* f = new NPFold ;
+    for(int i=0 ; i < 1000 ; i++) f->add( ("k" + std::to_string(i)).c_str(), NP::Make<int>(1) );
+    NPFold* parent = f ;
+    for(int d=0 ; d < 5 ; d++)
+    {
+        NPFold* sub = new NPFold ;
+        sub->add("hit", NP::Make<float>(10, 4) );
+        for(int j=0 ; j < 3 ; j++)
+        {
+            NPFold* leaf = new NPFold ;
+            leaf->add("x", NP::Make<double>(j+1) );
+            sub->add_subfold( ("leaf" + std::to_string(j)).c_str(), leaf );
+        }
+        parent->add_subfold( ("d" + std::to_string(d)).c_str(), sub );
+        parent = sub ;
+    }
+    NPFold* slashed = new NPFold ;
+    slashed->add("y", NP::Make<double>(2) );
+    f->add_subfold("p/q", slashed );
+
+    check_tree(f);
+
+    assert( f->find("k10") == 10 );
+    assert( f->find("k10.npy") == 10 );
+    assert( f->find("missing") == NPFold::UNDEF );
+    assert( f->find_subfold("d0/d1/leaf2") == f->get_subfold("d0")->get_subfold("d1")->get_subfold("leaf2") );
+    assert( f->find_subfold("p/q") == slashed );
+    assert( f->find_subfold("d0/") == nullptr );
+    assert( f->find_subfold("/d0") == nullptr );
+    assert( f->find_subfold("d0/nope") == nullptr );
+    assert( f->find_array("d0/d1/hit.npy") == f->get_subfold("d0")->get_subfold("d1")->get("hit") );
+
+    f->clear_except("k5,k7", false) ;
+    assert( f->kk.size() == 2 && f->find("k7") == 1 && f->find("k10") == NPFold::UNDEF );
+    assert( f->ff.size() == 0 && f->find_subfold("d0") == nullptr );
+
+    f->add("k10", NP::Make<int>(2) );
+    f->set("k5", NP::Make<int>(3) );
+    assert( f->find("k10") == 2 && f->get("k5")->shape[0] == 3 );
+    check_tree(f);
+
+    f->clear();
+    assert( f->find("k5") == NPFold::UNDEF );
+    f->add("k5", NP::Make<int>(1) );
+    assert( f->find("k5") == 0 );
+
+    std::cout << "NPFold_find_test " << f->descKeys() << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,150 @@
+// name=NPFold_manifest_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_manifest_test.cc
+=========================
+
+Compares NPFold::LoadNoData using the manifest written by NPFold::save
+with the per-file load, checks the manifest alone is read by removing
+the array files, that a manifest older than the index or than an array
+saved again is ignored, that fortran_order is kept and that lazy loads
+from the manifest read the payloads.
+
+**/
+
+#include <sys/stat.h>
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NPFold_manifest_test" ;
+
+void compare(const NPFold* a, const NPFold* b)
+{
+    assert( a->kk == b->kk );
+    assert( a->ff == b->ff );
+    assert( a->meta == b->meta );
+    assert( a->names == b->names );
+    for(unsigned i=0 ; i < a->kk.size() ; i++)
+    {
+        const NP* x = a->aa[i] ;
+        const NP* y = b->aa[i] ;
+        assert( x->nodata == y->nodata );
+        assert( x->shape == y->shape );
+        assert( strcmp(x->dtype, y->dtype) == 0 );
+        assert( x->fortran_order == y->fortran_order );
+        assert( x->arr_bytes() == y->arr_bytes() );
+        assert( x->meta == y->meta );
+        assert( x->names == y->names );
+        assert( x->lpath == y->lpath );
+        assert( (x->labels == nullptr) == (y->labels == nullptr) );
+        if(x->labels) assert( *x->labels == *y->labels );
+    }
+    for(unsigned i=0 ; i < a->ff.size() ; i++) compare( a->subfold[i], b->subfold[i] );
+}
+
+NPFold* make_fold()
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<std::string>("creator", "NPFold_manifest_test") ;
+    f->set_meta<int64_t>("t_BeginOfRun", 1700000000000000 ) ;
+    f->names.push_back("top") ;
+
+    NP* a = NP::Make<float>(100, 4, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<int>("ni", 100) ;
+    a->set_meta<std::string>("note", "two words") ;
+    f->add("a", a );
+
+    NP* b = NP::Make<double>(3) ;
+    b->names = {"x", "y", "z" } ;
+    b->labels = new std::vector<std::string> { "X", "Y", "Z" } ;
+    f->add("b", b );
+
+    NP* v = NP::Make<float>(5) ;      // 1D fortran_order is the same layout and loads without NP::LoadFortran
+    v->fortran_order = true ;
+    f->add("v", v );
+
+    for(int j=0 ; j < 3 ; j++)
+    {
+        NPFold* sub = new NPFold ;
+        sub->set_meta<int>("index", j) ;
+        NP* c = NP::Make<int>(7+j, 3) ;
+        c->fillIndexFlat();
+        sub->add("c", c );
+        f->add_subfold( ("p" + std::to_string(j)).c_str(), sub );
+    }
+    return f ;
+}
+
+void set_mtime(const char* path, time_t t)
+{
+    struct timespec ts[2] = { { t, 0 }, { t, 0 } } ;
+    int rc = utimensat(AT_FDCWD, path, ts, 0 );
+    assert( rc == 0 );
+}
+
+int main(int argc, char** argv)
+{
+    NPFold* f = make_fold();
+    std::string dir = U::form_path(FOLD, "fold") ;
+    std::string manifest = U::form_path(dir.c_str(), NPFold::MANIFEST) ;
+    std::string index = U::form_path(dir.c_str(), NPFold::INDEX) ;
+    f->save(dir.c_str()) ;
+    assert( NPFold::HasFreshManifest(dir.c_str()) );
+
+    NPFold* m = NPFold::LoadNoData(dir.c_str()) ;      // from manifest
+
+    std::string saved = U::form_path(FOLD, "saved_manifest.txt") ;
+    rename( manifest.c_str(), saved.c_str() );
+    NPFold* n = NPFold::LoadNoData(dir.c_str()) ;      // from individual files
+    rename( saved.c_str(), manifest.c_str() );
+
+    compare( m, n );
+
+    NPFold* z = NPFold::LoadLazy(dir.c_str()) ;        // lazy from manifest reads payload on access
+    assert( z->aa[0]->nodata );
+    assert( NP::Memcmp(z->get("a"), f->get("a")) == 0 );
+    assert( NP::Memcmp(z->find_array("p2/c.npy"), f->get_subfold("p2")->get("c")) == 0 );
+
+    set_mtime( manifest.c_str(), 1000 );               // stale : older than index
+    assert( !NPFold::HasFreshManifest(dir.c_str()) );
+    NPFold* s = NPFold::LoadNoData(dir.c_str()) ;
+    compare( s, n );
+
+    std::string moved = U::form_path(FOLD, "moved") ;  // only the manifests and index remain
+    f->save(dir.c_str()) ;
+    U::MakeDirs(moved.c_str());
+    for(unsigned i=0 ; i < f->kk.size() ; i++)
+    {
+        std::string src = U::form_path(dir.c_str(), f->kk[i].c_str()) ;
+        std::string dst = U::form_path(moved.c_str(), f->kk[i].c_str()) ;
+        rename( src.c_str(), dst.c_str() );
+    }
+    NPFold* o = NPFold::LoadNoData(dir.c_str()) ;
+    compare( o, m );
+    for(unsigned i=0 ; i < f->kk.size() ; i++)
+    {
+        std::string src = U::form_path(moved.c_str(), f->kk[i].c_str()) ;
+        std::string dst = U::form_path(dir.c_str(), f->kk[i].c_str()) ;
+        rename( src.c_str(), dst.c_str() );
+    }
+
+    assert( m->get("v")->fortran_order && !m->get("a")->fortran_order );
+    const NP* lv = z->get("v") ;
+    assert( lv->fortran_order && !lv->nodata );
+
+    f->save(dir.c_str()) ;                             // array saved again after the manifest : not used
+    set_mtime( manifest.c_str(), 1000 );
+    set_mtime( index.c_str(), 1000 );
+    assert( NPFold::HasFreshManifest(dir.c_str()) );
+    NP* a2 = NP::Make<float>(50, 4) ;
+    a2->save( U::form_path(dir.c_str(), "a.npy").c_str() ) ;
+    NPFold* r = NPFold::LoadNoData(dir.c_str()) ;
+    assert( r->get("a")->shape == a2->shape );
+    f->save(dir.c_str()) ;
+
+    NP* sm = m->submeta("//p") ;
+    NP* sn = n->submeta("//p") ;
+    assert( sm && sn && NP::Memcmp(sm, sn) == 0 );
+
+    std::cout << "NPFold_manifest_test" << std::endl << U::ReadString(manifest.c_str()) << std::endl ;
+    return 0 ;
+}
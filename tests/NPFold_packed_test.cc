@@ -0,0 +1,116 @@
+// name=NPFold_packed_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_packed_test.cc
+=======================
+
+Saves a fold tree with NPFold::save and NPFold::SavePacked, checking
+the packed load matches the directory load, that single arrays can be
+read from the container by path, that payloads are 64-byte aligned and that
+unpacking recreates the saved files byte for byte.
+
+**/
+
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NPFold_packed_test" ;
+
+void compare(const NPFold* a, const NPFold* b)
+{
+    assert( a->kk == b->kk );
+    assert( a->ff == b->ff );
+    assert( NPFold::Compare(a, b) == 0 );
+    assert( a->meta == b->meta );
+    assert( a->names == b->names );
+    for(unsigned i=0 ; i < a->kk.size() ; i++)
+    {
+        const NP* x = a->get_array(i) ;
+        const NP* y = b->get_array(i) ;
+        assert( x->meta == y->meta );
+        assert( x->names == y->names );
+        assert( (x->labels == nullptr) == (y->labels == nullptr) );
+        if(x->labels) assert( *x->labels == *y->labels );
+    }
+    for(unsigned i=0 ; i < a->ff.size() ; i++) compare( a->subfold[i], b->subfold[i] );
+}
+
+bool same_file(const char* p, const char* q)
+{
+    std::ifstream fp(p, std::ios::binary), fq(q, std::ios::binary);
+    std::string sp((std::istreambuf_iterator<char>(fp)), std::istreambuf_iterator<char>());
+    std::string sq((std::istreambuf_iterator<char>(fq)), std::istreambuf_iterator<char>());
+    return !fp.fail() && !fq.fail() && sp == sq ;
+}
+
+int main(int argc, char** argv)
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<std::string>("creator", "NPFold_packed_test") ;
+    f->names.push_back("top") ;
+
+    NP* a = NP::Make<float>(100, 4, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<int>("ni", 100) ;
+    f->add("a", a );
+
+    NP* b = NP::Make<double>(3) ;
+    b->names = {"x", "y", "z" } ;
+    b->labels = new std::vector<std::string> { "X", "Y", "Z" } ;
+    f->add("b", b );
+
+    NPFold* sub = new NPFold ;
+    NP* c = NP::Make<int>(7, 3) ;
+    c->fillIndexFlat();
+    sub->add("c", c );
+    NPFold* subsub = new NPFold ;
+    subsub->add("d", NP::Make<unsigned char>(5) );
+    sub->add_subfold("subsub", subsub );
+    f->add_subfold("sub", sub );
+
+    std::string dir = U::form_path(FOLD, "dir") ;
+    std::string pk = U::form_path(FOLD, "fold.npfold") ;
+    std::string unpacked = U::form_path(FOLD, "unpacked") ;
+
+    f->save(dir.c_str()) ;
+    int rc = NPFold::SavePacked(f, pk.c_str()) ;
+    assert( rc == 0 );
+
+    NPFold* d = NPFold::Load(dir.c_str()) ;
+    NPFold* p = NPFold::LoadPacked(pk.c_str()) ;
+    compare( d, p );
+
+    NP* pc = NPFold::LoadPackedArray(pk.c_str(), "sub/c.npy") ;
+    assert( pc && NP::Memcmp(pc, c) == 0 );
+    assert( NPFold::LoadPackedArray(pk.c_str(), "sub/missing.npy") == nullptr );
+
+    NPFoldPacked k ;
+    assert( k.open(pk.c_str()) == 0 );
+    assert( k.data_start % NPFoldPacked::ALIGN == 0 );
+    for(unsigned i=0 ; i < k.entries.size() ; i++)
+    {
+        const NPFoldPacked::Entry& e = k.entries[i] ;
+        assert( e.offset % NPFoldPacked::ALIGN == 0 );
+        if(NPFold::IsNPY(e.path.c_str())) assert( !e.dtype.empty() && !e.shape.empty() );
+        assert( k.find(e.path.c_str()) == int(i) );
+    }
+    int ia = k.find("a.npy") ;
+    assert( ia > -1 && k.entries[ia].shape.compare("100,4,4") == 0 && k.find("/a.npy") == ia );
+    assert( k.find("missing.npy") == -1 );
+    NP* kc = k.find_array("sub/c.npy") ;
+    assert( kc && NP::Memcmp(kc, c) == 0 && kc->meta == c->meta );
+    std::cout << k.desc() ;
+
+    rc = NPFold::UnpackPacked(pk.c_str(), unpacked.c_str()) ;
+    assert( rc == 0 );
+    for(unsigned i=0 ; i < k.entries.size() ; i++)
+    {
+        const char* rel = k.entries[i].path.c_str() ;
+        std::string p0 = U::form_path(dir.c_str(), rel) ;
+        std::string p1 = U::form_path(unpacked.c_str(), rel) ;
+        bool same = same_file(p0.c_str(), p1.c_str()) ;
+        if(!same) std::cerr << "NPFold_packed_test DIFFERENT " << rel << std::endl ;
+        assert( same );
+    }
+
+    std::cout << "NPFold_packed_test " << p->desc_subfold() << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,82 @@
+// name=NPFold_save_async_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPFold_save_async_test.cc
+===========================
+
+Saves the same fold with NPFold::save and NPFold::save_async,
+changing the fold immediately after save_async returns to check
+the snapshot, then compares the loaded folds and checks that each
+manifest is not older than the index and arrays of its fold.
+
+**/
+
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NPFold_save_async_test" ;
+
+NPFold* make_fold(int num_sub)
+{
+    NPFold* f = new NPFold ;
+    f->set_meta<int>("num_sub", num_sub) ;
+    f->add("a", NP::Linspace<double>(0., 1., 101) );
+    f->add("b", NP::Make<float>(1000, 4, 4) );
+    f->names.push_back("top") ;
+    for(int i=0 ; i < num_sub ; i++)
+    {
+        NPFold* sub = new NPFold ;
+        NP* c = NP::Make<int>(100+i, 4) ;
+        c->fillIndexFlat();
+        c->set_meta<int>("i", i);
+        sub->add("c", c );
+        f->add_subfold( ("sub" + std::to_string(i)).c_str(), sub );
+    }
+    return f ;
+}
+
+void compare(const NPFold* a, const NPFold* b)
+{
+    assert( NPFold::Compare(a, b) == 0 );
+    assert( a->meta == b->meta );
+    assert( a->names == b->names );
+    assert( a->ff == b->ff );
+    for(unsigned i=0 ; i < a->ff.size() ; i++) compare( a->subfold[i], b->subfold[i] );
+}
+
+void check_manifest(const NPFold* f, const std::string& dir)
+{
+    int64_t mt = NPFold::MTime( U::form_path(dir.c_str(), NPFold::MANIFEST).c_str() ) ;
+    assert( NPFold::HasFreshManifest(dir.c_str()) );
+    for(unsigned i=0 ; i < f->kk.size() ; i++) assert( NPFold::MTime( U::form_path(dir.c_str(), f->kk[i].c_str()).c_str() ) <= mt );
+    for(unsigned i=0 ; i < f->ff.size() ; i++) check_manifest( f->subfold[i], U::form_path(dir.c_str(), f->ff[i].c_str()) );
+}
+
+int main(int argc, char** argv)
+{
+    NPFold* f = make_fold(10) ;
+
+    std::string sync = U::form_path(FOLD, "sync") ;
+    std::string async = U::form_path(FOLD, "async") ;
+
+    f->save(sync.c_str());
+
+    NPFoldAsync writer(4, 64*1024) ;   // small in-flight cap to exercise backpressure
+    std::future<int> done = f->save_async(async.c_str(), &writer ) ;
+
+    NP* b = f->get_("b.npy") ;         // changing after save_async must not change what is written
+    b->fill<float>(1.f) ;
+
+    int rc = done.get() ;
+    assert( rc == 0 );
+    assert( writer.get_inflight() == 0 );
+
+    NPFold* s = NPFold::Load(sync.c_str()) ;
+    NPFold* a = NPFold::Load(async.c_str()) ;
+    compare( s, a );
+    check_manifest( f, async );
+
+    std::future<int> bad = f->save_async("$NPFold_save_async_test_UNDEFINED_TOKEN/x") ;
+    assert( bad.get() == 1 );
+
+    std::cout << "NPFold_save_async_test " << a->desc_subfold() << std::endl ;
+    return 0 ;
+}
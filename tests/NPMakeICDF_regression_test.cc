@@ -0,0 +1,153 @@
+// name=NPMakeICDF_regression_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPMakeICDF_regression_test.cc
+===============================
+
+Checks that NP::MakeICDF gives bitwise the same ICDF as the former
+implementation, kept here as MakeICDF_pdomain, that does one NP::pdomain
+lookup per output value. The inputs are the NPMakeICDFTest.cc
+distribution and multi-item CDFs with flat stretches, for hd_factor 0, 10, 20,
+float and double and several thread counts, plus an item with values
+that are not monotonic. Times both for many items with nu 4096.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NP.hh"
+
+std::mt19937_64 rng(11) ;
+
+template<typename T>
+NP* MakeICDF_pdomain(const NP* cdf, unsigned nu, unsigned hd_factor)
+{
+    unsigned ndim = cdf->shape.size();
+    unsigned num_items = ndim == 3 ? cdf->shape[0] : 1 ;
+    T edge = hd_factor > 0 ? T(1.)/T(hd_factor) : 0. ;
+    NP* icdf = new NP(cdf->dtype, num_items, nu, hd_factor == 0 ? 1 : 4 );
+    T* vv = icdf->values<T>();
+    unsigned ni = icdf->shape[0] ;
+    unsigned nj = icdf->shape[1] ;
+    unsigned nk = icdf->shape[2] ;
+    for(unsigned i=0 ; i < ni ; i++)
+    {
+        int item = i ;
+        for(unsigned j=0 ; j < nj ; j++)
+        {
+            T y_all = T(j)/T(nj) ;
+            T x_all = cdf->pdomain<T>( y_all, item );
+            unsigned offset = i*nj*nk+j*nk ;
+            vv[offset+0] = x_all ;
+            if( hd_factor > 0 )
+            {
+                T y_lhs = T(j)/T(hd_factor*nj) ;
+                T y_rhs = T(1.) - edge + T(j)/T(hd_factor*nj) ;
+                vv[offset+1] = cdf->pdomain<T>( y_lhs, item );
+                vv[offset+2] = cdf->pdomain<T>( y_rhs, item );
+                vv[offset+3] = 0. ;
+            }
+        }
+    }
+    return icdf ;
+}
+
+NP* make_dist_NPMakeICDFTest()
+{
+    std::vector<double> src = { 0.,0., 1.,10., 2.,20., 3.,30., 4.,40., 5.,50., 6.,60., 7.,70., 8.,80., 9.,90. };
+    NP* dist0 = NP::Make<double>( src.size()/2 , 2 ) ;
+    dist0->read(src.data());
+    return NP::MakeDiv<double>(dist0, 10 ) ;
+}
+
+template<typename T>
+NP* make_cdfs(int num_items, int ni)
+{
+    NP* a = NP::Make<T>(num_items, ni, 2) ;
+    T* aa = a->values<T>() ;
+    std::uniform_real_distribution<T> u(0, 1) ;
+    for(int item=0 ; item < num_items ; item++)
+    {
+        T* vv = aa + item*ni*2 ;
+        T x = u(rng) ;
+        T y = 0 ;
+        for(int i=0 ; i < ni ; i++)
+        {
+            vv[2*i+0] = x ;
+            vv[2*i+1] = y ;
+            x += T(0.01) + u(rng) ;
+            if( u(rng) > T(0.3) ) y += u(rng) ;     // flat stretches
+        }
+        for(int i=0 ; i < ni ; i++) vv[2*i+1] /= y ;
+    }
+    return a ;
+}
+
+void test_NPMakeICDFTest()
+{
+    NP* dist = make_dist_NPMakeICDFTest() ;
+    NP* cdf = NP::MakeCDF<double>( dist );
+    for(unsigned hd_factor=0 ; hd_factor <= 20 ; hd_factor += 10)
+    {
+        NP* a = NP::MakeICDF<double>( cdf, 91, hd_factor );
+        NP* b = MakeICDF_pdomain<double>( cdf, 91, hd_factor );
+        assert( NP::Memcmp(a, b) == 0 );
+    }
+    std::cout << "test_NPMakeICDFTest " << cdf->sstr() << std::endl ;
+}
+
+template<typename T>
+void test_items(int num_items, int ni, unsigned nu)
+{
+    NP* cdf = make_cdfs<T>(num_items, ni) ;
+    for(unsigned hd_factor=0 ; hd_factor <= 20 ; hd_factor += 10)
+    {
+        NP* b = MakeICDF_pdomain<T>( cdf, nu, hd_factor );
+        for(int nt=1 ; nt <= 4 ; nt++)
+        {
+            NP* a = NP::MakeICDF<T>( cdf, nu, hd_factor, false, nt );
+            assert( NP::Memcmp(a, b) == 0 );
+        }
+    }
+    std::cout << "test_items " << cdf->sstr() << " " << cdf->dtype << " nu " << nu << std::endl ;
+}
+
+void test_nonmonotonic()
+{
+    NP* cdf = make_cdfs<double>(3, 50) ;
+    double* vv = cdf->values<double>() + 50*2 ;   // item 1
+    std::swap( vv[2*20+1], vv[2*30+1] ) ;
+    NP* a = NP::MakeICDF<double>( cdf, 500, 20 );
+    NP* b = MakeICDF_pdomain<double>( cdf, 500, 20 );
+    assert( NP::Memcmp(a, b) == 0 );
+    std::cout << "test_nonmonotonic" << std::endl ;
+}
+
+void test_timing()
+{
+    int num_items = U::GetEnvInt("NUM_ITEMS", 50) ;
+    NP* cdf = make_cdfs<double>(num_items, 500) ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    NP* b = MakeICDF_pdomain<double>( cdf, 4096, 20 );
+    auto t1 = std::chrono::high_resolution_clock::now();
+    NP* a = NP::MakeICDF<double>( cdf, 4096, 20 );
+    auto t2 = std::chrono::high_resolution_clock::now();
+    assert( NP::Memcmp(a, b) == 0 );
+    std::cout
+        << "test_timing " << cdf->sstr() << " -> " << a->sstr()
+        << " pdomain " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " MakeICDF " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_NPMakeICDFTest();
+    test_items<double>(7, 40, 91);
+    test_items<float>(5, 200, 1000);
+    test_items<double>(1, 2, 17);
+    test_nonmonotonic();
+    test_timing();
+    std::cout << "NPMakeICDF_regression_test" << std::endl ;
+    return 0 ;
+}
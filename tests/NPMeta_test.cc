@@ -0,0 +1,136 @@
+// name=NPMeta_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPMeta_test.cc
+================
+
+Checks that NP::get_meta/set_meta/set_meta_kv using the NPMeta index
+give the same results and the same meta string as the string parsing
+NP::GetMeta/NP::SetMeta, including duplicated keys, lines without colon,
+values with newlines and direct changes to the meta string, including
+same length changes detected by the NPMeta signature. Times
+per-key access to metadata with many stamp keys.
+
+**/
+
+#include <chrono>
+#include "NPFold.h"
+
+std::mt19937 rng(42) ;
+
+std::string random_key(int n){ return "k" + std::to_string( rng() % n ) ; }
+
+void check(const NP* a, const std::string& ref, int n)
+{
+    assert( a->meta == ref );
+    for(int i=0 ; i < n ; i++)
+    {
+        std::string k = "k" + std::to_string(i) ;
+        std::string rv = ref.empty() ? "" : NP::get_meta_string(ref, k.c_str()) ;   // nullptr metadata not handled
+        assert( a->get_meta_string(k.c_str()) == rv );
+        assert( a->get_meta<int>(k.c_str(), -1) == NP::GetMeta<int>(ref, k.c_str(), -1) );
+    }
+}
+
+void test_random()
+{
+    int n = 50 ;
+    NP* a = NP::Make<int>(1) ;
+    std::string ref ;
+    for(int it=0 ; it < 3000 ; it++)
+    {
+        int op = rng() % 10 ;
+        std::string k = random_key(n) ;
+        int v = rng() % 1000 ;
+        switch(op)
+        {
+            case 0: a->meta += "noline\n" ; ref += "noline\n" ; break ;             // direct change
+            case 1: a->meta += k + ":" + std::to_string(v) ; ref += k + ":" + std::to_string(v) ; break ;   // no newline, maybe duplicate
+            case 2: a->set_meta<std::string>(k.c_str(), "x\ny:z") ; NP::SetMeta<std::string>(ref, k.c_str(), "x\ny:z") ; break ;
+            case 3: a->set_meta<float>(k.c_str(), v/3.f) ; NP::SetMeta<float>(ref, k.c_str(), v/3.f) ; break ;
+            case 4: a->set_meta<std::string>("a:b", "c") ; NP::SetMeta<std::string>(ref, "a:b", "c") ; break ;
+            case 5: a->set_meta<std::string>(k.c_str(), "") ; NP::SetMeta<std::string>(ref, k.c_str(), "") ; break ;
+            default: a->set_meta<int>(k.c_str(), v) ; NP::SetMeta<int>(ref, k.c_str(), v) ; break ;
+        }
+        if(it % 100 == 0) check(a, ref, n);
+        if(it % 1000 == 999)
+        {
+            a->meta = "" ;
+            ref = "" ;
+        }
+    }
+    check(a, ref, n);
+
+    NP* b = NP::MakeCopy(a) ;                    // copies get their own index
+    b->set_meta<int>("k0", 123) ;
+    NP::SetMeta<int>(ref, "k0", 123) ;
+    check(b, ref, n);
+
+    std::vector<std::pair<std::string, int>> kvs ;
+    for(int i=0 ; i < 2*n ; i++) kvs.push_back( { random_key(2*n), i } );
+    b->set_meta_kv(kvs) ;
+    NP::SetMetaKV(ref, kvs) ;
+    check(b, ref, 2*n);
+    assert( b->has_meta_key("k0") && !b->has_meta_key("nope") );
+}
+
+void test_fold()
+{
+    NPFold* f = new NPFold ;
+    std::string ref ;
+    std::vector<std::string> keys, vals ;
+    for(int i=0 ; i < 100 ; i++)
+    {
+        keys.push_back( "s" + std::to_string(i % 70) ) ;
+        vals.push_back( std::to_string(1700000000000000 + i) ) ;
+    }
+    f->setMetaKV(keys, vals) ;
+    NP::SetMetaKV_(ref, keys, vals) ;
+    assert( f->meta == ref );
+    assert( f->get_meta<int64_t>("s5", 0) == 1700000000000000 + 75 );
+    assert( f->get_meta_string("s69") == NP::get_meta_string(ref, "s69") );
+    f->meta = "s5:1\n" ;
+    assert( f->get_meta<int>("s5", 0) == 1 );
+    f->meta = "s5:2\n" ;                         // same length : short strings are hashed entirely
+    assert( f->get_meta<int>("s5", 0) == 2 );
+    f->meta = ref ;
+    assert( f->get_meta<int64_t>("s69", 0) == 1700000000000000 + 69 );
+    f->meta[f->meta.size()-2] = '8' ;            // same length edit of the last value, a sampled byte
+    assert( f->get_meta<int64_t>("s69", 0) == 1700000000000000 + 68 );
+}
+
+void test_timing()
+{
+    int n = U::GetEnvInt("NUM_KEY", 500) ;
+    NP* a = NP::Make<int>(1) ;
+    std::string ref ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < n ; i++) NP::SetMeta<int64_t>(ref, ("t_stamp" + std::to_string(i)).c_str(), 1700000000000000 + i ) ;
+    int64_t s0 = 0 ;
+    for(int i=0 ; i < n ; i++) s0 += NP::GetMeta<int64_t>(ref, ("t_stamp" + std::to_string(i)).c_str(), 0 ) ;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < n ; i++) a->set_meta<int64_t>(("t_stamp" + std::to_string(i)).c_str(), 1700000000000000 + i ) ;
+    int64_t s1 = 0 ;
+    for(int i=0 ; i < n ; i++) s1 += a->get_meta<int64_t>(("t_stamp" + std::to_string(i)).c_str(), 0 ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    assert( s0 == s1 && a->meta == ref );
+    std::cout
+        << "test_timing num_key " << n
+        << " SetMeta+GetMeta " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " set_meta+get_meta " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        << a->meta_idx.desc()
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_random();
+    test_fold();
+    test_timing();
+    std::cout << "NPMeta_test" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,134 @@
+// name=NPPhilox_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPPhilox_test.cc
+==================
+
+Checks NPPhilox against the Random123 philox4x32-10 known answers,
+that stream draws, offsets and subsequences are consistent, and that
+NP::MakeUniform and NP::MakeLookupSample give bitwise identical arrays
+for any number of threads. Times MakeUniform with 1 thread and the default.
+
+**/
+
+#include <chrono>
+#include "NP.hh"
+
+void test_kat()
+{
+    uint32_t kat[3][10] = {
+        { 0u,0u,0u,0u,  0u,0u,  0x6627e8d5u,0xe169c58du,0xbc57ac4cu,0x9b00dbd8u },
+        { 0xffffffffu,0xffffffffu,0xffffffffu,0xffffffffu,  0xffffffffu,0xffffffffu,  0x408f276du,0x41c83b0eu,0xa20bc7c6u,0x6d5451fdu },
+        { 0x243f6a88u,0x85a308d3u,0x13198a2eu,0x03707344u,  0xa4093822u,0x299f31d0u,  0xd16cfe09u,0x94fdccebu,0x5001e420u,0x24126ea1u }
+    };
+    for(int k=0 ; k < 3 ; k++)
+    {
+        uint32_t out[4] ;
+        NPPhilox::Block(out, kat[k], kat[k]+4 );
+        for(int i=0 ; i < 4 ; i++) assert( out[i] == kat[k][6+i] );
+    }
+    std::cout << "test_kat" << std::endl ;
+}
+
+void test_stream()
+{
+    uint64_t seed = 0x123456789abcdefull ;
+    NPPhilox a(seed, 42) ;
+    std::vector<uint32_t> r(40) ;
+    for(int i=0 ; i < 40 ; i++) r[i] = a.next() ;
+
+    for(int off=0 ; off < 30 ; off++)
+    {
+        NPPhilox b(seed, 42, off) ;
+        for(int i=off ; i < 40 ; i++) assert( b.next() == r[i] );
+    }
+
+    NPPhilox c(seed, 42) ;
+    assert( c.uniform<float>() == NPPhilox::U01(r[0]) );
+    assert( c.uniform<double>() == NPPhilox::U01(r[1], r[2]) );
+    assert( NPPhilox::Uniform<float>(seed, 42) == NPPhilox::U01(r[0]) );
+    assert( NPPhilox::Uniform<double>(seed, 42) == NPPhilox::U01(r[0], r[1]) );
+
+    NPPhilox d(seed, 43) ;
+    assert( d.next() != r[0] );
+
+    NPPhilox e(seed, 0) ;
+    e.ctr[0] = ~0u ;
+    e.ctr[1] = ~0u ;
+    e.incr() ;                       // counter carry into the subsequence words
+    assert( e.ctr[2] == 1u && e.ctr[0] == 0u && e.ctr[1] == 0u );
+    NPPhilox f(seed, 0, 4*5 + 2) ;
+    assert( f.ctr[0] == 5u && f.pos == 2 );
+
+    assert( NPPhilox::U01(0u) > 0.f && NPPhilox::U01(~0u) == 1.f );
+    assert( NPPhilox::U01(0u, 0u) > 0. && NPPhilox::U01(~0u, ~0u) <= 1. );
+    std::cout << "test_stream" << std::endl ;
+}
+
+template<typename T>
+void test_uniform(unsigned ni)
+{
+    NP* u1 = NP::MakeUniform<T>(ni, 7u, 1) ;
+    NP* u3 = NP::MakeUniform<T>(ni, 7u, 3) ;
+    NP* u0 = NP::MakeUniform<T>(ni, 7u) ;
+    NP* u8 = NP::MakeUniform<T>(ni, 8u) ;
+    assert( NP::Memcmp(u1, u3) == 0 && NP::Memcmp(u1, u0) == 0 );
+    assert( NP::Memcmp(u1, u8) != 0 );
+
+    const T* vv = u1->cvalues<T>() ;
+    double sum = 0. ;
+    for(unsigned i=0 ; i < ni ; i++)
+    {
+        assert( vv[i] > T(0) && vv[i] <= T(1) );
+        sum += vv[i] ;
+    }
+    double mean = sum/ni ;
+    assert( std::abs(mean - 0.5) < 0.01 );
+    assert( vv[5] == NPPhilox::Uniform<T>(7u, 5) );
+    std::cout << "test_uniform " << u1->sstr() << " " << u1->dtype << " mean " << mean << std::endl ;
+}
+
+void test_lookup_sample()
+{
+    NP* icdf = NP::Make<double>(101, 2) ;   // icdf_prop : (u, value) pairs with value u^2
+    double* ii = icdf->values<double>() ;
+    for(int i=0 ; i < 101 ; i++)
+    {
+        double u = double(i)/100. ;
+        ii[2*i+0] = u ;
+        ii[2*i+1] = u*u ;
+    }
+    NP* s1 = NP::MakeLookupSample<double>(icdf, 200000, 3u, 0u, 1) ;
+    NP* s4 = NP::MakeLookupSample<double>(icdf, 200000, 3u, 0u, 4) ;
+    assert( NP::Memcmp(s1, s4) == 0 );
+    assert( s1->get<double>(11) == icdf->interp<double>( NPPhilox::Uniform<double>(3u, 11) ) );
+    std::cout << "test_lookup_sample " << s1->sstr() << std::endl ;
+}
+
+void test_timing()
+{
+    unsigned ni = U::GetEnvInt("NUM_U", 10000000) ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    NP* a = NP::MakeUniform<float>(ni, 0u, 1) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    NP* b = NP::MakeUniform<float>(ni, 0u) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    assert( NP::Memcmp(a, b) == 0 );
+    std::cout
+        << "test_timing ni " << ni
+        << " MakeUniform(1 thread) " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " MakeUniform(" << UPool::NumThreads() << " threads) " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_kat();
+    test_stream();
+    test_uniform<float>(1000003);
+    test_uniform<double>(1000003);
+    test_lookup_sample();
+    test_timing();
+    std::cout << "NPPhilox_test" << std::endl ;
+    return 0 ;
+}
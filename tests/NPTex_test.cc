@@ -0,0 +1,189 @@
+// name=NPTex_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPTex_test.cc
+===============
+
+Checks NPTex 2D and 3D sampling against NP::interp2D and direct evaluation
+of the CUDA filtering formulas for all address modes, point and linear
+filtering and normalized and texel coordinates, and that batch samples
+match single samples bit for bit, also with emulate_9bit. Times the batch
+against NP::interp2D. The loops of NPTex::block2D and NPTex::block3D that
+the compiler vectorizes are listed with::
+
+    gcc NPTex_test.cc -std=c++11 -O2 -I.. -c -o /dev/null -fopt-info-vec-optimized 2>&1 | grep NPTex.h
+
+All but the texel gather loops are expected, as the gathers need AVX2.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NPTex.h"
+
+std::mt19937_64 rng(7) ;
+
+template<typename T>
+NP* make_tex(int nz, int ny, int nx)
+{
+    NP* a = nz > 0 ? NP::Make<T>(nz, ny, nx) : NP::Make<T>(ny, nx) ;
+    T* aa = a->values<T>() ;
+    std::uniform_real_distribution<T> u(-1, 1) ;
+    for(int64_t i=0 ; i < a->size ; i++) aa[i] = u(rng) ;
+    return a ;
+}
+
+/**
+reference texel fetch with addressing written out per mode
+**/
+
+template<typename T>
+T fetch(const NP* a, const NPTex<T>& tex, int i, int j, int k)
+{
+    int ii[3] = { i, j, k } ;
+    for(int d=0 ; d < tex.dim ; d++)
+    {
+        int nd = tex.n[d] ;
+        int& q = ii[d] ;
+        switch(tex.address[d])
+        {
+            case NPTex<T>::Clamp:  q = q < 0 ? 0 : ( q >= nd ? nd - 1 : q ) ; break ;
+            case NPTex<T>::Border: if( q < 0 || q >= nd ) return T(0) ; break ;
+            case NPTex<T>::Wrap:   q = ((q % nd) + nd) % nd ; break ;
+            case NPTex<T>::Mirror: { int w = ((q % (2*nd)) + 2*nd) % (2*nd) ; q = w < nd ? w : 2*nd - 1 - w ; } ; break ;
+        }
+    }
+    return tex.dim == 2 ? a->get<T>(ii[1], ii[0]) : a->get<T>(ii[2], ii[1], ii[0]) ;
+}
+
+template<typename T>
+T reference(const NP* a, const NPTex<T>& tex, T x, T y, T z)
+{
+    T c[3] = { x, y, z } ;
+    int i[3] ;
+    T f[3] ;
+    for(int d=0 ; d < tex.dim ; d++)
+    {
+        T u = tex.normalized ? c[d]*tex.n[d] : c[d] ;
+        if( tex.filter == NPTex<T>::Point )
+        {
+            i[d] = int(std::floor(u)) ;
+            f[d] = 0 ;
+        }
+        else
+        {
+            T uB = u - T(0.5) ;
+            i[d] = int(std::floor(uB)) ;
+            f[d] = uB - std::floor(uB) ;
+        }
+    }
+    if( tex.filter == NPTex<T>::Point ) return fetch<T>(a, tex, i[0], i[1], tex.dim == 3 ? i[2] : 0 ) ;
+    T s = 0 ;
+    for(int dk=0 ; dk < ( tex.dim == 3 ? 2 : 1 ) ; dk++)
+    for(int dj=0 ; dj < 2 ; dj++)
+    for(int di=0 ; di < 2 ; di++)
+    {
+        T w = ( di ? f[0] : 1 - f[0] )*( dj ? f[1] : 1 - f[1] ) ;
+        if( tex.dim == 3 ) w *= dk ? f[2] : 1 - f[2] ;
+        s += w*fetch<T>(a, tex, i[0]+di, i[1]+dj, tex.dim == 3 ? i[2]+dk : 0 ) ;
+    }
+    return s ;
+}
+
+template<typename T>
+void test_modes(int nz)
+{
+    NP* a = make_tex<T>(nz, 5, 7) ;
+    int n = 20000 ;
+    std::vector<T> x(n), y(n), z(n), out(n) ;
+    for(int normalized=0 ; normalized < 2 ; normalized++)
+    for(int filter=0 ; filter < 2 ; filter++)
+    for(int mode=0 ; mode < 4 ; mode++)
+    {
+        NPTex<T> tex(a, filter, mode, normalized) ;
+        if( mode == NPTex<T>::Border ) tex.set_address(1, NPTex<T>::Clamp) ;   // mixed modes
+        std::uniform_real_distribution<T> u( normalized ? -1.5 : -10, normalized ? 2.5 : 17 ) ;
+        for(int i=0 ; i < n ; i++)
+        {
+            x[i] = u(rng) ;
+            y[i] = u(rng) ;
+            z[i] = u(rng) ;
+        }
+        if( nz > 0 ) tex.sample(x.data(), y.data(), z.data(), out.data(), n, 3 ) ;
+        else         tex.sample(x.data(), y.data(), out.data(), n, 3 ) ;
+
+        T maxdiff = 0 ;
+        for(int i=0 ; i < n ; i++)
+        {
+            T s = nz > 0 ? tex.sample(x[i], y[i], z[i]) : tex.sample(x[i], y[i]) ;
+            assert( memcmp(&s, &out[i], sizeof(T)) == 0 );
+            T r = reference<T>(a, tex, x[i], y[i], z[i]) ;
+            maxdiff = std::max( maxdiff, std::abs(r - s) ) ;
+        }
+        assert( maxdiff < ( sizeof(T) == 4 ? 1e-4 : 1e-10 ) );
+        std::cout << tex.desc() << " maxdiff " << maxdiff << std::endl ;
+    }
+}
+
+void test_interp2D()
+{
+    NP* a = make_tex<float>(0, 8, 10) ;
+    NPTex<float> tex(a) ;
+    std::uniform_real_distribution<float> ux(0.5f, 9.49f), uy(0.5f, 7.49f) ;
+    for(int i=0 ; i < 10000 ; i++)
+    {
+        float x = ux(rng) ;
+        float y = uy(rng) ;
+        float s = tex.sample(x, y) ;
+        float r = a->interp2D<float>(x, y) ;
+        assert( s == r );
+    }
+    tex.emulate_9bit = true ;
+    assert( std::abs( tex.sample(3.3f, 4.1f) - a->interp2D<float>(3.3f, 4.1f) ) < 1e-2 );
+
+    int n = 1001 ;
+    std::vector<float> x(n), y(n), out(n) ;
+    for(int i=0 ; i < n ; i++)
+    {
+        x[i] = ux(rng) ;
+        y[i] = uy(rng) ;
+    }
+    tex.sample(x.data(), y.data(), out.data(), n ) ;
+    for(int i=0 ; i < n ; i++) assert( out[i] == tex.sample(x[i], y[i]) );
+}
+
+void test_timing()
+{
+    int n = U::GetEnvInt("NUM_S", 2000000) ;
+    NP* a = make_tex<float>(0, 512, 512) ;
+    NPTex<float> tex(a) ;
+    std::uniform_real_distribution<float> u(0.5f, 511.49f) ;
+    std::vector<float> x(n), y(n), o0(n), o1(n) ;
+    for(int i=0 ; i < n ; i++)
+    {
+        x[i] = u(rng) ;
+        y[i] = u(rng) ;
+    }
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < n ; i++) o0[i] = a->interp2D<float>(x[i], y[i]) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    tex.sample(x.data(), y.data(), o1.data(), n ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    assert( o0 == o1 );
+    std::cout
+        << "test_timing n " << n << " " << tex.desc()
+        << " interp2D " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " NPTex::sample " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_modes<float>(0);
+    test_modes<double>(0);
+    test_modes<float>(4);
+    test_interp2D();
+    test_timing();
+    std::cout << "NPTex_test" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,121 @@
+// name=NPU_header_v2_test ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name && /tmp/$name
+/**
+NPU_header_v2_test.cc
+=======================
+
+Checks:
+
+1. 64-bit element counts from NPS for shapes beyond 2^31 elements
+2. version 1.0 header round trip with HEADER_LEN containing the newline char 0x0a
+3. version 2.0 header (4 byte HEADER_LEN) round trip, including NP::Load of a file with such a header
+4. growth axis padding as NumPy : first dimension, last dimension with fortran_order
+
+**/
+
+#include <cstdio>
+#include "NP.hh"
+
+const char* FOLD = "/tmp/NPU_header_v2_test_fold" ;
+
+std::string make_dict(const std::vector<int>& shape, unsigned extra )
+{
+    std::string dict = NPU::_make_dict(shape, "<f4") ;
+    dict += std::string(extra, ' ') ;   // whitespace within the header is permitted
+    return dict ;
+}
+
+void check_roundtrip(const std::string& hdr, const std::vector<int>& shape, int expect_major )
+{
+    assert( int(hdr[6]) == expect_major );
+
+    std::stringstream ss ;
+    ss << hdr ;
+    std::string hdr2 ;
+    bool ok = NPU::_read_header(ss, hdr2 );
+    assert( ok );
+    assert( hdr2 == hdr );
+
+    std::vector<int> shape2 ;
+    std::string descr ;
+    char uifc ;
+    int ebyte ;
+    NPU::parse_header( shape2, descr, uifc, ebyte, hdr2 );
+
+    assert( shape2 == shape );
+    assert( uifc == 'f' );
+    assert( ebyte == 4 );
+}
+
+void test_NPS_size()
+{
+    std::vector<int> shape = { 1 << 16, 1 << 16 } ;
+    int64_t sz = NPS::size(shape) ;
+    assert( sz == int64_t(1) << 32 );
+
+    std::vector<int> big = { 24, 4096, 4096 } ;
+    int64_t bytes = NPS::size(big)*int64_t(sizeof(double)) ;
+    assert( bytes > std::numeric_limits<int>::max() );
+    std::cout << "test_NPS_size " << sz << " " << bytes << std::endl ;
+}
+
+void test_v1_newline_in_HEADER_LEN()
+{
+    std::vector<int> shape = { 10, 4 } ;
+    std::string dict = make_dict(shape, 2560) ;
+    std::string hdr = NPU::_make_header(dict) ;
+    assert( hdr[9] == '\n' );  // high byte of HEADER_LEN 0x0a.. would trip up getline based reading
+    check_roundtrip( hdr, shape, 1 );
+    std::cout << "test_v1_newline_in_HEADER_LEN " << hdr.size() << std::endl ;
+}
+
+void test_v2()
+{
+    std::vector<int> shape = { 3, 4 } ;
+    std::string dict = make_dict(shape, NPU::V1_MAX_HEADER_LEN ) ;
+    std::string hdr = NPU::_make_header(dict) ;
+    assert( hdr.size() > NPU::V1_MAX_HEADER_LEN );
+    assert( hdr.size() % 16 == 0 );
+    check_roundtrip( hdr, shape, 2 );
+
+    std::string path = U::form_path(FOLD, "v2.npy") ;
+    U::MakeDirsForFile(path.c_str());
+
+    std::vector<float> vals(3*4) ;
+    for(unsigned i=0 ; i < vals.size() ; i++) vals[i] = float(i) ;
+
+    std::ofstream fp(path.c_str(), std::ios::out|std::ios::binary);
+    fp << hdr ;
+    fp.write( (const char*)vals.data(), sizeof(float)*vals.size() );
+    fp.close();
+
+    NP* a = NP::Load(path.c_str()) ;
+    assert( a );
+    assert( a->shape == shape );
+    const float* aa = a->cvalues<float>() ;
+    for(unsigned i=0 ; i < vals.size() ; i++) assert( aa[i] == vals[i] );
+
+    std::cout << "test_v2 " << hdr.size() << " " << a->sstr() << std::endl ;
+}
+
+void test_growth_axis()
+{
+    int G = 1000000000 ;
+    std::vector<int> s0 = { 1, G, G, G, G } ;
+    std::vector<int> s1 = { G, G, G, G, 1 } ;
+
+    // header lengths from numpy.lib.format.write_array_header_1_0
+    assert( NPU::_make_header(s0, "<f4", false).size() == 192 );
+    assert( NPU::_make_header(s0, "<f4", true ).size() == 128 );
+    assert( NPU::_make_header(s1, "<f4", false).size() == 128 );
+    assert( NPU::_make_header(s1, "<f4", true ).size() == 192 );
+    std::cout << "test_growth_axis" << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    test_NPS_size();
+    test_v1_newline_in_HEADER_LEN();
+    test_v2();
+    test_growth_axis();
+    return 0 ;
+}
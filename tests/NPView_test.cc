@@ -0,0 +1,145 @@
+// name=NPView_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPView_test.cc
+================
+
+Compares NPView item, range, column and step slicing, transpose and
+reshape with the copying NP::spawn_item, NP::MakeItemCopy,
+NP::MakeSelectCopy and NP::slice and checks that a Fortran order .npy
+written as numpy does with np.asfortranarray and loaded with NP::LoadFortran indexes the same as the C order
+array without transposing on load::
+
+    python -c "import numpy as np ; a = np.load('/tmp/NPView_test/f.npy') ; print(a.flags.f_contiguous, a[1,2,3])"
+
+**/
+
+#include "NPView.h"
+
+const char* FOLD = "/tmp/NPView_test" ;
+
+void test_slicing()
+{
+    NP* a = NP::Make<float>(10, 4, 3) ;
+    a->fillIndexFlat();
+    NPView<float> v(a) ;
+    assert( v.is_contiguous() && v.size() == a->size );
+    assert( v(3,2,1) == a->get<float>(3,2,1) );
+
+    NP* i3 = a->spawn_item(3) ;
+    NP* m3 = v.item(3).materialize() ;
+    assert( NP::Memcmp(i3, m3) == 0 && m3->shape == i3->shape );
+
+    NP* i32 = NP::MakeItemCopy(a, 3, 2) ;
+    NP* m32 = v.item(3).item(2).materialize() ;
+    assert( NP::Memcmp(i32, m32) == 0 );
+    assert( v.item(-1)(0,0) == v(9,0,0) );
+
+    std::vector<float> out ;
+    a->slice(out, -1, 2, 1) ;                                   // a[:,2,1]
+    NPView<float> c = v.item_axis(1, 2).column(1) ;
+    assert( c.ndim() == 1 && c.shape[0] == 10 && c.strides[0] == 12 );
+    for(int i=0 ; i < 10 ; i++) assert( c(i) == out[i] );
+
+    NP* s = NP::MakeSelectCopy(a, 1, 3, 5, 7) ;              // a[1:9:2]
+    NPView<float> r = v.range(1, 9, 2) ;
+    assert( r.shape[0] == 4 && !r.is_contiguous() );
+    NP* rm = r.materialize() ;
+    assert( NP::Memcmp(s, rm) == 0 && rm->shape == s->shape );
+    assert( v.range(-3, 100).shape[0] == 3 && v.range(5, 2).size() == 0 );
+
+    v.item(0).column(2)(1) = -1.f ;                             // views write through
+    assert( a->get<float>(0,1,2) == -1.f );
+
+    const NP* ca = a ;
+    NPView<const float> cv(ca) ;
+    assert( cv(0,1,2) == -1.f );
+}
+
+void test_transpose_reshape()
+{
+    NP* a = NP::Make<int>(2, 3, 4) ;
+    a->fillIndexFlat();
+    NPView<int> v(a) ;
+
+    NPView<int> t = v.transpose() ;
+    assert( t.shape == std::vector<int>({4,3,2}) );
+    for(int i=0 ; i < 2 ; i++) for(int j=0 ; j < 3 ; j++) for(int k=0 ; k < 4 ; k++) assert( t(k,j,i) == v(i,j,k) );
+    NPView<int> t01 = v.transpose(0, -1) ;
+    assert( t01(3,1,0) == v(0,1,3) );
+
+    NPView<int> r = v.reshape({6,4}) ;
+    assert( r.valid() && r(4,1) == v(1,1,1) );
+
+    NPView<int> rr = v.range_axis(1, 0, 3, 2) ;                  // (2,2,4) strides (12,8,1)
+    assert( rr.reshape({2,8}).valid() == false );                // merging axes 1,2 needs stride 4
+    assert( rr.reshape({4,4}).valid() == false );                // merging axes 0,1 needs stride 16
+    assert( rr.reshape({2,2,2,2}).valid() && rr.reshape({2,2,2,2})(1,1,1,0) == rr(1,1,2) );
+
+    NPView<int> ri = v.item_axis(1, 1) ;                         // (2,4) stride (12,1)
+    NPView<int> rs = ri.reshape({2,2,2}) ;
+    assert( rs.valid() && rs(1,1,0) == ri(1,2) );
+    assert( !ri.reshape({8}).valid() );
+    assert( v.reshape({1,24,1}).valid() && v.reshape({1,24,1})(0,13,0) == 13 );
+
+    NPView<int> tt = t.reshape({4,6}) ;                          // transposed is not reshapeable
+    assert( !tt.valid() );
+    NP* tm = t.materialize() ;
+    NPView<int> tmv(tm) ;
+    assert( tmv.reshape({4,6}).valid() && tmv.reshape({4,6})(1,1) == t(1,0,1) );
+}
+
+/**
+test_fortran
+--------------
+
+Writes the payload of (2,3,4) array in column-major order with header
+fortran_order True, as np.save does for Fortran contiguous arrays.
+
+**/
+
+void test_fortran()
+{
+    NP* a = NP::Make<double>(2, 3, 4) ;
+    a->fillIndexFlat();
+    NPView<double> v(a) ;
+
+    std::vector<double> fdata(a->size) ;
+    v.transpose().copy_to(fdata.data()) ;                       // C order of transpose is F order
+
+    std::string path = U::form_path(FOLD, "f.npy") ;
+    U::MakeDirsForFile(path.c_str());
+    {
+        std::ofstream fp(path.c_str(), std::ios::out|std::ios::binary) ;
+        fp << NPU::_make_header(a->shape, a->dtype, true) ;
+        fp.write( (const char*)fdata.data(), a->arr_bytes() );
+    }
+
+    NP* f = NP::LoadFortran(path.c_str()) ;                   // NP::Load refuses fortran_order payloads
+    assert( f->fortran_order && f->shape == a->shape );
+    assert( memcmp(f->bytes(), fdata.data(), f->arr_bytes()) == 0 );   // not transposed on load
+    NPView<double> fv(f) ;
+    assert( !fv.is_contiguous() );
+    for(int i=0 ; i < 2 ; i++) for(int j=0 ; j < 3 ; j++) for(int k=0 ; k < 4 ; k++) assert( fv(i,j,k) == v(i,j,k) );
+    assert( fv.transpose().reshape({24}).valid() );
+
+    NP* fm = fv.item(1).materialize() ;
+    NP* i1 = a->spawn_item(1) ;
+    assert( !fm->fortran_order && NP::Memcmp(fm, i1) == 0 );
+
+    std::string rpath = U::form_path(FOLD, "f_resave.npy") ;
+    f->save(rpath.c_str()) ;                                    // layout kept on save
+    NP* g = NP::LoadFortran(rpath.c_str()) ;
+    assert( g->fortran_order && NP::Memcmp(f, g) == 0 );
+    assert( NP::LoadSlice(path.c_str(), 0, 1) == nullptr );
+
+    std::cout << fv.desc() << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    test_slicing();
+    test_transpose_reshape();
+    test_fortran();
+    std::cout << "NPView_test" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,109 @@
+// name=NPWriter_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NPWriter_test.cc
+==================
+
+Streams items into a .npy with NPWriter, checking the file is a valid
+.npy after a mid-run flush and that the final file matches the array
+created in memory. Also checks scalar items with an empty itemshape and
+that failed writes, provoked with a file size limit, are reported and
+leave a valid .npy holding only the items actually written.
+
+**/
+
+#include <csignal>
+#include <sys/resource.h>
+#include "NPWriter.h"
+
+const char* FOLD = "/tmp/NPWriter_test" ;
+
+struct hit { float pos[4] ; float mom[4] ; } ;
+
+void test_scalar()
+{
+    std::string path = U::form_path(FOLD, "scalar.npy") ;
+    NPWriter<double> w(path.c_str(), {} ) ;
+    assert( w.item_bytes == sizeof(double) );
+    for(int i=0 ; i < 100 ; i++)
+    {
+        double v = i ;
+        assert( w.add( &v ) == 0 );
+    }
+    assert( w.num_added() == 100 && w.close() == 0 );
+    NP* a = NP::Load(path.c_str()) ;
+    assert( a->shape.size() == 1 && a->shape[0] == 100 && a->get<double>(42) == 42. );
+    std::cout << "test_scalar " << a->sstr() << std::endl ;
+}
+
+void test_write_failure()
+{
+    std::string path = U::form_path(FOLD, "limited.npy") ;
+    std::signal(SIGXFSZ, SIG_IGN) ;
+    struct rlimit rl0 ;
+    getrlimit(RLIMIT_FSIZE, &rl0) ;
+
+    std::vector<float> vv(4*1000) ;
+    for(unsigned i=0 ; i < vv.size() ; i++) vv[i] = float(i) ;
+
+    NPWriter<float> w(path.c_str(), {4}, 1024 ) ;
+    assert( w.is_open() );
+    struct rlimit rl = rl0 ;
+    rl.rlim_cur = w.hdr_bytes + 100*16 + 7 ;      // room for 100 items and a partial one
+    setrlimit(RLIMIT_FSIZE, &rl) ;
+
+    int rc = 0 ;
+    int i = 0 ;
+    for( ; i < 1000 && rc == 0 ; i++) rc = w.add( vv.data() + 4*i ) ;
+    assert( rc != 0 && w.num_items <= 100 && w.num_items % 64 == 0 );
+    assert( w.flush() != 0 );                      // buffered items still do not fit
+
+    setrlimit(RLIMIT_FSIZE, &rl0) ;
+    std::signal(SIGXFSZ, SIG_DFL) ;
+    assert( w.num_added() == w.num_items + 64 );
+    assert( w.close() == 0 );                      // buffered items written once space allows
+
+    NP* a = NP::Load(path.c_str()) ;
+    assert( a->shape[0] == w.num_items && memcmp(a->bytes(), vv.data(), a->arr_bytes()) == 0 );
+    std::cout << "test_write_failure failed at item " << i << " " << a->sstr() << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    test_scalar();
+    test_write_failure();
+
+    std::string path = U::form_path(FOLD, "hit.npy") ;
+    const int N = 10000 ;
+
+    NP* x = NP::Make<float>(N, 2, 4) ;
+    float* xx = x->values<float>();
+    for(int i=0 ; i < N*8 ; i++) xx[i] = float(i) ;
+
+    NPWriter<float> w(path.c_str(), {2, 4}, 4096 ) ;
+    assert( w.is_open() );
+    w.set_meta<std::string>("creator", "NPWriter_test") ;
+
+    for(int i=0 ; i < N/2 ; i++) w.add( xx + i*8, 1 );   // single items
+    w.flush();
+
+    NP* a = NP::Load(path.c_str()) ;                      // valid .npy mid-run
+    assert( a->shape[0] == N/2 );
+    assert( memcmp( a->bytes(), x->bytes(), a->arr_bytes() ) == 0 );
+
+    std::vector<hit> hh(N/4) ;
+    memcpy( hh.data(), xx + (N/2)*8, sizeof(hit)*hh.size() );
+    w.add( hh );                                          // batch of structs
+    w.add( xx + (N/2 + N/4)*8, N/4 );                     // large batch bypasses buffer
+    assert( w.num_added() == N );
+    std::cout << w.desc() << std::endl ;
+    w.close();
+
+    NP* b = NP::Load(path.c_str()) ;
+    assert( b->shape == x->shape );
+    assert( NP::Memcmp(b, x) == 0 );
+    assert( b->get_meta<std::string>("creator", "").compare("NPWriter_test") == 0 );
+    assert( b->hdr_bytes() == x->make_header().size() );
+
+    std::cout << "NPWriter_test " << b->sstr() << std::endl ;
+    return 0 ;
+}
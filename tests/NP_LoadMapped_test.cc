@@ -0,0 +1,97 @@
+// name=NP_LoadMapped_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_LoadMapped_test.cc
+=======================
+
+Compares NP::LoadMapped and NPFold::LoadMapped with the standard loads,
+checks 64-byte alignment of the mapped payload, that writing into
+a mapped array does not change the file, that copies do not share the
+mapping and that saving over the mapped file is refused.
+
+**/
+
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NP_LoadMapped_test" ;
+
+void test_LoadMapped()
+{
+    NP* a = NP::Make<float>(100, 4, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<std::string>("creator", "NP_LoadMapped_test");
+    a->save(FOLD, "a.npy");
+
+    NP* b = NP::Load(FOLD, "a.npy");
+    NP* m = NP::LoadMapped(FOLD, "a.npy");
+
+    assert( b && !b->is_mapped() );
+    assert( m && m->is_mapped() );
+    assert( m->shape == a->shape );
+    assert( m->data.size() == 0 );
+    assert( (uintptr_t(m->bytes()) % NPU::ARRAY_ALIGN) == 0 );
+    assert( m->hdr_bytes() % NPU::ARRAY_ALIGN == 0 );
+    assert( NP::Memcmp(a, m) == 0 );
+    assert( m->get_meta<std::string>("creator", "").compare("NP_LoadMapped_test") == 0 );
+
+    NP* c = new NP(*m) ;         // copies do not share the mapping
+    assert( !c->is_mapped() && c->data.size() == a->arr_bytes() );
+    assert( NP::Memcmp(a, c) == 0 );
+    c->values<float>()[1] = -2.f ;
+    assert( m->cvalues<float>()[1] == 1.f );
+
+    NP e ;
+    e = *m ;
+    assert( !e.is_mapped() && NP::Memcmp(a, &e) == 0 );
+
+    float* mm = m->values<float>() ;
+    mm[0] = -1.f ;               // copy-on-write : file is not changed
+    NP* d = NP::Load(FOLD, "a.npy");
+    assert( d->cvalues<float>()[0] == 0.f );
+    assert( c->cvalues<float>()[0] == 0.f && e.cvalues<float>()[0] == 0.f );
+
+    std::string path = U::form_path(FOLD, "a.npy") ;
+    std::string alias = U::form_path(FOLD, "../NP_LoadMapped_test/a.npy") ;
+    assert( m->is_mapped_file(path.c_str()) && m->is_mapped_file(alias.c_str()) );
+    assert( m->save_(alias.c_str()) == 1 );            // refused : would truncate beneath the mapping
+    assert( mm[1] == 1.f );
+    m->save(FOLD, "m.npy");                            // elsewhere is fine
+    NP* lm = NP::Load(FOLD, "m.npy");
+    assert( lm->cvalues<float>()[0] == -1.f );
+
+    NP mv(std::move(*m)) ;
+    assert( mv.is_mapped() && !m->is_mapped() && mv.cvalues<float>()[0] == -1.f );
+    delete m ;
+
+    mv.clear();
+    assert( !mv.is_mapped() );
+
+    std::cout << "test_LoadMapped " << a->sstr() << " hdr_bytes " << a->hdr_bytes() << std::endl ;
+}
+
+void test_NPFold_LoadMapped()
+{
+    NPFold* f = new NPFold ;
+    f->add("a", NP::Linspace<double>(0., 1., 11) );
+    NPFold* sub = new NPFold ;
+    sub->add("b", NP::Make<int>(10, 4) );
+    f->add_subfold("sub", sub );
+    f->save(FOLD, "fold");
+
+    NPFold* m = NPFold::LoadMapped(FOLD, "fold");
+    const NP* ma = m->get("a");
+    const NP* mb = m->find_array("sub/b.npy");
+
+    assert( ma && ma->is_mapped() );
+    assert( mb && mb->is_mapped() );
+    assert( NP::Memcmp(ma, f->get("a")) == 0 );
+    assert( NP::Memcmp(mb, sub->get("b")) == 0 );
+
+    std::cout << "test_NPFold_LoadMapped" << std::endl << m->desc() << std::endl ;
+}
+
+int main(int argc, char** argv)
+{
+    test_LoadMapped();
+    test_NPFold_LoadMapped();
+    return 0 ;
+}
@@ -0,0 +1,67 @@
+// name=NP_LoadSlice_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_LoadSlice_test.cc
+======================
+
+Compares items read with NP::LoadSlice against MakeItemCopy of the fully loaded array
+and checks that 0-d files, which have no items, are rejected. 
+
+**/
+
+#include "NP.hh"
+
+const char* FOLD = "/tmp/NP_LoadSlice_test" ;
+
+void check_slice(const NP* a, int i0, int i1)
+{
+    NP* s = NP::LoadSlice(FOLD, "a.npy", i0, i1 );
+    assert( s );
+    int ni = a->shape[0] ;
+    int j0 = i0 < 0 ? ni + i0 : i0 ;
+    int j1 = i1 < 0 ? ni + i1 : i1 ;
+
+    assert( s->shape[0] == j1 - j0 );
+    for(unsigned d=1 ; d < a->shape.size() ; d++) assert( s->shape[d] == a->shape[d] );
+    assert( int(s->names.size()) == j1 - j0 );
+    assert( s->get_meta<int>("answer") == 42 );
+
+    for(int i=j0 ; i < j1 ; i++)
+    {
+        NP* item = NP::MakeItemCopy(a, i) ;
+        assert( memcmp( item->bytes(), s->bytes() + (i-j0)*s->item_bytes(), s->item_bytes() ) == 0 );
+        assert( s->names[i-j0] == a->names[i] );
+        delete item ;
+    }
+    std::cout << "check_slice (" << i0 << "," << i1 << ") " << s->sstr() << std::endl ;
+    delete s ;
+}
+
+int main(int argc, char** argv)
+{
+    NP* a = NP::Make<double>(1000, 4, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<int>("answer", 42);
+    for(int i=0 ; i < a->shape[0] ; i++) a->names.push_back( "item" + std::to_string(i) );
+    a->save(FOLD, "a.npy");
+
+    check_slice(a, 7, 8 );
+    check_slice(a, 0, 10 );
+    check_slice(a, 990, 1000 );
+    check_slice(a, -10, -1 );
+    check_slice(a, 500, 500 );
+
+    assert( NP::LoadSlice(FOLD, "a.npy", 10, 1001) == nullptr );
+
+    std::string zpath = U::form_path(FOLD, "z.npy") ;   // 0-d as from np.save(np.array(3.5,dtype=np.float32))
+    std::ofstream fz(zpath.c_str(), std::ios::out|std::ios::binary) ;
+    float z = 3.5f ;
+    fz << NPU::_make_header(std::vector<int>(), "<f4") ;
+    fz.write( (const char*)&z, sizeof(float) ) ;
+    fz.close();
+    NP* lz = NP::Load(zpath.c_str()) ;
+    assert( lz && lz->shape.empty() );
+    assert( NP::LoadSlice(zpath.c_str(), 0, 0) == nullptr );
+    assert( NP::LoadSlice(zpath.c_str(), 0, 1) == nullptr );
+
+    return 0 ;
+}
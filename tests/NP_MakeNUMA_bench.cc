@@ -0,0 +1,110 @@
+// name=NP_MakeNUMA_bench ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_MakeNUMA_bench.cc
+======================
+
+Compares the bandwidth of a multithreaded sweep over arrays created by
+NP::Make (all pages touched by one thread) and NP::MakeNUMA with
+first-touch and interleave placement. On dual socket nodes run with
+the shape of NPBigTest.cc and one thread per core, eg::
+
+    NI=24 NJ=4096 NK=4096 NP_THREADS=64 numactl --cpunodebind=0,1 /tmp/NP_MakeNUMA_bench/NP_MakeNUMA_bench
+
+On a single NUMA node the three should give similar bandwidth.
+Also checks the parallel fill, fillIndexFlat and read against the
+serial versions and that item ranges are processed on the same CPU
+by repeated NP::for_each_item_range calls.
+
+**/
+
+#include <chrono>
+#include "NP.hh"
+
+double sweep(const NP* a, int num_threads, int repeat, double& total)
+{
+    const double* vv = a->cvalues<double>() ;
+    int64_t nv = a->size/a->shape[0] ;
+    std::vector<double> part(a->shape[0], 0.) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int r=0 ; r < repeat ; r++)
+    {
+        a->for_each_item_range( [vv, nv, &part](int64_t i0, int64_t i1){
+            for(int64_t i=i0 ; i < i1 ; i++)
+            {
+                double s = 0. ;
+                for(int64_t j=i*nv ; j < (i+1)*nv ; j++) s += vv[j] ;
+                part[i] = s ;
+            }
+        }, num_threads );
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    total = 0. ;
+    for(unsigned i=0 ; i < part.size() ; i++) total += part[i] ;
+    double secs = std::chrono::duration<double>(t1 - t0).count() ;
+    return double(a->arr_bytes())*repeat/secs/1e9 ;   // GB/s
+}
+
+void check_parallel(int num_threads)
+{
+    NP* a = NP::Make<float>(1001, 7) ;
+    NP* b = NP::Make<float>(1001, 7) ;
+    a->fill<float>(3.f) ;
+    b->fill_parallel<float>(3.f, num_threads) ;
+    assert( NP::Memcmp(a, b) == 0 );
+
+    a->_fillIndexFlat<float>(1.f) ;
+    b->_fillIndexFlat_parallel<float>(1.f, num_threads) ;
+    assert( NP::Memcmp(a, b) == 0 );
+
+    NP* c = NP::MakeNUMA<float>(NP::NUMA_FIRST_TOUCH, {1001, 7}, num_threads ) ;
+    c->read_parallel<float>( a->cvalues<float>(), num_threads ) ;
+    assert( NP::Memcmp(a, c) == 0 );
+
+    NP* z = NP::MakeNUMA<double>(NP::NUMA_INTERLEAVE, {10, 3}, num_threads ) ;
+    for(int i=0 ; i < 30 ; i++) assert( z->cvalues<double>()[i] == 0. );
+
+    std::vector<int> cpu0(1001, -1), cpu1(1001, -1) ;   // item ranges stay on the same CPU
+    a->for_each_item_range( [&cpu0](int64_t i0, int64_t i1){ for(int64_t i=i0 ; i < i1 ; i++) cpu0[i] = sched_getcpu() ; }, num_threads );
+    a->for_each_item_range( [&cpu1](int64_t i0, int64_t i1){ for(int64_t i=i0 ; i < i1 ; i++) cpu1[i] = sched_getcpu() ; }, num_threads );
+    if( num_threads > 1 ) assert( cpu0 == cpu1 );
+}
+
+int main(int argc, char** argv)
+{
+    int ni = U::GetEnvInt("NI", 24) ;
+    int nj = U::GetEnvInt("NJ", 512) ;
+    int nk = U::GetEnvInt("NK", 512) ;
+    int repeat = U::GetEnvInt("REPEAT", 5) ;
+    int num_threads = UPool::NumThreads() ;
+
+    check_parallel(num_threads);
+
+    std::cout
+        << "NP_MakeNUMA_bench"
+        << " shape (" << ni << "," << nj << "," << nk << ")"
+        << " num_threads " << num_threads
+        << " NUMANodeMask " << std::hex << NP::NUMANodeMask() << std::dec
+        << std::endl
+        ;
+
+    const char* label[3] = { "NP::Make", "MakeNUMA FIRST_TOUCH", "MakeNUMA INTERLEAVE" } ;
+    double total[3] ;
+    for(int m=0 ; m < 3 ; m++)
+    {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        NP* a = m == 0 ? NP::Make<double>(ni, nj, nk) : NP::MakeNUMA<double>( m == 1 ? NP::NUMA_FIRST_TOUCH : NP::NUMA_INTERLEAVE, {ni, nj, nk}, num_threads ) ;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        a->_fillIndexFlat_parallel<double>(0., num_threads) ;
+        double gbs = sweep(a, num_threads, repeat, total[m] ) ;
+        std::cout
+            << std::setw(25) << label[m]
+            << " make " << std::setw(10) << std::fixed << std::setprecision(4) << std::chrono::duration<double>(t1 - t0).count() << " s "
+            << " sweep " << std::setw(10) << std::setprecision(2) << gbs << " GB/s"
+            << std::endl
+            ;
+        delete a ;
+    }
+    assert( total[0] == total[1] && total[1] == total[2] );
+    return 0 ;
+}
@@ -0,0 +1,106 @@
+// name=NP_MakeUninitialized_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_MakeUninitialized_test.cc
+==============================
+
+Checks 64-byte alignment of NP payloads from NPAlloc, explicit alignment
+with NP::set_align, that NP::Make still zeros while
+NP::MakeUninitialized does not need to and that the copying methods
+which no longer zero first give the same results.
+
+**/
+
+#include "NP.hh"
+
+bool aligned(const NP* a, size_t align){ return (uintptr_t(a->bytes()) % align) == 0 ; }
+
+void test_alignment()
+{
+    for(int n=1 ; n < 1000 ; n += 37)
+    {
+        NP* a = NP::Make<float>(n, 3) ;
+        NP* b = NP::MakeUninitialized<double>(n) ;
+        assert( aligned(a, NPAlloc<char>::ALIGN) );
+        assert( aligned(b, NPAlloc<char>::ALIGN) );
+        assert( b->shape.size() == 1 && b->shape[0] == n );
+        assert( b->arr_bytes() == sizeof(double)*n );
+        delete a ;
+        delete b ;
+    }
+    NP* h = new NP("<f4") ;
+    h->set_align(NPAlloc<char>::HUGE_ALIGN) ;
+    h->set_shape(1024, 1024) ;                           // 4 MiB
+    assert( aligned(h, NPAlloc<char>::HUGE_ALIGN) );
+
+    NP* s = new NP("<f4") ;                              // small explicit alignment applies to all sizes
+    s->set_align(4096) ;
+    s->set_shape(3) ;
+    assert( aligned(s, 4096) );
+    s->fillIndexFlat();
+    s->set_align(NPAlloc<char>::HUGE_ALIGN) ;            // realigning keeps the payload
+    assert( aligned(s, NPAlloc<char>::HUGE_ALIGN) && s->cvalues<float>()[2] == 2.f );
+
+    NP* c = NP::MakeCopy(s) ;
+    NP::Data d = c->data ;
+    assert( d.size() == s->arr_bytes() );
+    std::cout << "test_alignment HugePages " << NPAlloc<char>::HugePages() << std::endl ;
+}
+
+void test_zero()
+{
+    NP* d = NP::MakeUninitialized<int>(1000, 4) ;        // dirty some heap
+    d->fill<int>(-1) ;
+    delete d ;
+
+    NP* a = NP::Make<int>(1000, 4) ;
+    const int* aa = a->cvalues<int>() ;
+    for(int i=0 ; i < 4000 ; i++) assert( aa[i] == 0 );
+}
+
+void test_copies()
+{
+    NP* a = NP::Make<double>(10, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<int>("m", 1) ;
+
+    NP* b = NP::MakeCopy(a) ;
+    assert( NP::Memcmp(a, b) == 0 && b->meta == a->meta );
+
+    NP* n = NP::MakeNarrow(a) ;
+    NP* w = NP::MakeWide(n) ;
+    assert( NP::Memcmp(a, w) == 0 );
+
+    NP* x = NP::Make<int64_t>(5) ;
+    x->fillIndexFlat();
+    NP* xn = NP::MakeNarrow(x) ;                         // integer narrowing is not converted : zeros as before
+    for(int i=0 ; i < 5 ; i++) assert( xn->cvalues<int>()[i] == 0 );
+
+    NP* c0 = NP::MakeCopy(a) ;
+    NP* c1 = NP::MakeCopy(a) ;
+    std::vector<NP*> cc = { c0, c1 } ;
+    NP* c = NP::Concatenate(cc) ;
+    assert( c->shape[0] == 20 );
+    assert( memcmp(c->bytes(), a->bytes(), a->arr_bytes()) == 0 );
+    assert( memcmp(c->bytes() + a->arr_bytes(), a->bytes(), a->arr_bytes()) == 0 );
+    assert( aligned(c, NPAlloc<char>::ALIGN) );
+}
+
+void test_load()
+{
+    NP* a = NP::Make<float>(100, 4) ;
+    a->fillIndexFlat();
+    a->save("/tmp/NP_MakeUninitialized_test/a.npy") ;
+    NP* b = NP::Load("/tmp/NP_MakeUninitialized_test/a.npy") ;
+    assert( NP::Memcmp(a, b) == 0 );
+    assert( aligned(b, NPAlloc<char>::ALIGN) );
+}
+
+int main(int argc, char** argv)
+{
+    test_alignment();
+    test_zero();
+    test_copies();
+    test_load();
+    std::cout << "NP_MakeUninitialized_test" << std::endl ;
+    return 0 ;
+}
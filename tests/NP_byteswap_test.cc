@@ -0,0 +1,136 @@
+// name=NP_byteswap_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_byteswap_test.cc
+=====================
+
+Writes big-endian '>f8' '>f4' '>i2' and '>u8' arrays as numpy does with
+arr.astype('>f8') and checks that NP::Load, NP::LoadSlice, NP::LoadMapped
+and nodata loads followed by NP::load_data give native arrays, that
+with NP_KEEP_FOREIGN the payload is kept and NP::to_native swaps later,
+and that NPU::_byteswap matches __builtin_bswap at all offsets and
+lengths. Reports the swap bandwidth. Build with -march=native to use
+the AVX2/SSSE3 kernels rather than SSE2.
+
+**/
+
+#include <chrono>
+#include "NP.hh"
+
+const char* FOLD = "/tmp/NP_byteswap_test" ;
+
+template<typename T, typename W>
+void write_foreign(const NP* a, const char* path)
+{
+    std::string descr = ">" + NPU::_make_descr(true, a->uifc, a->ebyte).substr(1) ;
+    std::string hdr = NPU::_make_header(a->shape, descr.c_str()) ;
+    std::vector<W> buf(a->size) ;
+    memcpy(buf.data(), a->bytes(), a->arr_bytes()) ;
+    for(unsigned i=0 ; i < buf.size() ; i++)
+    {
+        if(sizeof(W) == 2) buf[i] = __builtin_bswap16(buf[i]) ;
+        if(sizeof(W) == 4) buf[i] = __builtin_bswap32(buf[i]) ;
+        if(sizeof(W) == 8) buf[i] = __builtin_bswap64(buf[i]) ;
+    }
+    U::MakeDirsForFile(path);
+    std::ofstream fp(path, std::ios::out|std::ios::binary) ;
+    fp << hdr ;
+    fp.write( (const char*)buf.data(), a->arr_bytes() );
+}
+
+template<typename T, typename W>
+void test_load(int ni, int nj)
+{
+    NP* a = NP::Make<T>(ni, nj) ;
+    a->fillIndexFlat();
+    a->set_meta<std::string>("creator", "NP_byteswap_test") ;
+    std::string path = U::form_path(FOLD, (std::string("a_") + a->dtype + ".npy").c_str() ) ;
+    write_foreign<T,W>(a, path.c_str()) ;
+    a->save_meta(path.c_str()) ;
+
+    NP* b = NP::Load(path.c_str()) ;
+    assert( b->is_native() && strcmp(b->dtype, a->dtype) == 0 );
+    assert( NP::Memcmp(a, b) == 0 && b->meta == a->meta );
+
+    NP* s = NP::LoadSlice(path.c_str(), 1, 3) ;
+    assert( s->is_native() && memcmp(s->bytes(), a->bytes() + a->ebyte*nj, s->arr_bytes()) == 0 );
+
+    NP* m = NP::LoadMapped(path.c_str()) ;
+    assert( m->is_native() && NP::Memcmp(a, m) == 0 );
+
+    NP* n = NP::Load(NP::PathWithNoDataPrefix(path.c_str())) ;
+    assert( n->nodata && n->dtype[0] == '>' );
+    assert( n->load_data() == 0 && n->is_native() && NP::Memcmp(a, n) == 0 );
+    n->release_data();
+    assert( n->load_data() == 0 && NP::Memcmp(a, n) == 0 );     // file remains foreign
+
+    setenv(NP::NP_KEEP_FOREIGN, "1", 1) ;
+    NP* k = NP::Load(path.c_str()) ;
+    unsetenv(NP::NP_KEEP_FOREIGN) ;
+    assert( !k->is_native() && k->dtype[0] == '>' );
+    assert( ni*nj < 2 || NP::Memcmp(a, k) != 0 );
+    std::string kpath = U::form_path(FOLD, (std::string("k_") + a->dtype + ".npy").c_str() ) ;
+    k->save(kpath.c_str()) ;                                      // still foreign on disk
+    assert( k->to_native() == 0 && NP::Memcmp(a, k) == 0 && k->make_header() == a->make_header() );
+    NP* kl = NP::Load(kpath.c_str()) ;
+    assert( NP::Memcmp(a, kl) == 0 );
+
+    std::cout << "test_load " << a->dtype << " " << a->sstr() << std::endl ;
+}
+
+template<typename W>
+void test_kernel()
+{
+    std::vector<W> v(1000) ;
+    for(unsigned i=0 ; i < v.size() ; i++) v[i] = W(i*0x0102030405060708ull + 0x1122334455667788ull) ;
+    for(int off=0 ; off < 8 ; off++)
+    for(int n=0 ; n < 70 ; n++)
+    {
+        std::vector<char> buf(off + n*sizeof(W)) ;
+        memcpy(buf.data() + off, v.data(), n*sizeof(W)) ;
+        NPU::_byteswap(buf.data() + off, n, sizeof(W)) ;
+        for(int i=0 ; i < n ; i++)
+        {
+            W x ;
+            memcpy(&x, buf.data() + off + i*sizeof(W), sizeof(W)) ;
+            W y = sizeof(W) == 2 ? W(__builtin_bswap16(v[i])) : ( sizeof(W) == 4 ? W(__builtin_bswap32(v[i])) : W(__builtin_bswap64(v[i])) ) ;
+            assert( x == y );
+        }
+    }
+}
+
+void test_timing()
+{
+    int ni = U::GetEnvInt("NI", 1000000) ;
+    NP* a = NP::Make<double>(ni, 4) ;
+    a->fillIndexFlat();
+    auto t0 = std::chrono::high_resolution_clock::now();
+    NPU::_byteswap( a->bytes(), a->size, 8 ) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    a->_byteswap() ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    const double* aa = a->cvalues<double>() ;
+    for(int i=0 ; i < 100 ; i++) assert( aa[i] == double(i) );
+    double gb = a->arr_bytes()/1e9 ;
+    std::cout
+        << "test_timing arr_bytes " << a->arr_bytes()
+        << " NPU::_byteswap " << gb/std::chrono::duration<double>(t1 - t0).count() << " GB/s"
+        << " NP::_byteswap " << gb/std::chrono::duration<double>(t2 - t1).count() << " GB/s"
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_kernel<uint16_t>();
+    test_kernel<uint32_t>();
+    test_kernel<uint64_t>();
+
+    test_load<double,   uint64_t>(10, 4);
+    test_load<float,    uint32_t>(7, 3);
+    test_load<int16_t,  uint16_t>(5, 9);
+    test_load<uint64_t, uint64_t>(3, 1);
+
+    test_timing();
+    std::cout << "NP_byteswap_test" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,166 @@
+// name=NP_combined_interp_many_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_combined_interp_many_test.cc
+=================================
+
+Checks that NP::combined_interp_many gives bitwise the same values as one
+NP::combined_interp_3 or NP::combined_interp_5 call per query for
+NP::Combine arrays of ragged properties, with random and with sorted x
+and with queries in random item order or runs of the same item,
+including properties with a single value,
+and times the batch against per-query calls.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NP.hh"
+
+std::mt19937_64 rng(5) ;
+
+template<typename T>
+NP* make_prop(int ni)
+{
+    NP* a = NP::Make<T>(ni, 2) ;
+    T* aa = a->values<T>() ;
+    std::uniform_real_distribution<T> u(0, 1) ;
+    T d = T(1.5) ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        aa[2*i+0] = d ;
+        aa[2*i+1] = T(1) + u(rng) ;
+        d += u(rng) ;
+    }
+    return a ;
+}
+
+template<typename T>
+NP* make_combined(int num)
+{
+    std::vector<const NP*> aa ;
+    for(int i=0 ; i < num ; i++) aa.push_back( make_prop<T>( 2 + rng() % 30 ) ) ;
+    return NP::Combine(aa) ;
+}
+
+template<typename T>
+void test_3(int n, bool sorted, bool runs)
+{
+    int num = 7 ;
+    NP* a = make_combined<T>(num) ;
+    std::uniform_real_distribution<T> u(0, 35) ;
+    std::vector<int> idx(n) ;
+    std::vector<T> x(n), y(n) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        idx[q] = runs ? (q*num)/n : rng() % num ;
+        x[q] = u(rng) ;
+    }
+    if(sorted) std::sort(x.begin(), x.end()) ;
+
+    a->combined_interp_many<T>(idx.data(), x.data(), y.data(), n, 3 ) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        T y0 = a->combined_interp_3<T>(idx[q], x[q]) ;
+        assert( memcmp(&y0, &y[q], sizeof(T)) == 0 );
+    }
+
+    NP* yy = a->combined_interp_many<T>(idx.data(), x.data(), n ) ;
+    assert( yy->shape[0] == n && memcmp(yy->bytes(), y.data(), n*sizeof(T)) == 0 );
+    std::cout << "test_3 " << a->sstr() << " " << a->dtype << " n " << n << " sorted " << sorted << " runs " << runs << std::endl ;
+}
+
+void test_5(int n)
+{
+    std::vector<const NP*> aa ;
+    for(int i=0 ; i < 3*4*2 ; i++) aa.push_back( make_prop<double>( 2 + rng() % 20 ) ) ;
+    NP* c = NP::Combine(aa) ;
+    c->change_shape(3, 4, 2, c->shape[1], 2) ;
+
+    std::uniform_real_distribution<double> u(0, 25) ;
+    std::vector<int> idx(3*n) ;
+    std::vector<double> x(n), y(n) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        idx[3*q+0] = rng() % 3 ;
+        idx[3*q+1] = rng() % 4 ;
+        idx[3*q+2] = rng() % 2 ;
+        x[q] = u(rng) ;
+    }
+    c->combined_interp_many<double>(idx.data(), x.data(), y.data(), n ) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        double y0 = c->combined_interp_5<double>(idx[3*q+0], idx[3*q+1], idx[3*q+2], x[q]) ;
+        assert( memcmp(&y0, &y[q], sizeof(double)) == 0 );
+    }
+    std::cout << "test_5 " << c->sstr() << std::endl ;
+}
+
+void test_single_value()
+{
+    std::vector<const NP*> aa ;
+    aa.push_back( make_prop<double>(1) ) ;
+    aa.push_back( make_prop<double>(5) ) ;
+    NP* a = NP::Combine(aa) ;
+    int n = 1000 ;
+    std::uniform_real_distribution<double> u(0, 8) ;
+    std::vector<int> idx(n) ;
+    std::vector<double> x(n), y(n) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        idx[q] = rng() % 2 ;
+        x[q] = u(rng) ;
+    }
+    for(int sorted=0 ; sorted < 2 ; sorted++)
+    {
+        if(sorted) std::sort(x.begin(), x.end()) ;
+        a->combined_interp_many<double>(idx.data(), x.data(), y.data(), n ) ;
+        for(int q=0 ; q < n ; q++)
+        {
+            double y0 = a->combined_interp_3<double>(idx[q], x[q]) ;
+            assert( memcmp(&y0, &y[q], sizeof(double)) == 0 );
+            assert( idx[q] != 0 || y[q] == aa[0]->get<double>(0, 1) );
+        }
+    }
+    std::cout << "test_single_value " << a->sstr() << std::endl ;
+}
+
+void test_timing()
+{
+    int n = U::GetEnvInt("NUM_Q", 2000000) ;
+    NP* a = make_combined<double>(20) ;
+    std::uniform_real_distribution<double> u(1.5, 10) ;   // mostly within the domains
+    std::vector<int> idx(n) ;
+    std::vector<double> x(n), y0(n), y1(n) ;
+    for(int q=0 ; q < n ; q++)
+    {
+        idx[q] = rng() % 4 ;      // same few properties for many photons
+        x[q] = u(rng) ;
+    }
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int q=0 ; q < n ; q++) y0[q] = a->combined_interp_3<double>(idx[q], x[q]) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    a->combined_interp_many<double>(idx.data(), x.data(), y1.data(), n ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    assert( y0 == y1 );
+    std::cout
+        << "test_timing n " << n << " " << a->sstr()
+        << " combined_interp_3 " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " combined_interp_many " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_3<double>(10000, false, false);
+    test_3<double>(10000, true, false);
+    test_3<float>(10000, true, true);
+    test_3<float>(300000, false, true);
+    test_3<double>(1, false, false);
+    test_3<double>(0, false, false);
+    test_5(10000);
+    test_single_value();
+    test_timing();
+    std::cout << "NP_combined_interp_many_test" << std::endl ;
+    return 0 ;
+}
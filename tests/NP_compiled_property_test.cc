@@ -0,0 +1,122 @@
+// name=NP_compiled_property_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_compiled_property_test.cc
+==============================
+
+Compiles a pshaped property and an NP::Combine stack of ragged properties
+with NP::MakeCompiledProperty and checks that NP::compiled_interp is within
+the tolerance of NP::interp and NP::combined_interp_3 for random x inside
+and beyond the domains, that NP::compiled_interp_many matches
+NP::compiled_interp bit for bit, and that the compiled array saved in an NPFold
+next to its source loads the same. Times lookups against NP::interp.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NPFold.h"
+
+std::mt19937_64 rng(3) ;
+
+template<typename T>
+NP* make_prop(int ni, T x0, T x1)
+{
+    NP* a = NP::Make<T>(ni, 2) ;
+    T* aa = a->values<T>() ;
+    std::uniform_real_distribution<T> u(0, 1) ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        T t = T(i)/T(ni-1) ;
+        aa[2*i+0] = x0 + (x1 - x0)*t*(T(1.3) - T(0.3)*t) ;        // irregular domain
+        aa[2*i+1] = T(1.3) + T(0.8)*t*(1-t)*(T(0.5)-t) + T(0.0001)*u(rng) ;   // slightly noisy
+    }
+    return a ;
+}
+
+template<typename T>
+void test_pshaped(T tol)
+{
+    NP* a = make_prop<T>(40, T(1.5), T(15.5)) ;
+    NP* c = NP::MakeCompiledProperty<T>(a, tol) ;
+    T max_err = c->get_meta<T>("compiled_max_err", -1) ;
+    assert( max_err >= 0 && max_err <= tol );
+
+    int n = 100000 ;
+    std::uniform_real_distribution<T> u(0, 17) ;
+    std::vector<T> x(n), y(n) ;
+    for(int i=0 ; i < n ; i++) x[i] = u(rng) ;
+    c->compiled_interp_many<T>(0, x.data(), y.data(), n, 2 ) ;
+
+    T err = 0 ;
+    for(int i=0 ; i < n ; i++)
+    {
+        T y0 = c->compiled_interp<T>(0, x[i]) ;
+        assert( memcmp(&y0, &y[i], sizeof(T)) == 0 );
+        err = std::max( err, T(std::abs(y0 - a->interp<T>(x[i]))) ) ;
+    }
+    assert( err <= tol*T(1.001) );
+    assert( std::abs( c->compiled_interp<T>(0, T(0)) - a->interp<T>(T(0)) ) <= tol );   // clamped to edge
+    std::cout << "test_pshaped " << a->dtype << " tol " << tol << " " << c->sstr() << " max_err " << max_err << " random err " << err << std::endl ;
+}
+
+void test_combined()
+{
+    std::vector<const NP*> aa = { make_prop<double>(10, 1.5, 15.5), make_prop<double>(35, 1.6, 15.0), make_prop<double>(2, 1.0, 16.0) } ;
+    NP* com = NP::Combine(aa) ;
+    double tol = 1e-4 ;
+    NP* c = NP::MakeCompiledProperty<double>(com, tol) ;
+    assert( c->shape[0] == 3 && c->shape[2] == 2 );
+
+    std::uniform_real_distribution<double> u(0, 17) ;
+    for(int p=0 ; p < 3 ; p++)
+    for(int i=0 ; i < 10000 ; i++)
+    {
+        double x = u(rng) ;
+        double y0 = com->combined_interp_3<double>(p, x) ;
+        double y1 = c->compiled_interp<double>(p, x) ;
+        assert( std::abs(y0 - y1) <= tol*1.001 );
+    }
+
+    NPFold* f = new NPFold ;
+    f->add("RINDEX", com ) ;
+    f->add("RINDEX_compiled", c ) ;
+    f->save("/tmp/NP_compiled_property_test/fold") ;
+    NPFold* g = NPFold::Load("/tmp/NP_compiled_property_test/fold") ;
+    const NP* gc = g->get("RINDEX_compiled") ;
+    assert( NP::Memcmp(c, gc) == 0 && gc->get_meta<int>("compiled_max_cells", 0) == c->shape[1] - 2 );
+    assert( gc->compiled_interp<double>(1, 7.5) == c->compiled_interp<double>(1, 7.5) );
+    std::cout << "test_combined " << com->sstr() << " -> " << c->sstr() << std::endl << c->meta << std::endl ;
+}
+
+void test_timing()
+{
+    int n = U::GetEnvInt("NUM_X", 4000000) ;
+    NP* a = make_prop<double>(500, 1.5, 15.5) ;
+    NP* c = NP::MakeCompiledProperty<double>(a, 1e-4) ;
+    std::uniform_real_distribution<double> u(1, 16) ;
+    std::vector<double> x(n), y0(n), y1(n) ;
+    for(int i=0 ; i < n ; i++) x[i] = u(rng) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < n ; i++) y0[i] = a->interp<double>(x[i]) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    c->compiled_interp_many<double>(0, x.data(), y1.data(), n, 1 ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::cout
+        << "test_timing n " << n << " " << a->sstr() << " -> " << c->sstr()
+        << " interp " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " compiled_interp_many(1 thread) " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_pshaped<double>(1e-5);
+    test_pshaped<float>(1e-3f);
+    test_combined();
+    test_timing();
+    std::cout << "NP_compiled_property_test" << std::endl ;
+    return 0 ;
+}
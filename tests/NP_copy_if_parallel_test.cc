@@ -0,0 +1,111 @@
+// name=NP_copy_if_parallel_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_copy_if_parallel_test.cc
+=============================
+
+Checks that the template predicate NP::count_if NP::copy_if NP::simple_copy_if
+give the same arrays as the std::function predicate versions for any
+num_threads, keeping input order, that the returned indices are those of the
+selected items, and times the std::function and template predicate copy_if.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NP.hh"
+
+struct quad4 { float q[16] ; } ;     // photon-like item of 16 floats
+
+struct quad4_selector
+{
+    float cut ;
+    bool operator()(const quad4* p) const { return p->q[15] < cut ; }
+};
+
+NP* make_photons(int ni)
+{
+    NP* a = NP::Make<float>(ni, 4, 4) ;
+    float* aa = a->values<float>() ;
+    std::mt19937_64 rng(1) ;
+    std::uniform_real_distribution<float> u(0, 1) ;
+    for(int64_t i=0 ; i < a->size ; i++) aa[i] = u(rng) ;
+    return a ;
+}
+
+void test_copy_if(int ni, float cut)
+{
+    NP* a = make_photons(ni) ;
+    quad4_selector sel = { cut } ;
+    std::function<bool(const quad4*)> fsel = sel ;
+
+    NP* b0 = a->copy_if<float,quad4>(fsel) ;
+    int n0 = a->count_if<quad4>(fsel) ;
+    assert( b0->shape[0] == n0 && b0->shape[1] == 4 && b0->shape[2] == 4 );
+
+    for(int nt=0 ; nt <= 4 ; nt++)
+    {
+        std::vector<int64_t> idx ;
+        NP* b = a->copy_if<float,quad4>(sel, nt, &idx) ;
+        assert( NP::Memcmp(b0, b) == 0 && strcmp(b->dtype, b0->dtype) == 0 && b->shape == b0->shape );
+        assert( a->count_if<quad4>(sel, nt) == n0 );
+        assert( int(idx.size()) == n0 );
+        for(int k=0 ; k < n0 ; k++)
+        {
+            assert( k == 0 || idx[k] > idx[k-1] );
+            assert( memcmp( a->cvalues<quad4>() + idx[k], b->cvalues<quad4>() + k, sizeof(quad4)) == 0 );
+        }
+        delete b ;
+    }
+
+    NP* f = a->flexible_copy_if<float,quad4>(fsel, 16) ;
+    assert( f->shape[0] == n0 && f->shape[1] == 16 && memcmp(f->bytes(), b0->bytes(), b0->arr_bytes()) == 0 );
+    std::cout << "test_copy_if " << a->sstr() << " cut " << cut << " -> " << b0->sstr() << std::endl ;
+}
+
+void test_simple_copy_if()
+{
+    NP* a = NP::ARange<int>(0, 300000, 1) ;
+    auto odd = [](const int* p){ return (*p & 1) == 1 ; } ;
+    NP* b0 = a->simple_copy_if<int>( std::function<bool(const int*)>(odd) ) ;
+    std::vector<int64_t> idx ;
+    NP* b1 = a->simple_copy_if<int>( odd, 0, &idx ) ;
+    assert( NP::Memcmp(b0, b1) == 0 && b1->shape[0] == 150000 );
+    assert( idx[0] == 1 && idx[149999] == 299999 && b1->cvalues<int>()[7] == 15 );
+    std::cout << "test_simple_copy_if " << b1->sstr() << std::endl ;
+}
+
+void test_timing()
+{
+    int ni = U::GetEnvInt("NUM_PHOTON", 4000000) ;
+    NP* a = make_photons(ni) ;
+    quad4_selector sel = { 0.1f } ;
+    std::function<bool(const quad4*)> fsel = sel ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    NP* b0 = a->copy_if<float,quad4>(fsel) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    NP* b1 = a->copy_if<float,quad4>(sel) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    NP* b2 = a->copy_if<float,quad4>(sel, 0) ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    assert( NP::Memcmp(b0, b1) == 0 && NP::Memcmp(b0, b2) == 0 );
+    std::cout
+        << "test_timing " << a->sstr() << " -> " << b0->sstr()
+        << " std::function " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " template " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << " template(" << UPool::NumThreads() << " threads) " << std::chrono::duration<double>(t3 - t2).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_copy_if(1000, 0.5f);
+    test_copy_if(300001, 0.3f);
+    test_copy_if(300001, 0.f);
+    test_copy_if(0, 0.5f);
+    test_simple_copy_if();
+    test_timing();
+    std::cout << "NP_copy_if_parallel_test" << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,96 @@
+// name=NP_embed_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_embed_test.cc
+==================
+
+Checks that arrays saved with meta, names and labels embedded after the
+payload load the same as arrays saved with sidecars, via NP::Load with
+and without nodata, NP::LoadMapped, NP::LoadSlice and NPFold with
+envvar NP_EMBED, that no sidecar files are written and that arrays
+with sidecars still load. With numpy the embedded file loads as usual::
+
+    python -c "import numpy as np ; print(np.load('/tmp/NP_embed_test/embed/a.npy'))"
+
+**/
+
+#include "NPFold.h"
+
+const char* FOLD = "/tmp/NP_embed_test" ;
+
+NP* make_array()
+{
+    NP* a = NP::Make<float>(10, 4) ;
+    a->fillIndexFlat();
+    a->set_meta<int>("ni", 10) ;
+    a->set_meta<std::string>("note", "two words") ;
+    for(int i=0 ; i < 10 ; i++) a->names.push_back( "item" + std::to_string(i) ) ;
+    a->labels = new std::vector<std::string> { "x", "y", "z", "" } ;
+    return a ;
+}
+
+void compare(const NP* a, const NP* b, bool payload=true)
+{
+    assert( a->shape == b->shape );
+    if(payload) assert( NP::Memcmp(a, b) == 0 );
+    assert( a->meta == b->meta );
+    assert( a->names == b->names );
+    assert( (a->labels == nullptr) == (b->labels == nullptr) );
+    if(a->labels) assert( *a->labels == *b->labels );
+}
+
+bool exists(const std::string& path){ return NP::Exists(path.c_str()) ; }
+
+int main(int argc, char** argv)
+{
+    NP* a = make_array();
+
+    std::string spath = U::form_path(FOLD, "sidecar", "a.npy") ;
+    std::string epath = U::form_path(FOLD, "embed", "a.npy") ;
+    a->save(spath.c_str()) ;
+    a->save_embedded(epath.c_str()) ;
+
+    assert( exists(U::ChangeExt(spath.c_str(), ".npy", "_meta.txt")) );
+    assert( !exists(U::ChangeExt(epath.c_str(), ".npy", "_meta.txt")) );
+    assert( !exists(U::ChangeExt(epath.c_str(), ".npy", "_names.txt")) );
+    assert( !exists(U::ChangeExt(epath.c_str(), ".npy", "_labels.txt")) );
+
+    NP* s = NP::Load(spath.c_str()) ;     // old sidecar layout
+    NP* e = NP::Load(epath.c_str()) ;
+    compare( s, e );
+    assert( e->arr_bytes() == a->arr_bytes() );
+    assert( e->get_meta<int>("ni") == 10 );
+
+    NP* n = NP::Load(NP::PathWithNoDataPrefix(epath.c_str())) ;
+    assert( n->nodata );
+    compare( s, n, false );
+
+    NP* m = NP::LoadMapped(epath.c_str()) ;
+    compare( s, m );
+
+    NP* sl = NP::LoadSlice(epath.c_str(), 2, 5) ;
+    NP* ss = NP::LoadSlice(spath.c_str(), 2, 5) ;
+    compare( ss, sl );
+    assert( sl->names.size() == 3 && sl->names[0] == "item2" );
+
+    NP* z = NP::Make<int>(3) ;           // nothing to embed : trailer only
+    std::string zpath = U::form_path(FOLD, "embed", "z.npy") ;
+    z->save_embedded(zpath.c_str()) ;
+    NP* zl = NP::Load(zpath.c_str()) ;
+    compare( z, zl );
+    assert( zl->labels == nullptr && zl->meta.empty() );
+
+    NPFold* f = new NPFold ;
+    f->add("a", a) ;
+    f->add("z", z) ;
+    std::string fdir = U::form_path(FOLD, "fold") ;
+    setenv(NP::NP_EMBED, "1", 1) ;
+    f->save(fdir.c_str()) ;
+    unsetenv(NP::NP_EMBED) ;
+    assert( !exists(U::form_path(fdir.c_str(), "a_meta.txt")) );
+    NPFold* g = NPFold::Load(fdir.c_str()) ;
+    assert( NPFold::Compare(f, g) == 0 );
+    compare( s, g->get("a") );
+
+    std::cout << "NP_embed_test" << std::endl << e->descMeta() << std::endl ;
+    return 0 ;
+}
@@ -0,0 +1,152 @@
+// name=NP_interp_many_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_interp_many_test.cc
+========================
+
+Checks that NP::interp_many and NP::interp_multi give bitwise the same
+values as NP::interp for sorted and unsorted x, including x at domain
+values, beyond the domain edges and domains with repeated values,
+for 2D and 3D (itemized) property arrays and several value columns.
+Times per-call NP::interp against the batched forms with NP_THREADS threads.
+
+**/
+
+#include <chrono>
+#include <random>
+#include "NP.hh"
+
+std::mt19937_64 rng(1) ;
+
+template<typename T>
+NP* make_prop(int num_items, int ni, int nj)
+{
+    NP* a = num_items > 0 ? NP::Make<T>(num_items, ni, nj) : NP::Make<T>(ni, nj) ;
+    T* aa = a->values<T>() ;
+    std::uniform_real_distribution<T> u(0, 1) ;
+    for(int it=0 ; it < std::max(1, num_items) ; it++)
+    {
+        T* vv = aa + it*ni*nj ;
+        T d = T(1) ;
+        for(int i=0 ; i < ni ; i++)
+        {
+            if( i % 7 != 3 ) d += u(rng) ;    // some repeated domain values
+            vv[nj*i] = d ;
+            for(int j=1 ; j < nj ; j++) vv[nj*i+j] = u(rng)*j ;
+        }
+    }
+    return a ;
+}
+
+template<typename T>
+std::vector<T> make_x(const NP* a, int item, int n, bool sorted)
+{
+    int ni = a->shape[a->shape.size()-2] ;
+    int nj = a->shape[a->shape.size()-1] ;
+    const T* vv = a->cvalues<T>() + (item < 0 ? 0 : ni*nj*item) ;
+    std::uniform_real_distribution<T> u(vv[0] - 1, vv[nj*(ni-1)] + 1) ;
+    std::vector<T> x(n) ;
+    for(int i=0 ; i < n ; i++) x[i] = i % 5 == 0 ? vv[nj*(rng() % ni)] : u(rng) ;   // exactly on domain values
+    if(sorted) std::sort(x.begin(), x.end()) ;
+    return x ;
+}
+
+/**
+interp_column
+    NP::interp uses the last column, so the other columns are
+    checked against a (ni,2) copy of domain and column j
+**/
+
+template<typename T>
+T interp_column(const NP* a, int item, int j, T x)
+{
+    int ni = a->shape[a->shape.size()-2] ;
+    int nj = a->shape[a->shape.size()-1] ;
+    const T* vv = a->cvalues<T>() + (item < 0 ? 0 : ni*nj*item) ;
+    NP* b = NP::Make<T>(ni, 2) ;
+    T* bb = b->values<T>() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        bb[2*i+0] = vv[nj*i] ;
+        bb[2*i+1] = vv[nj*i+j] ;
+    }
+    T y = b->interp<T>(x) ;
+    delete b ;
+    return y ;
+}
+
+template<typename T>
+void test_compare(int num_items, int ni, int nj, int n)
+{
+    NP* a = make_prop<T>(num_items, ni, nj) ;
+    for(int item=( num_items > 0 ? 0 : -1 ) ; item < std::max(0, num_items) ; item++)
+    for(int sorted=0 ; sorted < 2 ; sorted++)
+    {
+        std::vector<T> x = make_x<T>(a, item, n, sorted) ;
+        std::vector<T> y(n) ;
+        a->interp_many<T>(x.data(), y.data(), n, item, 4 ) ;
+        for(int i=0 ; i < n ; i++)
+        {
+            T y0 = a->interp<T>(x[i], item) ;
+            assert( memcmp(&y0, &y[i], sizeof(T)) == 0 );
+        }
+
+        std::vector<int> jvals = { nj-1, 1, -1 } ;
+        if( nj > 2 ) jvals.push_back(2) ;
+        int nv = jvals.size() ;
+        std::vector<T> ym(n*nv) ;
+        a->interp_multi<T>(x.data(), ym.data(), n, jvals, item ) ;
+        for(int i=0 ; i < n ; i += 7 )
+        for(int v=0 ; v < nv ; v++)
+        {
+            int j = jvals[v] < 0 ? nj + jvals[v] : jvals[v] ;
+            T y0 = interp_column<T>(a, item, j, x[i]) ;
+            assert( memcmp(&y0, &ym[i*nv+v], sizeof(T)) == 0 );
+        }
+
+        std::vector<T> y1(nv) ;
+        a->interp_multi<T>(x[n/2], y1.data(), jvals, item ) ;
+        for(int v=0 ; v < nv ; v++) assert( y1[v] == ym[(n/2)*nv+v] );
+    }
+    std::cout << "test_compare " << a->sstr() << " " << a->dtype << std::endl ;
+}
+
+void test_timing()
+{
+    int n = U::GetEnvInt("NUM_X", 2000000) ;
+    NP* a = make_prop<double>(0, 500, 4) ;
+    std::vector<double> x = make_x<double>(a, -1, n, false) ;
+    std::vector<double> y0(n), y1(n), y2(3*n) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < n ; i++) y0[i] = a->interp<double>(x[i]) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    a->interp_many<double>(x.data(), y1.data(), n ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    a->interp_multi<double>(x.data(), y2.data(), n, {1, 2, 3} ) ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    std::sort(x.begin(), x.end()) ;
+    auto t4 = std::chrono::high_resolution_clock::now();
+    a->interp_many<double>(x.data(), y1.data(), n, -1, 1 ) ;
+    auto t5 = std::chrono::high_resolution_clock::now();
+
+    std::cout
+        << "test_timing n " << n << " " << a->sstr()
+        << " interp " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " interp_many " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << " interp_multi(3 columns) " << std::chrono::duration<double>(t3 - t2).count() << " s "
+        << " interp_many(sorted, 1 thread) " << std::chrono::duration<double>(t5 - t4).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_compare<double>(0, 2, 2, 100);
+    test_compare<double>(0, 50, 2, 3000);
+    test_compare<float>(0, 37, 4, 3000);
+    test_compare<double>(3, 200, 3, 1000);
+    test_compare<float>(0, 1000, 2, 200000);
+    test_timing();
+    std::cout << "NP_interp_many_test" << std::endl ;
+    return 0 ;
+}
@@ -9,13 +9,14 @@ int main(int argc, char** argv)
     a->fillIndexFlat(); 
 
     const char* start ; 
-    unsigned num_bytes ; 
+    size_t num_bytes ; 
 
     for(unsigned t=0 ; t < 3 ; t++)
     { 
         a->itembytes_(&start, num_bytes, 2, t); 
+        assert( num_bytes == 4 && start == a->bytes() + 2*16 + t*4 ); 
         std::cout << " t " << std::setw(5) << t << " : " ; 
-        for(unsigned i=0 ; i < num_bytes ; i++) std::cout << std::setw(5) << int(start[i]) << " " ; 
+        for(size_t i=0 ; i < num_bytes ; i++) std::cout << std::setw(5) << int(start[i]) << " " ; 
         std::cout << std::endl ; 
     }
 
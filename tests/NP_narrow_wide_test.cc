@@ -0,0 +1,162 @@
+// name=NP_narrow_wide_test ; mkdir -p /tmp/$name ; gcc $name.cc -std=c++11 -lstdc++ -O2 -pthread -I.. -o /tmp/$name/$name && /tmp/$name/$name
+/**
+NP_narrow_wide_test.cc
+========================
+
+Checks that NPU::_narrow NPU::_widen match scalar casts bit for bit
+including special values and unaligned ends, that NP::MakeNarrow keeps the
+Preserve_Last_Column_Integer_Annotation behaviour of the former scalar loop
+for any num_threads, and that NP::LoadNarrow NP::LoadWide and NP::MakeWithType
+give the same arrays as converting after NP::Load.
+Times MakeNarrow against a scalar loop.
+
+**/
+
+#include <chrono>
+#include <limits>
+#include <random>
+#include "NP.hh"
+
+std::mt19937_64 rng(13) ;
+
+void test_kernels()
+{
+    std::vector<double> d = {
+        0., -0., 1., -1.5, 1e-300, -1e-300, 1e300, -1e300, 3.4028235677973366e38, 1e-45, 1.4e-45, 7e-46,
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(), 0.1, 1./3., 16777217., 2.5e-39 } ;
+    std::uniform_real_distribution<double> u(-1e6, 1e6) ;
+    while( d.size() < 1003 ) d.push_back( u(rng) ) ;
+
+    for(int off=0 ; off < 5 ; off++)
+    for(size_t n=0 ; n + off <= d.size() ; n += 1 + n/3 )
+    {
+        std::vector<float> f(n + 1, -7.f) ;
+        NPU::_narrow( f.data(), d.data() + off, n );
+        for(size_t i=0 ; i < n ; i++)
+        {
+            float r = float(d[off+i]) ;
+            assert( memcmp(&r, &f[i], sizeof(float)) == 0 );
+        }
+        assert( f[n] == -7.f );
+
+        std::vector<double> w(n + 1, -7.) ;
+        NPU::_widen( w.data(), f.data(), n );
+        for(size_t i=0 ; i < n ; i++)
+        {
+            double r = double(f[i]) ;
+            assert( memcmp(&r, &w[i], sizeof(double)) == 0 );
+        }
+        assert( w[n] == -7. );
+    }
+    std::cout << "test_kernels" << std::endl ;
+}
+
+NP* make_double(int ni, int nj, int nk)
+{
+    NP* a = NP::Make<double>(ni, nj, nk) ;
+    double* aa = a->values<double>() ;
+    std::uniform_real_distribution<double> u(-100, 100) ;
+    for(int64_t i=0 ; i < a->size ; i++) aa[i] = u(rng) ;
+    return a ;
+}
+
+NP* narrow_scalar(const NP* a)    // the former NP::MakeNarrow loop
+{
+    NP* b = new NP("<f4") ;
+    NP::CopyMeta(b, a, false) ;
+    bool plcia = b->is_preserve_last_column_integer_annotation() ;
+    size_t nv = a->num_values() ;
+    size_t iv = a->num_itemvalues() ;
+    const double* aa = a->cvalues<double>() ;
+    float*        bb = b->values<float>() ;
+    for(size_t i=0 ; i < nv ; i++)
+    {
+        bb[i] = float(aa[i]) ;
+        if( plcia && ((i % iv) == iv - 1 ) ) bb[i] = NP::PreserveNarrowedDoubleInteger(aa[i]) ;
+    }
+    return b ;
+}
+
+void test_narrow_plcia()
+{
+    NP* a = make_double(100003, 3, 5) ;
+    NP* b0 = narrow_scalar(a) ;
+    NP* b1 = NP::MakeNarrow(a, 1) ;
+    assert( NP::Memcmp(b0, b1) == 0 );
+
+    a->set_preserve_last_column_integer_annotation() ;
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < a->shape[0] ; i++)
+    {
+        NP::UIF64 uif ;
+        uif.u = uint64_t(i) ;
+        aa[i*15+14] = uif.f ;     // integer bit pattern in last value of each item
+    }
+    NP* c0 = narrow_scalar(a) ;
+    for(int nt=0 ; nt <= 3 ; nt++)
+    {
+        NP* c = NP::MakeNarrow(a, nt) ;
+        assert( NP::Memcmp(c0, c) == 0 && c->is_preserve_last_column_integer_annotation() );
+        NP::UIF32 uif ;
+        uif.f = c->cvalues<float>()[12345*15+14] ;
+        assert( uif.u == 12345u );
+        delete c ;
+    }
+    std::cout << "test_narrow_plcia " << a->sstr() << std::endl ;
+}
+
+void test_load()
+{
+    NP* a = make_double(1001, 7, 1) ;
+    a->set_meta<std::string>("creator", "NP_narrow_wide_test") ;
+    a->save("/tmp/NP_narrow_wide_test/a.npy") ;
+    NP* n = NP::MakeNarrow(a) ;
+    n->save("/tmp/NP_narrow_wide_test/n.npy") ;
+
+    NP* ln = NP::LoadNarrow("/tmp/NP_narrow_wide_test/a.npy") ;
+    assert( NP::Memcmp(ln, n) == 0 && ln->is_mapped() == false && ln->get_meta<std::string>("creator", "") == "NP_narrow_wide_test" );
+
+    NP* lw = NP::LoadWide("/tmp/NP_narrow_wide_test/n.npy") ;
+    NP* w = NP::MakeWide(n) ;
+    assert( NP::Memcmp(lw, w) == 0 && lw->ebyte == 8 && lw->is_mapped() == false );
+
+    NP* lc = NP::LoadWide("/tmp/NP_narrow_wide_test/a.npy") ;
+    assert( NP::Memcmp(lc, a) == 0 );
+
+    NP* tf = NP::MakeWithType<float>(a) ;
+    NP* td = NP::MakeWithType<double>(n) ;
+    assert( NP::Memcmp(tf, n) == 0 && NP::Memcmp(td, w) == 0 );
+    std::cout << "test_load " << ln->sstr() << " " << lw->sstr() << std::endl ;
+}
+
+void test_timing()
+{
+    int ni = U::GetEnvInt("NUM_STEP", 2000000) ;
+    NP* a = make_double(ni, 4, 4) ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    NP* b0 = narrow_scalar(a) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    NP* b1 = NP::MakeNarrow(a) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    NP* w = NP::MakeWide(b1) ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    assert( NP::Memcmp(b0, b1) == 0 && w->ebyte == 8 );
+    std::cout
+        << "test_timing " << a->sstr()
+        << " scalar narrow " << std::chrono::duration<double>(t1 - t0).count() << " s "
+        << " MakeNarrow " << std::chrono::duration<double>(t2 - t1).count() << " s "
+        << " MakeWide " << std::chrono::duration<double>(t3 - t2).count() << " s "
+        << std::endl
+        ;
+}
+
+int main(int argc, char** argv)
+{
+    test_kernels();
+    test_narrow_plcia();
+    test_load();
+    test_timing();
+    std::cout << "NP_narrow_wide_test" << std::endl ;
+    return 0 ;
+}